@@ -1,19 +1,67 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <limits>
+#include <list>
+#include <random>
 #include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+
+#else
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define NSTD_AES_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#define NSTD_AES_TARGET
+#define NSTD_CLMUL_TARGET
+#else
+#include <cpuid.h>
+#define NSTD_AES_TARGET __attribute__((target("aes,sse4.1")))
+#define NSTD_CLMUL_TARGET __attribute__((target("pclmul,sse4.1")))
+#endif
+#include <immintrin.h>
+#endif
 
 namespace nstd
 {
 /**
- * @todo rework
- * 
  * @brief AES (Advanced Encryption Standard) encryption and decryption.
+ * 
+ * The state follows FIPS-197: byte i of a block is row i % 4, column i / 4.
  */
 namespace aes
 {
 
-const std::uint8_t SBOX[256] = {
+inline constexpr std::uint8_t SBOX[256] = {
     0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5,
     0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
     0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0,
@@ -48,7 +96,7 @@ const std::uint8_t SBOX[256] = {
     0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16
 }; // S-Box
 
-const std::uint8_t INV_SBOX[256] = {
+inline constexpr std::uint8_t INV_SBOX[256] = {
     0x52, 0x09, 0x6a, 0xd5, 0x30, 0x36, 0xa5, 0x38,
     0xbf, 0x40, 0xa3, 0x9e, 0x81, 0xf3, 0xd7, 0xfb,
     0x7c, 0xe3, 0x39, 0x82, 0x9b, 0x2f, 0xff, 0x87,
@@ -83,7 +131,7 @@ const std::uint8_t INV_SBOX[256] = {
     0xe1, 0x69, 0x14, 0x63, 0x55, 0x21, 0x0c, 0x7d
 }; // Inverted S-Box
 
-const std::uint8_t RCON[10] = {
+inline constexpr std::uint8_t RCON[10] = {
     0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1B, 0x36
 }; // Round constants
 
@@ -91,15 +139,15 @@ const std::uint8_t RCON[10] = {
  * @brief Adds the round key to the state matrix.
  * 
  * @param state The state matrix.
- * @param roundKey The round key to be added.
+ * @param roundKey The round key to be added (16 bytes, column by column).
  */
-void addRoundKey(std::uint8_t state[4][4], std::uint8_t roundKey[4][4]) noexcept
+inline void addRoundKey(std::uint8_t state[4][4], const std::uint8_t roundKey[16]) noexcept
 {
     for (int i = 0; i < 4; ++i)
     {
         for (int j = 0; j < 4; ++j)
         {
-            state[i][j] ^= roundKey[i][j];
+            state[i][j] ^= roundKey[j * 4 + i];
         }
     }
 }
@@ -109,7 +157,7 @@ void addRoundKey(std::uint8_t state[4][4], std::uint8_t roundKey[4][4]) noexcept
  * 
  * @param state The state matrix.
  */
-void subBytes(std::uint8_t state[4][4]) noexcept
+inline void subBytes(std::uint8_t state[4][4]) noexcept
 {
     for (int i = 0; i < 4; ++i)
     {
@@ -125,7 +173,7 @@ void subBytes(std::uint8_t state[4][4]) noexcept
  * 
  * @param state The state matrix.
  */
-void inverseSubBytes(std::uint8_t state[4][4]) noexcept
+inline void inverseSubBytes(std::uint8_t state[4][4]) noexcept
 {
     for (int i = 0; i < 4; ++i)
     {
@@ -141,18 +189,20 @@ void inverseSubBytes(std::uint8_t state[4][4]) noexcept
  * 
  * @param state The state matrix.
  */
-void shiftRows(std::uint8_t state[4][4]) noexcept
+inline void shiftRows(std::uint8_t state[4][4]) noexcept
 {
     std::uint8_t temp;
 
-    // Shift row 1 (1st row, index 0) - left shift by 1
+    // Row 0 - no change
+
+    // Row 1 - left shift by 1
     temp = state[1][0];
     state[1][0] = state[1][1];
     state[1][1] = state[1][2];
     state[1][2] = state[1][3];
     state[1][3] = temp;
 
-    // Shift row 2 (2nd row, index 1) - left shift by 2
+    // Row 2 - left shift by 2
     temp = state[2][0];
     state[2][0] = state[2][2];
     state[2][2] = temp;
@@ -160,12 +210,12 @@ void shiftRows(std::uint8_t state[4][4]) noexcept
     state[2][1] = state[2][3];
     state[2][3] = temp;
 
-    // Shift row 3 (3rd row, index 2) - left shift by 3
-    temp = state[3][0];
-    state[3][0] = state[3][1];
-    state[3][1] = state[3][2];
-    state[3][2] = state[3][3];
-    state[3][3] = temp;
+    // Row 3 - left shift by 3 (right shift by 1)
+    temp = state[3][3];
+    state[3][3] = state[3][2];
+    state[3][2] = state[3][1];
+    state[3][1] = state[3][0];
+    state[3][0] = temp;
 }
 
 /**
@@ -173,35 +223,56 @@ void shiftRows(std::uint8_t state[4][4]) noexcept
  * 
  * @param state The state matrix.
  */
-void inverseShiftRows(std::uint8_t state[4][4]) noexcept
+inline void inverseShiftRows(std::uint8_t state[4][4]) noexcept
 {
     std::uint8_t temp;
 
-    // Inverse shift row 1 - no change
+    // Row 0 - no change
 
-    // Inverse shift row 2 (2nd row, index 1) - right shift by 2
+    // Row 1 - right shift by 1
     temp = state[1][3];
     state[1][3] = state[1][2];
     state[1][2] = state[1][1];
     state[1][1] = state[1][0];
     state[1][0] = temp;
 
-    // Inverse shift row 3 (3rd row, index 2) - right shift by 3
+    // Row 2 - right shift by 2
     temp = state[2][0];
-    state[2][0] = state[2][3];
-    state[2][3] = state[2][2];
-    state[2][2] = state[2][1];
-    state[2][1] = temp;
+    state[2][0] = state[2][2];
+    state[2][2] = temp;
+    temp = state[2][1];
+    state[2][1] = state[2][3];
+    state[2][3] = temp;
 
-    // Inverse shift row 4 (4th row, index 3) - right shift by 1
-    temp = state[3][3];
-    state[3][3] = state[3][2];
-    state[3][2] = state[3][1];
-    state[3][1] = state[3][0];
-    state[3][0] = temp;
+    // Row 3 - right shift by 3 (left shift by 1)
+    temp = state[3][0];
+    state[3][0] = state[3][1];
+    state[3][1] = state[3][2];
+    state[3][2] = state[3][3];
+    state[3][3] = temp;
+}
+
+/**
+ * @brief Multiplies a byte by x (0x02) in GF(2^8).
+ * 
+ * @param a The byte.
+ * 
+ * @return The product.
+ */
+constexpr std::uint8_t xtime(std::uint8_t a) noexcept
+{
+    return static_cast<std::uint8_t>((a << 1) ^ ((a & 0x80) ? 0x1b : 0)); // x^8 + x^4 + x^3 + x + 1
 }
 
-std::uint8_t galoisMultiply(std::uint8_t a, std::uint8_t b)
+/**
+ * @brief Multiplies two bytes in GF(2^8).
+ * 
+ * @param a The first factor.
+ * @param b The second factor.
+ * 
+ * @return The product.
+ */
+constexpr std::uint8_t galoisMultiply(std::uint8_t a, std::uint8_t b) noexcept
 {
     std::uint8_t result = 0;
     while (b)
@@ -210,7 +281,7 @@ std::uint8_t galoisMultiply(std::uint8_t a, std::uint8_t b)
         {
             result ^= a;
         }
-        a = (a << 1) ^ ((a & 0x80) ? 0x1b : 0); // x^8 + x^4 + x^3 + x + 1
+        a = xtime(a);
         b >>= 1;
     }
     return result;
@@ -221,7 +292,7 @@ std::uint8_t galoisMultiply(std::uint8_t a, std::uint8_t b)
  * 
  * @param state The state matrix.
  */
-void mixColumns(std::uint8_t state[4][4]) noexcept
+inline void mixColumns(std::uint8_t state[4][4]) noexcept
 {
     for (int j = 0; j < 4; j++)
     {
@@ -231,10 +302,11 @@ void mixColumns(std::uint8_t state[4][4]) noexcept
             a[i] = state[i][j];
         }
 
-        state[0][j] = galoisMultiply(0x02, a[0]) ^ galoisMultiply(0x03, a[1]) ^ a[2] ^ a[3];
-        state[1][j] = a[0] ^ galoisMultiply(0x02, a[1]) ^ galoisMultiply(0x03, a[2]) ^ a[3];
-        state[2][j] = a[0] ^ a[1] ^ galoisMultiply(0x02, a[2]) ^ galoisMultiply(0x03, a[3]);
-        state[3][j] = galoisMultiply(0x03, a[0]) ^ a[1] ^ a[2] ^ galoisMultiply(0x02, a[3]);
+        // 2a ^ 3b = 2(a ^ b) ^ b
+        state[0][j] = xtime(a[0] ^ a[1]) ^ a[1] ^ a[2] ^ a[3];
+        state[1][j] = a[0] ^ xtime(a[1] ^ a[2]) ^ a[2] ^ a[3];
+        state[2][j] = a[0] ^ a[1] ^ xtime(a[2] ^ a[3]) ^ a[3];
+        state[3][j] = xtime(a[3] ^ a[0]) ^ a[0] ^ a[1] ^ a[2];
     }
 }
 
@@ -243,7 +315,7 @@ void mixColumns(std::uint8_t state[4][4]) noexcept
  * 
  * @param state The state matrix.
  */
-void inverseMixColumns(std::uint8_t state[4][4]) noexcept
+inline void inverseMixColumns(std::uint8_t state[4][4]) noexcept
 {
     for (int j = 0; j < 4; j++)
     {
@@ -261,169 +333,3673 @@ void inverseMixColumns(std::uint8_t state[4][4]) noexcept
 }
 
 /**
- * @brief Expands the key for use in the AES algorithm.
+ * @brief Expands the key for use in the AES algorithm (FIPS-197 5.2).
+ * 
+ * @tparam Rounds The number of rounds: 10, 12 or 14 for 128, 192 or 256-bit keys.
  * 
- * @param key The original encryption key.
- * @param roundKeys The array to hold the expanded keys.
+ * @param key The original encryption key (4 * (Rounds - 6) bytes).
+ * @param roundKeys The array to hold the expanded keys (16 * (Rounds + 1) bytes).
+ * @param subWord Applies the S-Box to the 4 bytes of a word in place.
  */
-void keyExpansion(const std::uint8_t* key, std::uint8_t* roundKeys) noexcept
+template <int Rounds = 10, typename SubWord>
+inline void keyExpansion(const std::uint8_t* key, std::uint8_t* roundKeys, SubWord&& subWord) noexcept
 {
-    for (int i = 0; i < 16; ++i)
+    static_assert(Rounds == 10 || Rounds == 12 || Rounds == 14, "AES has 10, 12 or 14 rounds");
+    constexpr int KEY_WORDS = Rounds - 6;
+    constexpr int WORDS = 4 * (Rounds + 1);
+
+    for (int i = 0; i < KEY_WORDS * 4; ++i)
     {
         roundKeys[i] = key[i];
     }
 
-    for (int i = 1; i <= 10; ++i)
+    for (int i = KEY_WORDS; i < WORDS; ++i)
     {
         std::uint8_t temp[4];
         for (int j = 0; j < 4; ++j)
         {
-            temp[j] = roundKeys[(i - 1) * 16 + j + 12];
+            temp[j] = roundKeys[(i - 1) * 4 + j];
         }
 
-        // Rotate the last 4 bytes
-        std::uint8_t t = temp[0];
-        for (int j = 0; j < 3; ++j)
+        if (i % KEY_WORDS == 0)
         {
-            temp[j] = temp[j + 1];
+            // Rotate, substitute and add the round constant
+            std::rotate(temp, temp + 1, temp + 4);
+            subWord(temp);
+            temp[0] ^= RCON[i / KEY_WORDS - 1];
+        }
+        else if (KEY_WORDS > 6 && i % KEY_WORDS == 4)
+        {
+            // AES-256 substitutes the middle word too
+            subWord(temp);
         }
 
-        temp[3] = t;
+        for (int j = 0; j < 4; ++j)
+        {
+            roundKeys[i * 4 + j] = roundKeys[(i - KEY_WORDS) * 4 + j] ^ temp[j];
+        }
+    }
+}
 
+/**
+ * @brief Expands the key for use in the AES algorithm (FIPS-197 5.2), substituting through the S-Box table.
+ * 
+ * @tparam Rounds The number of rounds: 10, 12 or 14 for 128, 192 or 256-bit keys.
+ * 
+ * @param key The original encryption key (4 * (Rounds - 6) bytes).
+ * @param roundKeys The array to hold the expanded keys (16 * (Rounds + 1) bytes).
+ */
+template <int Rounds = 10>
+inline void keyExpansion(const std::uint8_t* key, std::uint8_t* roundKeys) noexcept
+{
+    keyExpansion<Rounds>(key, roundKeys, [](std::uint8_t word[4])
+    {
         for (int j = 0; j < 4; ++j)
         {
-            temp[j] = SBOX[temp[j]];
+            word[j] = SBOX[word[j]];
+        }
+    });
+}
+
+/**
+ * @brief Block cipher implementations a key schedule can run on.
+ */
+enum class Backend
+{
+    Reference, // Byte-wise rounds over a 4x4 state, one step at a time.
+    Table,     // 32-bit columns with combined SubBytes/ShiftRows/MixColumns lookups.
+    Hardware,  // AES-NI instructions, 8 blocks in flight; falls back to Bitsliced without them.
+    Bitsliced, // Logic operations on 8 blocks at once; no secret-dependent memory access, key expansion included.
+    Automatic  // Hardware when the CPU supports it, Bitsliced otherwise.
+};
+
+/**
+ * @brief Which directions a key schedule is prepared for.
+ */
+enum class KeyUsage
+{
+    EncryptDecrypt, // Cipher and equivalent inverse cipher round keys.
+    EncryptOnly     // Cipher round keys only, for modes that never decrypt a block (CTR, GCM, XTS tweaks).
+};
+
+/**
+ * @brief Reads a feature bit from ECX of CPUID leaf 1, querying the CPU only once.
+ * 
+ * @param bit The bit index.
+ */
+inline bool cpuFeature(int bit) noexcept
+{
+#ifdef NSTD_AES_X86
+    static const unsigned ecx = []
+    {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 1);
+        return static_cast<unsigned>(info[2]);
+#else
+        unsigned eax, ebx, ecx, edx;
+        if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        {
+            return 0u;
         }
+        return ecx;
+#endif
+    }();
+    return (ecx >> bit) & 1;
+#else
+    (void)bit;
+    return false;
+#endif
+}
 
-        temp[0] ^= RCON[i - 1];
+/**
+ * @brief Checks once whether the CPU has the AES-NI and SSE4.1 instructions.
+ */
+inline bool hardwareSupported() noexcept
+{
+    return cpuFeature(25) && cpuFeature(19); // AES, SSE4.1
+}
 
-        // Generate the round key for this round
-        roundKeys[i * 16 + 0] = roundKeys[(i - 1) * 16 + 0] ^ temp[0];
-        roundKeys[i * 16 + 1] = roundKeys[(i - 1) * 16 + 1] ^ temp[1];
-        roundKeys[i * 16 + 2] = roundKeys[(i - 1) * 16 + 2] ^ temp[2];
-        roundKeys[i * 16 + 3] = roundKeys[(i - 1) * 16 + 3] ^ temp[3];
+/**
+ * @brief Checks once whether the CPU has the PCLMULQDQ and SSE4.1 instructions.
+ */
+inline bool carrylessSupported() noexcept
+{
+    return cpuFeature(1) && cpuFeature(19); // PCLMULQDQ, SSE4.1
+}
 
-        // Fill in the rest of the round keys
-        for (int j = 1; j < 4; ++j)
+/**
+ * @brief Builds the four encryption T-tables.
+ * 
+ * Column words keep row r in bits 8r..8r+7. Table t maps a byte in row t to its
+ * column after SubBytes and MixColumns, so each table is the previous one rotated by a byte.
+ */
+constexpr std::array<std::array<std::uint32_t, 256>, 4> makeEncryptTables() noexcept
+{
+    std::array<std::array<std::uint32_t, 256>, 4> tables{};
+    for (int x = 0; x < 256; ++x)
+    {
+        std::uint32_t s = SBOX[x];
+        std::uint32_t word = galoisMultiply(0x02, SBOX[x]) | (s << 8) | (s << 16) | (std::uint32_t(galoisMultiply(0x03, SBOX[x])) << 24);
+        for (int t = 0; t < 4; ++t)
         {
-            for (int k = 0; k < 4; ++k)
-            {
-                roundKeys[i * 16 + j * 4 + k] = roundKeys[i * 16 + (j - 1) * 4 + k] ^ roundKeys[i * 16 + j * 4 + k - 4];
-            }
+            tables[t][x] = word;
+            word = (word << 8) | (word >> 24);
         }
     }
+    return tables;
 }
 
 /**
- * @brief Encrypts a 128-bit block of data using the provided key.
- * 
- * @param input The input block (16 bytes) to be encrypted.
- * @param key The encryption key (16 bytes).
- * @param output The output block (16 bytes) that will hold the encrypted data.
+ * @brief Builds the four decryption T-tables (inverse S-Box followed by InvMixColumns).
+ */
+constexpr std::array<std::array<std::uint32_t, 256>, 4> makeDecryptTables() noexcept
+{
+    std::array<std::array<std::uint32_t, 256>, 4> tables{};
+    for (int x = 0; x < 256; ++x)
+    {
+        std::uint8_t s = INV_SBOX[x];
+        std::uint32_t word = galoisMultiply(0x0e, s) | (std::uint32_t(galoisMultiply(0x09, s)) << 8) |
+                             (std::uint32_t(galoisMultiply(0x0d, s)) << 16) | (std::uint32_t(galoisMultiply(0x0b, s)) << 24);
+        for (int t = 0; t < 4; ++t)
+        {
+            tables[t][x] = word;
+            word = (word << 8) | (word >> 24);
+        }
+    }
+    return tables;
+}
+
+inline constexpr auto ENCRYPT_TABLES = makeEncryptTables(); // 4 KB of encryption T-tables
+inline constexpr auto DECRYPT_TABLES = makeDecryptTables(); // 4 KB of decryption T-tables
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NSTD_AES_SSE2
+#endif
+
+/**
+ * @brief One bit plane of 8 blocks processed together by the bitsliced engine.
  * 
- * @throws std::runtime_error if the input or key size is invalid.
+ * Byte 4r + c of the plane holds one bit of state byte (r, c) from each of the
+ * 8 blocks, bit b from block b. Rows sit in separate 32-bit lanes, so ShiftRows is
+ * a per-lane rotation and the row offsets of MixColumns are lane rotations.
  */
-void encrypt(const std::uint8_t input[16], const std::uint8_t key[16], std::uint8_t output[16])
+class bit_plane
 {
-    if (!input || !key || !output)
+public:
+#ifdef NSTD_AES_SSE2
+    __m128i m_value; // Rows 0..3 in lanes 0..3.
+
+    static inline bit_plane load(const std::uint8_t bytes[16]) noexcept { return { _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes)) }; }
+    inline void store(std::uint8_t bytes[16]) const noexcept { _mm_storeu_si128(reinterpret_cast<__m128i*>(bytes), m_value); }
+
+    friend inline bit_plane operator^(bit_plane a, bit_plane b) noexcept { return { _mm_xor_si128(a.m_value, b.m_value) }; }
+    friend inline bit_plane operator&(bit_plane a, bit_plane b) noexcept { return { _mm_and_si128(a.m_value, b.m_value) }; }
+    friend inline bit_plane operator~(bit_plane a) noexcept { return { _mm_xor_si128(a.m_value, _mm_set1_epi32(-1)) }; }
+
+    // Row r takes row r + 1 (mod 4)
+    inline bit_plane rotateRows1() const noexcept { return { _mm_shuffle_epi32(m_value, _MM_SHUFFLE(0, 3, 2, 1)) }; }
+
+    // Row r takes row r + 2 (mod 4)
+    inline bit_plane rotateRows2() const noexcept { return { _mm_shuffle_epi32(m_value, _MM_SHUFFLE(1, 0, 3, 2)) }; }
+
+    // Row r rotates right by 8r bits (Right) or left by 8r bits
+    template <bool Right>
+    inline bit_plane rotateLanes() const noexcept
     {
-        throw std::runtime_error("Input, key, and output must not be null.");
+        const __m128i x = m_value;
+        __m128i r8 = _mm_or_si128(_mm_srli_epi32(x, 8), _mm_slli_epi32(x, 24));
+        __m128i r16 = _mm_or_si128(_mm_srli_epi32(x, 16), _mm_slli_epi32(x, 16));
+        __m128i r24 = _mm_or_si128(_mm_srli_epi32(x, 24), _mm_slli_epi32(x, 8));
+        __m128i one = Right ? r8 : r24;
+        __m128i three = Right ? r24 : r8;
+        return { _mm_or_si128(_mm_or_si128(_mm_and_si128(x, _mm_set_epi32(0, 0, 0, -1)), _mm_and_si128(one, _mm_set_epi32(0, 0, -1, 0))),
+                              _mm_or_si128(_mm_and_si128(r16, _mm_set_epi32(0, -1, 0, 0)), _mm_and_si128(three, _mm_set_epi32(-1, 0, 0, 0)))) };
     }
+#else
+    std::uint64_t m_low;  // Rows 0 and 1.
+    std::uint64_t m_high; // Rows 2 and 3.
 
-    std::uint8_t state[4][4];
-    std::uint8_t roundKeys[176];
+    static inline bit_plane load(const std::uint8_t bytes[16]) noexcept
+    {
+        bit_plane plane{ 0, 0 };
+        for (int i = 7; i >= 0; --i)
+        {
+            plane.m_low = (plane.m_low << 8) | bytes[i];
+            plane.m_high = (plane.m_high << 8) | bytes[i + 8];
+        }
+        return plane;
+    }
 
-    // Copy input to state matrix
-    for (int i = 0; i < 4; i++)
+    inline void store(std::uint8_t bytes[16]) const noexcept
     {
-        for (int j = 0; j < 4; j++)
+        for (int i = 0; i < 8; ++i)
         {
-            state[i][j] = input[i * 4 + j]; // ohhh
+            bytes[i] = static_cast<std::uint8_t>(m_low >> (8 * i));
+            bytes[i + 8] = static_cast<std::uint8_t>(m_high >> (8 * i));
         }
     }
 
-    keyExpansion(key, roundKeys);
+    friend inline bit_plane operator^(bit_plane a, bit_plane b) noexcept { return { a.m_low ^ b.m_low, a.m_high ^ b.m_high }; }
+    friend inline bit_plane operator&(bit_plane a, bit_plane b) noexcept { return { a.m_low & b.m_low, a.m_high & b.m_high }; }
+    friend inline bit_plane operator~(bit_plane a) noexcept { return { ~a.m_low, ~a.m_high }; }
 
-    // Initial round
-    addRoundKey(state, reinterpret_cast<std::uint8_t(*)[4]>(roundKeys));
+    inline bit_plane rotateRows1() const noexcept { return { (m_low >> 32) | (m_high << 32), (m_high >> 32) | (m_low << 32) }; }
+    inline bit_plane rotateRows2() const noexcept { return { m_high, m_low }; }
 
-    // Main rounds
-    for (int round = 1; round <= 9; ++round)
+    template <bool Right>
+    inline bit_plane rotateLanes() const noexcept
     {
-        subBytes(state);
-        shiftRows(state);
-        mixColumns(state);
-        addRoundKey(state, reinterpret_cast<std::uint8_t(*)[4]>(roundKeys + round * 16));
+        auto rotate = [](std::uint64_t lane, int bits) -> std::uint64_t
+        {
+            std::uint32_t x = static_cast<std::uint32_t>(lane);
+            bits = Right ? bits : (32 - bits) % 32;
+            return bits ? ((x >> bits) | (x << (32 - bits))) : x;
+        };
+        return { rotate(m_low, 0) | (rotate(m_low >> 32, 8) << 32), rotate(m_high, 16) | (rotate(m_high >> 32, 24) << 32) };
     }
+#endif
+}; // class bit_plane
+
+/**
+ * @brief Transposes an 8x8 bit matrix stored as 8 bytes (bit 8i + j <-> bit 8j + i).
+ */
+constexpr std::uint64_t transpose8(std::uint64_t x) noexcept
+{
+    std::uint64_t t = (x ^ (x >> 7)) & 0x00aa00aa00aa00aaull;
+    x ^= t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000cccc0000ccccull;
+    x ^= t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000f0f0f0f0ull;
+    x ^= t ^ (t << 28);
+    return x;
+}
+
+/**
+ * @brief Converts up to 8 blocks into bit planes; missing blocks read as zero.
+ * 
+ * @param input The blocks.
+ * @param blocks The number of blocks, at most 8.
+ * @param q The 8 planes, bit k of every byte in q[k].
+ */
+inline void bitslice(const std::uint8_t* input, std::size_t blocks, bit_plane q[8]) noexcept
+{
+    alignas(16) std::uint8_t planes[8][16];
+    for (int i = 0; i < 16; ++i)
+    {
+        std::uint64_t x = 0;
+        for (std::size_t b = 0; b < blocks; ++b)
+        {
+            x |= std::uint64_t(input[b * 16 + i]) << (8 * b);
+        }
+        x = transpose8(x);
 
-    // Final round
-    subBytes(state);
-    shiftRows(state);
-    addRoundKey(state, reinterpret_cast<std::uint8_t(*)[4]>(roundKeys + 10 * 16));
+        int position = 4 * (i % 4) + i / 4;
+        for (int k = 0; k < 8; ++k)
+        {
+            planes[k][position] = static_cast<std::uint8_t>(x >> (8 * k));
+        }
+    }
+    for (int k = 0; k < 8; ++k)
+    {
+        q[k] = bit_plane::load(planes[k]);
+    }
+}
 
-    // Copy state back to output
-    for (int i = 0; i < 4; i++)
+/**
+ * @brief Converts bit planes back into blocks.
+ * 
+ * @param q The 8 planes.
+ * @param output The blocks.
+ * @param blocks The number of blocks to write, at most 8.
+ */
+inline void unbitslice(const bit_plane q[8], std::uint8_t* output, std::size_t blocks) noexcept
+{
+    alignas(16) std::uint8_t planes[8][16];
+    for (int k = 0; k < 8; ++k)
     {
-        for (int j = 0; j < 4; j++)
+        q[k].store(planes[k]);
+    }
+    for (int i = 0; i < 16; ++i)
+    {
+        int position = 4 * (i % 4) + i / 4;
+        std::uint64_t x = 0;
+        for (int k = 0; k < 8; ++k)
+        {
+            x |= std::uint64_t(planes[k][position]) << (8 * k);
+        }
+        x = transpose8(x);
+
+        for (std::size_t b = 0; b < blocks; ++b)
         {
-            output[i * 4 + j] = state[j][i];
+            output[b * 16 + i] = static_cast<std::uint8_t>(x >> (8 * b));
         }
     }
 }
 
 /**
- * @brief Decrypts a 128-bit block of data using the provided key.
+ * @brief Applies the S-Box to every byte of bitsliced state using logic gates only.
  * 
- * @param input The input block (16 bytes) to be decrypted.
- * @param key The decryption key (16 bytes).
- * @param output The output block (16 bytes) that will hold the decrypted data.
+ * The circuit of Boyar and Peralta: a linear layer, 32 AND gates for the inversion
+ * in GF(2^8), and a linear layer that also adds the affine constant.
  * 
- * @throws std::runtime_error if the input or key size is invalid.
+ * @param q The 8 planes.
  */
-void decrypt(const std::uint8_t input[16], const std::uint8_t key[16], std::uint8_t output[16])
+inline void bitslicedSubBytes(bit_plane q[8]) noexcept
 {
-    if (!input || !key || !output)
+    bit_plane x0 = q[7], x1 = q[6], x2 = q[5], x3 = q[4], x4 = q[3], x5 = q[2], x6 = q[1], x7 = q[0];
+
+    // Top linear transformation
+    bit_plane y14 = x3 ^ x5;
+    bit_plane y13 = x0 ^ x6;
+    bit_plane y9 = x0 ^ x3;
+    bit_plane y8 = x0 ^ x5;
+    bit_plane t0 = x1 ^ x2;
+    bit_plane y1 = t0 ^ x7;
+    bit_plane y4 = y1 ^ x3;
+    bit_plane y12 = y13 ^ y14;
+    bit_plane y2 = y1 ^ x0;
+    bit_plane y5 = y1 ^ x6;
+    bit_plane y3 = y5 ^ y8;
+    bit_plane t1 = x4 ^ y12;
+    bit_plane y15 = t1 ^ x5;
+    bit_plane y20 = t1 ^ x1;
+    bit_plane y6 = y15 ^ x7;
+    bit_plane y10 = y15 ^ t0;
+    bit_plane y11 = y20 ^ y9;
+    bit_plane y7 = x7 ^ y11;
+    bit_plane y17 = y10 ^ y11;
+    bit_plane y19 = y10 ^ y8;
+    bit_plane y16 = t0 ^ y11;
+    bit_plane y21 = y13 ^ y16;
+    bit_plane y18 = x0 ^ y16;
+
+    // Non-linear section
+    bit_plane t2 = y12 & y15;
+    bit_plane t3 = y3 & y6;
+    bit_plane t4 = t3 ^ t2;
+    bit_plane t5 = y4 & x7;
+    bit_plane t6 = t5 ^ t2;
+    bit_plane t7 = y13 & y16;
+    bit_plane t8 = y5 & y1;
+    bit_plane t9 = t8 ^ t7;
+    bit_plane t10 = y2 & y7;
+    bit_plane t11 = t10 ^ t7;
+    bit_plane t12 = y9 & y11;
+    bit_plane t13 = y14 & y17;
+    bit_plane t14 = t13 ^ t12;
+    bit_plane t15 = y8 & y10;
+    bit_plane t16 = t15 ^ t12;
+    bit_plane t17 = t4 ^ t14;
+    bit_plane t18 = t6 ^ t16;
+    bit_plane t19 = t9 ^ t14;
+    bit_plane t20 = t11 ^ t16;
+    bit_plane t21 = t17 ^ y20;
+    bit_plane t22 = t18 ^ y19;
+    bit_plane t23 = t19 ^ y21;
+    bit_plane t24 = t20 ^ y18;
+
+    bit_plane t25 = t21 ^ t22;
+    bit_plane t26 = t21 & t23;
+    bit_plane t27 = t24 ^ t26;
+    bit_plane t28 = t25 & t27;
+    bit_plane t29 = t28 ^ t22;
+    bit_plane t30 = t23 ^ t24;
+    bit_plane t31 = t22 ^ t26;
+    bit_plane t32 = t31 & t30;
+    bit_plane t33 = t32 ^ t24;
+    bit_plane t34 = t23 ^ t33;
+    bit_plane t35 = t27 ^ t33;
+    bit_plane t36 = t24 & t35;
+    bit_plane t37 = t36 ^ t34;
+    bit_plane t38 = t27 ^ t36;
+    bit_plane t39 = t29 & t38;
+    bit_plane t40 = t25 ^ t39;
+
+    bit_plane t41 = t40 ^ t37;
+    bit_plane t42 = t29 ^ t33;
+    bit_plane t43 = t29 ^ t40;
+    bit_plane t44 = t33 ^ t37;
+    bit_plane t45 = t42 ^ t41;
+    bit_plane z0 = t44 & y15;
+    bit_plane z1 = t37 & y6;
+    bit_plane z2 = t33 & x7;
+    bit_plane z3 = t43 & y16;
+    bit_plane z4 = t40 & y1;
+    bit_plane z5 = t29 & y7;
+    bit_plane z6 = t42 & y11;
+    bit_plane z7 = t45 & y17;
+    bit_plane z8 = t41 & y10;
+    bit_plane z9 = t44 & y12;
+    bit_plane z10 = t37 & y3;
+    bit_plane z11 = t33 & y4;
+    bit_plane z12 = t43 & y13;
+    bit_plane z13 = t40 & y5;
+    bit_plane z14 = t29 & y2;
+    bit_plane z15 = t42 & y9;
+    bit_plane z16 = t45 & y14;
+    bit_plane z17 = t41 & y8;
+
+    // Bottom linear transformation
+    bit_plane t46 = z15 ^ z16;
+    bit_plane t47 = z10 ^ z11;
+    bit_plane t48 = z5 ^ z13;
+    bit_plane t49 = z9 ^ z10;
+    bit_plane t50 = z2 ^ z12;
+    bit_plane t51 = z2 ^ z5;
+    bit_plane t52 = z7 ^ z8;
+    bit_plane t53 = z0 ^ z3;
+    bit_plane t54 = z6 ^ z7;
+    bit_plane t55 = z16 ^ z17;
+    bit_plane t56 = z12 ^ t48;
+    bit_plane t57 = t50 ^ t53;
+    bit_plane t58 = z4 ^ t46;
+    bit_plane t59 = z3 ^ t54;
+    bit_plane t60 = t46 ^ t57;
+    bit_plane t61 = z14 ^ t57;
+    bit_plane t62 = t52 ^ t58;
+    bit_plane t63 = t49 ^ t58;
+    bit_plane t64 = z4 ^ t59;
+    bit_plane t65 = t61 ^ t62;
+    bit_plane t66 = z1 ^ t63;
+    bit_plane s0 = t59 ^ t63;
+    bit_plane s6 = t56 ^ ~t62;
+    bit_plane s7 = t48 ^ ~t60;
+    bit_plane t67 = t64 ^ t65;
+    bit_plane s3 = t53 ^ t66;
+    bit_plane s4 = t51 ^ t66;
+    bit_plane s5 = t47 ^ t65;
+    bit_plane s1 = t64 ^ ~s3;
+    bit_plane s2 = t55 ^ ~t67;
+
+    q[7] = s0;
+    q[6] = s1;
+    q[5] = s2;
+    q[4] = s3;
+    q[3] = s4;
+    q[2] = s5;
+    q[1] = s6;
+    q[0] = s7;
+}
+
+/**
+ * @brief Applies the S-Box to the 4 bytes of a key schedule word through the bitsliced circuit.
+ * 
+ * @param word The word, substituted in place.
+ */
+inline void bitslicedSubWord(std::uint8_t word[4]) noexcept
+{
+    alignas(16) std::uint8_t block[16] = {};
+    std::memcpy(block, word, 4);
+    bit_plane q[8];
+    bitslice(block, 1, q);
+    bitslicedSubBytes(q);
+    unbitslice(q, block, 1);
+    std::memcpy(word, block, 4);
+}
+
+/**
+ * @brief Applies the inverse affine map of the S-Box, x -> rotl(x, 1) ^ rotl(x, 3) ^ rotl(x, 6) ^ 0x05.
+ */
+inline void bitslicedInverseAffine(bit_plane q[8]) noexcept
+{
+    // The constant 0x05 is folded in by complementing inputs that reach bits 0 and 2 an odd number of times
+    bit_plane q0 = ~q[0], q1 = ~q[1], q2 = q[2], q3 = q[3], q4 = q[4], q5 = ~q[5], q6 = ~q[6], q7 = q[7];
+    q[7] = q1 ^ q4 ^ q6;
+    q[6] = q0 ^ q3 ^ q5;
+    q[5] = q7 ^ q2 ^ q4;
+    q[4] = q6 ^ q1 ^ q3;
+    q[3] = q5 ^ q0 ^ q2;
+    q[2] = q4 ^ q7 ^ q1;
+    q[1] = q3 ^ q6 ^ q0;
+    q[0] = q2 ^ q5 ^ q7;
+}
+
+/**
+ * @brief Applies the inverse S-Box to bitsliced state.
+ * 
+ * With S = A o inv, inv o A^-1 = A^-1 o S o A^-1, so the forward circuit is reused.
+ * 
+ * @param q The 8 planes.
+ */
+inline void bitslicedInverseSubBytes(bit_plane q[8]) noexcept
+{
+    bitslicedInverseAffine(q);
+    bitslicedSubBytes(q);
+    bitslicedInverseAffine(q);
+}
+
+/**
+ * @brief Multiplies every byte of bitsliced state by x (0x02).
+ */
+inline void bitslicedXtime(const bit_plane a[8], bit_plane out[8]) noexcept
+{
+    out[0] = a[7];
+    out[1] = a[0] ^ a[7];
+    out[2] = a[1];
+    out[3] = a[2] ^ a[7];
+    out[4] = a[3] ^ a[7];
+    out[5] = a[4];
+    out[6] = a[5];
+    out[7] = a[6];
+}
+
+/**
+ * @brief Applies MixColumns to bitsliced state.
+ * 
+ * With b = a ^ a[r + 1], each output row is 2b ^ a[r + 1] ^ b[r + 2].
+ * 
+ * @param q The 8 planes.
+ */
+inline void bitslicedMixColumns(bit_plane q[8]) noexcept
+{
+    bit_plane next[8], b[8], doubled[8];
+    for (int k = 0; k < 8; ++k)
     {
-        throw std::runtime_error("Input, key, and output must not be null.");
+        next[k] = q[k].rotateRows1();
+        b[k] = q[k] ^ next[k];
     }
+    bitslicedXtime(b, doubled);
+    for (int k = 0; k < 8; ++k)
+    {
+        q[k] = doubled[k] ^ next[k] ^ b[k].rotateRows2();
+    }
+}
 
-    std::uint8_t state[4][4];
-    std::uint8_t roundKeys[176];
+/**
+ * @brief Applies InvMixColumns to bitsliced state.
+ * 
+ * InvMixColumns is MixColumns after multiplying each column by 04x^2 + 05, that is
+ * a[r] ^= 4 (a[r] ^ a[r + 2]).
+ * 
+ * @param q The 8 planes.
+ */
+inline void bitslicedInverseMixColumns(bit_plane q[8]) noexcept
+{
+    bit_plane u[8], twice[8], four[8];
+    for (int k = 0; k < 8; ++k)
+    {
+        u[k] = q[k] ^ q[k].rotateRows2();
+    }
+    bitslicedXtime(u, twice);
+    bitslicedXtime(twice, four);
+    for (int k = 0; k < 8; ++k)
+    {
+        q[k] = q[k] ^ four[k];
+    }
+    bitslicedMixColumns(q);
+}
 
-    for (int i = 0; i < 4; i++)
+/**
+ * @brief Overwrites secret bytes with zeros; the barrier keeps the compiler from dropping it as a dead store.
+ * 
+ * @param data The bytes.
+ * @param size The number of bytes.
+ */
+inline void secureZero(void* data, std::size_t size) noexcept
+{
+    if (size == 0)
     {
-        for (int j = 0; j < 4; j++)
-        {
-            state[j][i] = input[i * 4 + j];
-        }
+        return; // data may be null
     }
+    std::memset(data, 0, size);
+#ifdef _MSC_VER
+    _ReadWriteBarrier();
+#else
+    __asm__ __volatile__("" : : "r"(data) : "memory");
+#endif
+}
 
-    keyExpansion(key, roundKeys);
-    addRoundKey(state, reinterpret_cast<std::uint8_t(*)[4]>(roundKeys + 10 * 16));
+/**
+ * @brief An AES key expanded once for any number of blocks.
+ * 
+ * Holds the encryption schedule and the schedule of the equivalent inverse cipher
+ * (FIPS-197 5.3.5), whose middle round keys are passed through InvMixColumns so
+ * decryption runs the same round structure as encryption. The round count is a
+ * template parameter, so every round loop has a constant trip count and unrolls.
+ * The round keys are wiped when a schedule is destroyed or overwritten.
+ * 
+ * @tparam Rounds The number of rounds: 10, 12 or 14 for AES-128, AES-192 or AES-256.
+ */
+template <int Rounds>
+class basic_key_schedule
+{
+    static_assert(Rounds == 10 || Rounds == 12 || Rounds == 14, "AES has 10, 12 or 14 rounds");
+
+public:
+    static constexpr int ROUNDS = Rounds;                  // Number of rounds.
+    static constexpr std::size_t BLOCK_SIZE = 16;          // Block size in bytes.
+    static constexpr std::size_t KEY_SIZE = 4 * (Rounds - 6); // Key size in bytes.
+    static constexpr std::size_t SCHEDULE_SIZE = 16 * (ROUNDS + 1); // Size of one expanded schedule in bytes.
 
-    // Main rounds
-    for (int round = 9; round >= 1; --round)
+    /**
+     * @brief Expands a key.
+     * 
+     * @param key The encryption key (KEY_SIZE bytes).
+     * @param backend The block cipher implementation to run on.
+     * @param usage Whether to prepare the inverse cipher too; EncryptOnly skips that half of the setup.
+     * 
+     * @throws std::bad_alloc if the bit planes of a Bitsliced schedule cannot be allocated.
+     */
+    explicit basic_key_schedule(const std::uint8_t* key, Backend backend = Backend::Automatic, KeyUsage usage = KeyUsage::EncryptDecrypt)
+        : m_backend(backend), m_usage(usage)
     {
-        inverseShiftRows(state);
-        inverseSubBytes(state);
-        addRoundKey(state, reinterpret_cast<std::uint8_t(*)[4]>(roundKeys + round * 16));
-        inverseMixColumns(state);
+        if (m_backend == Backend::Automatic || (m_backend == Backend::Hardware && !hardwareSupported()))
+        {
+            m_backend = hardwareSupported() ? Backend::Hardware : Backend::Bitsliced;
+        }
+
+        if (m_backend == Backend::Bitsliced)
+        {
+            keyExpansion<Rounds>(key, m_encryptKeys, bitslicedSubWord); // no key-dependent table lookups
+        }
+        else
+        {
+            keyExpansion<Rounds>(key, m_encryptKeys);
+        }
+
+        for (std::size_t i = 0; i < SCHEDULE_SIZE / 4; ++i)
+        {
+            m_encryptWords[i] = loadWord(m_encryptKeys + i * 4);
+        }
+
+        // Equivalent inverse cipher: reversed round order, InvMixColumns applied to the middle keys
+        const bool inverse = usage == KeyUsage::EncryptDecrypt;
+        for (int round = 0; inverse && round <= ROUNDS; ++round)
+        {
+            const std::uint8_t* source = m_encryptKeys + (ROUNDS - round) * 16;
+            std::uint8_t* target = m_decryptKeys + round * 16;
+            if (round == 0 || round == ROUNDS)
+            {
+                std::memcpy(target, source, 16);
+            }
+            else if (m_backend == Backend::Bitsliced)
+            {
+                // Logic operations only, like the rest of the bitsliced key setup
+                bit_plane q[8];
+                bitslice(source, 1, q);
+                bitslicedInverseMixColumns(q);
+                unbitslice(q, target, 1);
+                secureZero(q, sizeof(q));
+            }
+            else
+            {
+                // DECRYPT_TABLES[r][SBOX[b]] is the InvMixColumns contribution of byte b in row r
+                for (int c = 0; c < 4; ++c)
+                {
+                    std::uint32_t word = m_encryptWords[(ROUNDS - round) * 4 + c];
+                    word = DECRYPT_TABLES[0][SBOX[word & 0xff]] ^ DECRYPT_TABLES[1][SBOX[(word >> 8) & 0xff]] ^
+                           DECRYPT_TABLES[2][SBOX[(word >> 16) & 0xff]] ^ DECRYPT_TABLES[3][SBOX[word >> 24]];
+                    storeWord(word, target + c * 4);
+                }
+            }
+        }
+        for (std::size_t i = 0; inverse && i < SCHEDULE_SIZE / 4; ++i)
+        {
+            m_decryptWords[i] = loadWord(m_decryptKeys + i * 4);
+        }
+
+        if (m_backend == Backend::Bitsliced)
+        {
+            // Every bit of a round key becomes an all-zero or all-one byte, the same for all 8 blocks
+            m_planes.resize(inverse ? 2 * PLANES : PLANES);
+            for (std::size_t plane = 0; plane < m_planes.size(); ++plane)
+            {
+                const std::uint8_t* roundKey = (plane < PLANES ? m_encryptKeys : m_decryptKeys) + plane % PLANES / 8 * 16;
+                int k = static_cast<int>(plane % 8);
+                alignas(16) std::uint8_t bits[16];
+                for (int i = 0; i < 16; ++i)
+                {
+                    bits[4 * (i % 4) + i / 4] = static_cast<std::uint8_t>(0 - ((roundKey[i] >> k) & 1));
+                }
+                m_planes[plane] = bit_plane::load(bits);
+                secureZero(bits, sizeof(bits));
+            }
+        }
     }
 
-    // Final round
-    inverseShiftRows(state);
-    inverseSubBytes(state);
-    addRoundKey(state, reinterpret_cast<std::uint8_t(*)[4]>(roundKeys));
+    basic_key_schedule(const basic_key_schedule&) = default;
 
-    // Copy state back to output (row-major order)
-    for (int i = 0; i < 4; i++)
+    // No move: a moved-from vector would hand its planes over, and assigning over ours would free them unwiped
+    inline basic_key_schedule& operator=(const basic_key_schedule& other)
     {
-        for (int j = 0; j < 4; j++)
+        if (this != &other)
         {
-            output[i * 4 + j] = state[j][i];
+            secureZero(m_planes.data(), m_planes.size() * sizeof(bit_plane));
+            std::memcpy(m_encryptKeys, other.m_encryptKeys, sizeof(m_encryptKeys));
+            std::memcpy(m_decryptKeys, other.m_decryptKeys, sizeof(m_decryptKeys));
+            std::memcpy(m_encryptWords, other.m_encryptWords, sizeof(m_encryptWords));
+            std::memcpy(m_decryptWords, other.m_decryptWords, sizeof(m_decryptWords));
+            m_backend = other.m_backend;
+            m_usage = other.m_usage;
+            m_planes = other.m_planes;
         }
+        return *this;
     }
-}
+
+    ~basic_key_schedule()
+    {
+        secureZero(m_encryptKeys, sizeof(m_encryptKeys));
+        secureZero(m_decryptKeys, sizeof(m_decryptKeys));
+        secureZero(m_encryptWords, sizeof(m_encryptWords));
+        secureZero(m_decryptWords, sizeof(m_decryptWords));
+        secureZero(m_planes.data(), m_planes.size() * sizeof(bit_plane));
+    }
+
+    /**
+     * @brief Encrypts one block; input and output may alias.
+     * 
+     * @param input The input block (16 bytes).
+     * @param output The output block (16 bytes).
+     */
+    inline void encryptBlock(const std::uint8_t input[16], std::uint8_t output[16]) const noexcept
+    {
+        encryptBlocks(input, output, 1);
+    }
+
+    /**
+     * @brief Decrypts one block; input and output may alias.
+     * 
+     * @param input The input block (16 bytes).
+     * @param output The output block (16 bytes).
+     * 
+     * @throws std::runtime_error if the schedule is encrypt-only.
+     */
+    inline void decryptBlock(const std::uint8_t input[16], std::uint8_t output[16]) const
+    {
+        decryptBlocks(input, output, 1);
+    }
+
+    /**
+     * @brief Encrypts consecutive blocks independently (ECB); input and output may alias.
+     * 
+     * @param input The input blocks.
+     * @param output The output blocks.
+     * @param blocks The number of 16-byte blocks.
+     */
+    inline void encryptBlocks(const std::uint8_t* input, std::uint8_t* output, std::size_t blocks) const noexcept
+    {
+        if (m_backend == Backend::Reference)
+        {
+            for (std::size_t i = 0; i < blocks; ++i)
+            {
+                encryptReference(input + i * 16, output + i * 16);
+            }
+        }
+#ifdef NSTD_AES_X86
+        else if (m_backend == Backend::Hardware)
+        {
+            encryptHardware(input, output, blocks);
+        }
+#endif
+        else if (m_backend == Backend::Bitsliced)
+        {
+            for (std::size_t i = 0; i < blocks; i += 8)
+            {
+                encryptBitsliced(input + i * 16, output + i * 16, std::min<std::size_t>(8, blocks - i));
+            }
+        }
+        else
+        {
+            for (std::size_t i = 0; i < blocks; ++i)
+            {
+                encryptTable(input + i * 16, output + i * 16);
+            }
+        }
+    }
+
+    /**
+     * @brief Decrypts consecutive blocks independently (ECB); input and output may alias.
+     * 
+     * @param input The input blocks.
+     * @param output The output blocks.
+     * @param blocks The number of 16-byte blocks.
+     * 
+     * @throws std::runtime_error if the schedule is encrypt-only.
+     */
+    inline void decryptBlocks(const std::uint8_t* input, std::uint8_t* output, std::size_t blocks) const
+    {
+        requireInverse();
+        if (m_backend == Backend::Reference)
+        {
+            for (std::size_t i = 0; i < blocks; ++i)
+            {
+                decryptReference(input + i * 16, output + i * 16);
+            }
+        }
+#ifdef NSTD_AES_X86
+        else if (m_backend == Backend::Hardware)
+        {
+            decryptHardware(input, output, blocks);
+        }
+#endif
+        else if (m_backend == Backend::Bitsliced)
+        {
+            for (std::size_t i = 0; i < blocks; i += 8)
+            {
+                decryptBitsliced(input + i * 16, output + i * 16, std::min<std::size_t>(8, blocks - i));
+            }
+        }
+        else
+        {
+            for (std::size_t i = 0; i < blocks; ++i)
+            {
+                decryptTable(input + i * 16, output + i * 16);
+            }
+        }
+    }
+
+    /**
+     * @brief Returns the block cipher implementation in use, after Automatic and fallback are resolved.
+     */
+    inline Backend backend() const noexcept { return m_backend; }
+
+    /**
+     * @brief Returns the encryption round keys, 16 bytes per round.
+     */
+    inline const std::uint8_t* encryptionKeys() const noexcept { return m_encryptKeys; }
+
+    /**
+     * @brief Returns the equivalent inverse cipher round keys, 16 bytes per round, or nullptr for an encrypt-only schedule.
+     */
+    inline const std::uint8_t* decryptionKeys() const noexcept { return m_usage == KeyUsage::EncryptOnly ? nullptr : m_decryptKeys; }
+
+    /**
+     * @brief Returns which directions the schedule was prepared for.
+     */
+    inline KeyUsage usage() const noexcept { return m_usage; }
+
+    /**
+     * @brief Throws unless the schedule was prepared for decryption.
+     * 
+     * @throws std::runtime_error if the schedule is encrypt-only.
+     */
+    inline void requireInverse() const
+    {
+        if (m_usage == KeyUsage::EncryptOnly)
+        {
+            throw std::runtime_error("Key schedule was prepared for encryption only.");
+        }
+    }
+
+private:
+    alignas(16) std::uint8_t m_encryptKeys[SCHEDULE_SIZE]; // Encryption round keys.
+    alignas(16) std::uint8_t m_decryptKeys[SCHEDULE_SIZE]; // Equivalent inverse cipher round keys.
+    std::uint32_t m_encryptWords[SCHEDULE_SIZE / 4];      // Encryption round keys as column words.
+    std::uint32_t m_decryptWords[SCHEDULE_SIZE / 4];      // Inverse cipher round keys as column words.
+    Backend m_backend;                                     // Block cipher implementation.
+    KeyUsage m_usage;                                      // Directions prepared.
+    std::vector<bit_plane> m_planes;                       // Encryption then inverse cipher round keys as bit planes, empty unless Bitsliced.
+
+    static constexpr std::size_t PLANES = 8 * (ROUNDS + 1); // Bit planes per direction.
+
+    inline void encryptReference(const std::uint8_t input[16], std::uint8_t output[16]) const noexcept
+    {
+        std::uint8_t state[4][4];
+        load(input, state);
+        addRoundKey(state, m_encryptKeys);
+        for (int round = 1; round < ROUNDS; ++round)
+        {
+            subBytes(state);
+            shiftRows(state);
+            mixColumns(state);
+            addRoundKey(state, m_encryptKeys + round * 16);
+        }
+        subBytes(state);
+        shiftRows(state);
+        addRoundKey(state, m_encryptKeys + ROUNDS * 16);
+        store(state, output);
+    }
+
+    inline void decryptReference(const std::uint8_t input[16], std::uint8_t output[16]) const noexcept
+    {
+        std::uint8_t state[4][4];
+        load(input, state);
+        addRoundKey(state, m_decryptKeys);
+        for (int round = 1; round < ROUNDS; ++round)
+        {
+            inverseSubBytes(state);
+            inverseShiftRows(state);
+            inverseMixColumns(state);
+            addRoundKey(state, m_decryptKeys + round * 16);
+        }
+        inverseSubBytes(state);
+        inverseShiftRows(state);
+        addRoundKey(state, m_decryptKeys + ROUNDS * 16);
+        store(state, output);
+    }
+
+    inline void encryptTable(const std::uint8_t input[16], std::uint8_t output[16]) const noexcept
+    {
+        const auto& t = ENCRYPT_TABLES;
+        const std::uint32_t* rk = m_encryptWords;
+        std::uint32_t s0 = loadWord(input) ^ rk[0];
+        std::uint32_t s1 = loadWord(input + 4) ^ rk[1];
+        std::uint32_t s2 = loadWord(input + 8) ^ rk[2];
+        std::uint32_t s3 = loadWord(input + 12) ^ rk[3];
+
+        // Row r of output column c comes from input column c + r (ShiftRows)
+        for (int round = 1; round < ROUNDS; ++round)
+        {
+            rk += 4;
+            std::uint32_t t0 = t[0][s0 & 0xff] ^ t[1][(s1 >> 8) & 0xff] ^ t[2][(s2 >> 16) & 0xff] ^ t[3][s3 >> 24] ^ rk[0];
+            std::uint32_t t1 = t[0][s1 & 0xff] ^ t[1][(s2 >> 8) & 0xff] ^ t[2][(s3 >> 16) & 0xff] ^ t[3][s0 >> 24] ^ rk[1];
+            std::uint32_t t2 = t[0][s2 & 0xff] ^ t[1][(s3 >> 8) & 0xff] ^ t[2][(s0 >> 16) & 0xff] ^ t[3][s1 >> 24] ^ rk[2];
+            std::uint32_t t3 = t[0][s3 & 0xff] ^ t[1][(s0 >> 8) & 0xff] ^ t[2][(s1 >> 16) & 0xff] ^ t[3][s2 >> 24] ^ rk[3];
+            s0 = t0; s1 = t1; s2 = t2; s3 = t3;
+        }
+
+        rk += 4;
+        storeWord(lastRound(SBOX, s0, s1, s2, s3) ^ rk[0], output);
+        storeWord(lastRound(SBOX, s1, s2, s3, s0) ^ rk[1], output + 4);
+        storeWord(lastRound(SBOX, s2, s3, s0, s1) ^ rk[2], output + 8);
+        storeWord(lastRound(SBOX, s3, s0, s1, s2) ^ rk[3], output + 12);
+    }
+
+    inline void decryptTable(const std::uint8_t input[16], std::uint8_t output[16]) const noexcept
+    {
+        const auto& t = DECRYPT_TABLES;
+        const std::uint32_t* rk = m_decryptWords;
+        std::uint32_t s0 = loadWord(input) ^ rk[0];
+        std::uint32_t s1 = loadWord(input + 4) ^ rk[1];
+        std::uint32_t s2 = loadWord(input + 8) ^ rk[2];
+        std::uint32_t s3 = loadWord(input + 12) ^ rk[3];
+
+        // Row r of output column c comes from input column c - r (InvShiftRows)
+        for (int round = 1; round < ROUNDS; ++round)
+        {
+            rk += 4;
+            std::uint32_t t0 = t[0][s0 & 0xff] ^ t[1][(s3 >> 8) & 0xff] ^ t[2][(s2 >> 16) & 0xff] ^ t[3][s1 >> 24] ^ rk[0];
+            std::uint32_t t1 = t[0][s1 & 0xff] ^ t[1][(s0 >> 8) & 0xff] ^ t[2][(s3 >> 16) & 0xff] ^ t[3][s2 >> 24] ^ rk[1];
+            std::uint32_t t2 = t[0][s2 & 0xff] ^ t[1][(s1 >> 8) & 0xff] ^ t[2][(s0 >> 16) & 0xff] ^ t[3][s3 >> 24] ^ rk[2];
+            std::uint32_t t3 = t[0][s3 & 0xff] ^ t[1][(s2 >> 8) & 0xff] ^ t[2][(s1 >> 16) & 0xff] ^ t[3][s0 >> 24] ^ rk[3];
+            s0 = t0; s1 = t1; s2 = t2; s3 = t3;
+        }
+
+        rk += 4;
+        storeWord(lastRound(INV_SBOX, s0, s3, s2, s1) ^ rk[0], output);
+        storeWord(lastRound(INV_SBOX, s1, s0, s3, s2) ^ rk[1], output + 4);
+        storeWord(lastRound(INV_SBOX, s2, s1, s0, s3) ^ rk[2], output + 8);
+        storeWord(lastRound(INV_SBOX, s3, s2, s1, s0) ^ rk[3], output + 12);
+    }
+
+#ifdef NSTD_AES_X86
+    // aesenc/aesdec have a latency of several cycles but issue every cycle, so 8 independent blocks keep the unit busy
+    NSTD_AES_TARGET inline void encryptHardware(const std::uint8_t* input, std::uint8_t* output, std::size_t blocks) const noexcept
+    {
+        __m128i rk[ROUNDS + 1];
+        for (int round = 0; round <= ROUNDS; ++round)
+        {
+            rk[round] = _mm_load_si128(reinterpret_cast<const __m128i*>(m_encryptKeys + round * 16));
+        }
+
+        std::size_t i = 0;
+        for (; i + 8 <= blocks; i += 8)
+        {
+            __m128i b[8];
+            for (int j = 0; j < 8; ++j)
+            {
+                b[j] = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + (i + j) * 16)), rk[0]);
+            }
+            for (int round = 1; round < ROUNDS; ++round)
+            {
+                for (int j = 0; j < 8; ++j)
+                {
+                    b[j] = _mm_aesenc_si128(b[j], rk[round]);
+                }
+            }
+            for (int j = 0; j < 8; ++j)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(output + (i + j) * 16), _mm_aesenclast_si128(b[j], rk[ROUNDS]));
+            }
+        }
+        for (; i < blocks; ++i)
+        {
+            __m128i b = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 16)), rk[0]);
+            for (int round = 1; round < ROUNDS; ++round)
+            {
+                b = _mm_aesenc_si128(b, rk[round]);
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 16), _mm_aesenclast_si128(b, rk[ROUNDS]));
+        }
+    }
+
+    // aesdec implements the equivalent inverse cipher, so it takes m_decryptKeys as they are
+    NSTD_AES_TARGET inline void decryptHardware(const std::uint8_t* input, std::uint8_t* output, std::size_t blocks) const noexcept
+    {
+        __m128i rk[ROUNDS + 1];
+        for (int round = 0; round <= ROUNDS; ++round)
+        {
+            rk[round] = _mm_load_si128(reinterpret_cast<const __m128i*>(m_decryptKeys + round * 16));
+        }
+
+        std::size_t i = 0;
+        for (; i + 8 <= blocks; i += 8)
+        {
+            __m128i b[8];
+            for (int j = 0; j < 8; ++j)
+            {
+                b[j] = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + (i + j) * 16)), rk[0]);
+            }
+            for (int round = 1; round < ROUNDS; ++round)
+            {
+                for (int j = 0; j < 8; ++j)
+                {
+                    b[j] = _mm_aesdec_si128(b[j], rk[round]);
+                }
+            }
+            for (int j = 0; j < 8; ++j)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(output + (i + j) * 16), _mm_aesdeclast_si128(b[j], rk[ROUNDS]));
+            }
+        }
+        for (; i < blocks; ++i)
+        {
+            __m128i b = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 16)), rk[0]);
+            for (int round = 1; round < ROUNDS; ++round)
+            {
+                b = _mm_aesdec_si128(b, rk[round]);
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 16), _mm_aesdeclast_si128(b, rk[ROUNDS]));
+        }
+    }
+#endif
+
+    inline void encryptBitsliced(const std::uint8_t* input, std::uint8_t* output, std::size_t blocks) const noexcept
+    {
+        bit_plane q[8];
+        bitslice(input, blocks, q);
+        const bit_plane* planes = m_planes.data();
+        addRoundPlanes(q, planes);
+        for (int round = 1; round <= ROUNDS; ++round)
+        {
+            bitslicedSubBytes(q);
+            for (int k = 0; k < 8; ++k)
+            {
+                q[k] = q[k].rotateLanes<true>(); // ShiftRows
+            }
+            if (round < ROUNDS)
+            {
+                bitslicedMixColumns(q);
+            }
+            addRoundPlanes(q, planes + round * 8);
+        }
+        unbitslice(q, output, blocks);
+    }
+
+    inline void decryptBitsliced(const std::uint8_t* input, std::uint8_t* output, std::size_t blocks) const noexcept
+    {
+        bit_plane q[8];
+        bitslice(input, blocks, q);
+        const bit_plane* planes = m_planes.data() + PLANES;
+        addRoundPlanes(q, planes);
+        for (int round = 1; round <= ROUNDS; ++round)
+        {
+            bitslicedInverseSubBytes(q);
+            for (int k = 0; k < 8; ++k)
+            {
+                q[k] = q[k].rotateLanes<false>(); // InvShiftRows
+            }
+            if (round < ROUNDS)
+            {
+                bitslicedInverseMixColumns(q);
+            }
+            addRoundPlanes(q, planes + round * 8);
+        }
+        unbitslice(q, output, blocks);
+    }
+
+    static inline void addRoundPlanes(bit_plane q[8], const bit_plane* key) noexcept
+    {
+        for (int k = 0; k < 8; ++k)
+        {
+            q[k] = q[k] ^ key[k];
+        }
+    }
+
+    // Substitutes row r of the output column from column c_r, without mixing
+    static inline std::uint32_t lastRound(const std::uint8_t* box, std::uint32_t c0, std::uint32_t c1, std::uint32_t c2, std::uint32_t c3) noexcept
+    {
+        return std::uint32_t(box[c0 & 0xff]) | (std::uint32_t(box[(c1 >> 8) & 0xff]) << 8) |
+               (std::uint32_t(box[(c2 >> 16) & 0xff]) << 16) | (std::uint32_t(box[c3 >> 24]) << 24);
+    }
+
+    static inline std::uint32_t loadWord(const std::uint8_t* bytes) noexcept
+    {
+        return std::uint32_t(bytes[0]) | (std::uint32_t(bytes[1]) << 8) | (std::uint32_t(bytes[2]) << 16) | (std::uint32_t(bytes[3]) << 24);
+    }
+
+    static inline void storeWord(std::uint32_t word, std::uint8_t* bytes) noexcept
+    {
+        bytes[0] = static_cast<std::uint8_t>(word);
+        bytes[1] = static_cast<std::uint8_t>(word >> 8);
+        bytes[2] = static_cast<std::uint8_t>(word >> 16);
+        bytes[3] = static_cast<std::uint8_t>(word >> 24);
+    }
+
+    static inline void load(const std::uint8_t block[16], std::uint8_t state[4][4]) noexcept
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            for (int j = 0; j < 4; ++j)
+            {
+                state[i][j] = block[j * 4 + i];
+            }
+        }
+    }
+
+    static inline void store(const std::uint8_t state[4][4], std::uint8_t block[16]) noexcept
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            for (int j = 0; j < 4; ++j)
+            {
+                block[j * 4 + i] = state[i][j];
+            }
+        }
+    }
+}; // class basic_key_schedule
+
+using key_schedule = basic_key_schedule<10>;    // AES-128
+using key_schedule192 = basic_key_schedule<12>; // AES-192
+using key_schedule256 = basic_key_schedule<14>; // AES-256
+
+/**
+ * @brief Encrypts a 128-bit block of data using the provided key.
+ * 
+ * Expands the key for this one block; reuse a key_schedule for anything longer.
+ * 
+ * @param input The input block (16 bytes) to be encrypted.
+ * @param key The encryption key (16 bytes).
+ * @param output The output block (16 bytes) that will hold the encrypted data.
+ * 
+ * @throws std::runtime_error if the input, key or output is null.
+ */
+inline void encrypt(const std::uint8_t input[16], const std::uint8_t key[16], std::uint8_t output[16])
+{
+    if (!input || !key || !output)
+    {
+        throw std::runtime_error("Input, key, and output must not be null.");
+    }
+
+    key_schedule(key).encryptBlock(input, output);
+}
+
+/**
+ * @brief Decrypts a 128-bit block of data using the provided key.
+ * 
+ * Expands the key for this one block; reuse a key_schedule for anything longer.
+ * 
+ * @param input The input block (16 bytes) to be decrypted.
+ * @param key The decryption key (16 bytes).
+ * @param output The output block (16 bytes) that will hold the decrypted data.
+ * 
+ * @throws std::runtime_error if the input, key or output is null.
+ */
+inline void decrypt(const std::uint8_t input[16], const std::uint8_t key[16], std::uint8_t output[16])
+{
+    if (!input || !key || !output)
+    {
+        throw std::runtime_error("Input, key, and output must not be null.");
+    }
+
+    key_schedule(key).decryptBlock(input, output);
+}
+
+/**
+ * @brief Buffers of at least this many bytes are split across threads by the bulk modes.
+ */
+inline constexpr std::size_t PARALLEL_THRESHOLD = std::size_t(1) << 20;
+
+/**
+ * @brief Splits [0, blocks) into contiguous chunks and runs them on worker threads.
+ * 
+ * The first chunk runs on the calling thread.
+ * 
+ * @param blocks The number of blocks.
+ * @param threads The requested number of threads (0 selects the hardware concurrency).
+ * @param func A callable invoked as func(begin, end).
+ */
+template <typename Func>
+inline void parallelBlocks(std::size_t blocks, unsigned threads, Func&& func)
+{
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = static_cast<unsigned>(std::max<std::size_t>(1, std::min<std::size_t>(threads, blocks)));
+    if (threads == 1)
+    {
+        func(std::size_t(0), blocks);
+        return;
+    }
+
+    std::size_t chunk = (blocks + threads - 1) / threads;
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (unsigned t = 1; t < threads; ++t)
+    {
+        std::size_t begin = std::min(blocks, t * chunk);
+        std::size_t end = std::min(blocks, begin + chunk);
+        workers.emplace_back([&func, begin, end]() { func(begin, end); });
+    }
+
+    func(std::size_t(0), std::min(blocks, chunk));
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+/**
+ * @brief XORs a key stream into a buffer: output = input ^ stream.
+ * 
+ * @param input The input bytes.
+ * @param stream The key stream bytes.
+ * @param output The output bytes; may alias input.
+ * @param size The number of bytes.
+ */
+inline void xorBytes(const std::uint8_t* input, const std::uint8_t* stream, std::uint8_t* output, std::size_t size) noexcept
+{
+    std::size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        std::uint64_t a, b;
+        std::memcpy(&a, input + i, 8);
+        std::memcpy(&b, stream + i, 8);
+        a ^= b;
+        std::memcpy(output + i, &a, 8);
+    }
+    for (; i < size; ++i)
+    {
+        output[i] = input[i] ^ stream[i];
+    }
+}
+
+/**
+ * @brief Stores a 64-bit value most significant byte first.
+ */
+inline void storeBigEndian(std::uint64_t value, std::uint8_t* bytes) noexcept
+{
+    if constexpr (std::endian::native == std::endian::little)
+    {
+        value = std::byteswap(value);
+    }
+    std::memcpy(bytes, &value, 8);
+}
+
+/**
+ * @brief Loads a 64-bit value stored most significant byte first.
+ */
+inline std::uint64_t loadBigEndian(const std::uint8_t* bytes) noexcept
+{
+    std::uint64_t value;
+    std::memcpy(&value, bytes, 8);
+    if constexpr (std::endian::native == std::endian::little)
+    {
+        value = std::byteswap(value);
+    }
+    return value;
+}
+
+/**
+ * @brief Stores a 64-bit value least significant byte first.
+ */
+inline void storeLittleEndian(std::uint64_t value, std::uint8_t* bytes) noexcept
+{
+    if constexpr (std::endian::native == std::endian::big)
+    {
+        value = std::byteswap(value);
+    }
+    std::memcpy(bytes, &value, 8);
+}
+
+/**
+ * @brief Loads a 64-bit value stored least significant byte first.
+ */
+inline std::uint64_t loadLittleEndian(const std::uint8_t* bytes) noexcept
+{
+    std::uint64_t value;
+    std::memcpy(&value, bytes, 8);
+    if constexpr (std::endian::native == std::endian::big)
+    {
+        value = std::byteswap(value);
+    }
+    return value;
+}
+
+/**
+ * @brief Transforms bytes with AES-CTR on one thread.
+ * 
+ * The counter is the IV read as a 128-bit big-endian number, advanced by one per block.
+ * With Increment32 only the last 32 bits count and wrap on their own, as GCM requires.
+ * 
+ * @tparam Increment32 Whether to increment the low 32 bits only.
+ * @tparam Rounds The number of rounds of the key schedule.
+ * 
+ * @param schedule The expanded key.
+ * @param iv The initial counter block (16 bytes).
+ * @param input The input bytes.
+ * @param output The output bytes; may alias input.
+ * @param size The number of bytes.
+ * @param offset The position of input[0] in the stream, in bytes.
+ */
+template <bool Increment32 = false, int Rounds>
+inline void ctrSerial(const basic_key_schedule<Rounds>& schedule, const std::uint8_t iv[16], const std::uint8_t* input, std::uint8_t* output, std::size_t size, std::uint64_t offset) noexcept
+{
+    constexpr std::size_t BATCH = 32; // Counter blocks per call, handed to the backend 8 at a time.
+
+    std::uint64_t high = loadBigEndian(iv);
+    std::uint64_t low = loadBigEndian(iv + 8);
+    std::uint64_t start = offset / 16;
+    if constexpr (Increment32)
+    {
+        low = (low & 0xffffffff00000000ull) | static_cast<std::uint32_t>(low + start);
+    }
+    else
+    {
+        high += (low + start < low);
+        low += start;
+    }
+
+    std::size_t skip = offset % 16;
+    alignas(16) std::uint8_t stream[BATCH * 16];
+    while (size > 0)
+    {
+        std::size_t blocks = std::min(BATCH, (skip + size + 15) / 16);
+        for (std::size_t j = 0; j < blocks; ++j)
+        {
+            storeBigEndian(high, stream + j * 16);
+            storeBigEndian(low, stream + j * 16 + 8);
+            if constexpr (Increment32)
+            {
+                low = (low & 0xffffffff00000000ull) | static_cast<std::uint32_t>(low + 1);
+            }
+            else
+            {
+                high += (++low == 0);
+            }
+        }
+        schedule.encryptBlocks(stream, stream, blocks);
+
+        std::size_t bytes = std::min(size, blocks * 16 - skip);
+        xorBytes(input, stream + skip, output, bytes);
+        input += bytes;
+        output += bytes;
+        size -= bytes;
+        skip = 0;
+    }
+}
+
+/**
+ * @brief Encrypts or decrypts bytes with AES-CTR (the two are the same operation).
+ * 
+ * Any byte range of the stream can be processed on its own by passing its offset,
+ * which gives random access. Buffers of at least PARALLEL_THRESHOLD bytes are split
+ * across threads, each starting at its own offset.
+ * 
+ * @tparam Rounds The number of rounds of the key schedule.
+ * 
+ * @param schedule The expanded key.
+ * @param iv The initial counter block (16 bytes).
+ * @param input The input bytes.
+ * @param output The output bytes; may alias input.
+ * @param size The number of bytes.
+ * @param offset The position of input[0] in the stream, in bytes.
+ * @param threads The number of threads for large buffers (0 selects the hardware concurrency).
+ * 
+ * @throws std::runtime_error if the iv, input or output is null.
+ */
+template <int Rounds>
+inline void ctr(const basic_key_schedule<Rounds>& schedule, const std::uint8_t iv[16], const std::uint8_t* input, std::uint8_t* output, std::size_t size, std::uint64_t offset = 0, unsigned threads = 0)
+{
+    if (!iv || ((!input || !output) && size > 0))
+    {
+        throw std::runtime_error("IV, input, and output must not be null.");
+    }
+
+    if (size < PARALLEL_THRESHOLD || threads == 1)
+    {
+        ctrSerial(schedule, iv, input, output, size, offset);
+        return;
+    }
+
+    parallelBlocks((size + 15) / 16, threads, [&](std::size_t begin, std::size_t end)
+    {
+        std::size_t first = begin * 16;
+        std::size_t last = std::min(size, end * 16);
+        ctrSerial(schedule, iv, input + first, output + first, last - first, offset + first);
+    });
+}
+
+/**
+ * @brief The GHASH universal hash of GCM: X = (X ^ block) * H in GF(2^128).
+ * 
+ * Three multipliers, chosen by the backend of the cipher it authenticates:
+ * - Hardware: PCLMULQDQ, folding 4 blocks per reduction with precomputed H..H^4.
+ * - Bitsliced (and Hardware on CPUs without PCLMULQDQ): carry-less products built from
+ *   integer multiplications on operands with 3-bit holes, with no secret-dependent
+ *   branches or memory access.
+ * - Table and Reference: Shoup's 4-bit tables (16 multiples of H), faster than the
+ *   constant-time multiplier but indexed by the hash state.
+ */
+class ghash
+{
+public:
+    /**
+     * @brief Prepares the multiplier for a hash key.
+     * 
+     * @param key The hash key H (16 bytes), the encryption of the zero block.
+     * @param backend The backend of the cipher, which selects the multiplier.
+     */
+    ghash(const std::uint8_t key[16], Backend backend) noexcept
+        : m_hardware(backend == Backend::Hardware && carrylessSupported()),
+          m_constantTime(!m_hardware && (backend == Backend::Hardware || backend == Backend::Bitsliced))
+    {
+        std::memset(m_state, 0, sizeof(m_state));
+        m_key[0] = loadBigEndian(key);
+        m_key[1] = loadBigEndian(key + 8);
+        if (m_constantTime)
+        {
+            return; // The tables below branch on key bits
+        }
+
+        // 4-bit table: m_high/m_low[i] hold i * H with i read as 4 bits of a reflected polynomial
+        std::uint64_t high = loadBigEndian(key);
+        std::uint64_t low = loadBigEndian(key + 8);
+        m_high[0] = m_low[0] = 0;
+        m_high[8] = high;
+        m_low[8] = low;
+        for (int i = 4; i > 0; i >>= 1)
+        {
+            std::uint64_t carry = (low & 1) ? 0xe100000000000000ull : 0;
+            low = (high << 63) | (low >> 1);
+            high = (high >> 1) ^ carry;
+            m_high[i] = high;
+            m_low[i] = low;
+        }
+        for (int i = 2; i <= 8; i *= 2)
+        {
+            for (int j = 1; j < i; ++j)
+            {
+                m_high[i + j] = m_high[i] ^ m_high[j];
+                m_low[i + j] = m_low[i] ^ m_low[j];
+            }
+        }
+
+#ifdef NSTD_AES_X86
+        if (m_hardware)
+        {
+            preparePowers(key);
+        }
+#endif
+    }
+
+    /**
+     * @brief Absorbs whole blocks.
+     * 
+     * @param data The blocks.
+     * @param blocks The number of 16-byte blocks.
+     */
+    inline void update(const std::uint8_t* data, std::size_t blocks) noexcept
+    {
+#ifdef NSTD_AES_X86
+        if (m_hardware)
+        {
+            updateHardware(data, blocks);
+            return;
+        }
+#endif
+        if (m_constantTime)
+        {
+            updateConstantTime(data, blocks);
+            return;
+        }
+        for (std::size_t i = 0; i < blocks; ++i)
+        {
+            xorBytes(m_state, data + i * 16, m_state, 16);
+            multiply();
+        }
+    }
+
+    /**
+     * @brief Clears the accumulator, keeping the key.
+     */
+    inline void reset() noexcept { std::memset(m_state, 0, sizeof(m_state)); }
+
+    /**
+     * @brief Returns the accumulator (16 bytes).
+     */
+    inline const std::uint8_t* digest() const noexcept { return m_state; }
+
+    /**
+     * @brief Returns whether PCLMULQDQ is in use.
+     */
+    inline bool hardware() const noexcept { return m_hardware; }
+
+    /**
+     * @brief Returns whether the constant-time software multiplier is in use.
+     */
+    inline bool constantTime() const noexcept { return m_constantTime; }
+
+private:
+    std::uint8_t m_state[16];         // Accumulator X.
+    std::uint64_t m_key[2];           // H as two big-endian halves.
+    std::uint64_t m_high[16];         // High halves of the 4-bit multiples of H.
+    std::uint64_t m_low[16];          // Low halves of the 4-bit multiples of H.
+    alignas(16) std::uint8_t m_powers[4][16]; // H, H^2, H^3, H^4 byte-reversed, for PCLMULQDQ.
+    bool m_hardware;                  // Whether PCLMULQDQ is in use.
+    bool m_constantTime;              // Whether the constant-time multiplier is in use.
+
+    // Reduction of the 4 bits shifted out per step, x^128 = x^7 + x^2 + x + 1 reflected
+    static constexpr std::uint16_t REMAINDER[16] = {
+        0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+        0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0
+    };
+
+    inline void multiply() noexcept
+    {
+        std::uint8_t nibble = m_state[15] & 0xf;
+        std::uint64_t high = m_high[nibble];
+        std::uint64_t low = m_low[nibble];
+
+        for (int i = 15; i >= 0; --i)
+        {
+            std::uint8_t lo = m_state[i] & 0xf;
+            std::uint8_t hi = m_state[i] >> 4;
+            std::uint8_t rem;
+
+            if (i != 15)
+            {
+                rem = low & 0xf;
+                low = (high << 60) | (low >> 4);
+                high = (high >> 4) ^ (std::uint64_t(REMAINDER[rem]) << 48);
+                high ^= m_high[lo];
+                low ^= m_low[lo];
+            }
+
+            rem = low & 0xf;
+            low = (high << 60) | (low >> 4);
+            high = (high >> 4) ^ (std::uint64_t(REMAINDER[rem]) << 48);
+            high ^= m_high[hi];
+            low ^= m_low[hi];
+        }
+
+        storeBigEndian(high, m_state);
+        storeBigEndian(low, m_state + 8);
+    }
+
+    // Low 64 bits of the carry-less product. Keeping only every fourth bit of each operand
+    // leaves 3-bit holes, so the carries of the integer products never reach the next kept bit.
+    static inline std::uint64_t carrylessMultiply(std::uint64_t x, std::uint64_t y) noexcept
+    {
+        constexpr std::uint64_t M0 = 0x1111111111111111ull, M1 = M0 << 1, M2 = M0 << 2, M3 = M0 << 3;
+        std::uint64_t x0 = x & M0, x1 = x & M1, x2 = x & M2, x3 = x & M3;
+        std::uint64_t y0 = y & M0, y1 = y & M1, y2 = y & M2, y3 = y & M3;
+        std::uint64_t z0 = (x0 * y0) ^ (x1 * y3) ^ (x2 * y2) ^ (x3 * y1);
+        std::uint64_t z1 = (x0 * y1) ^ (x1 * y0) ^ (x2 * y3) ^ (x3 * y2);
+        std::uint64_t z2 = (x0 * y2) ^ (x1 * y1) ^ (x2 * y0) ^ (x3 * y3);
+        std::uint64_t z3 = (x0 * y3) ^ (x1 * y2) ^ (x2 * y1) ^ (x3 * y0);
+        return (z0 & M0) | (z1 & M1) | (z2 & M2) | (z3 & M3);
+    }
+
+    static inline std::uint64_t reverseBits(std::uint64_t x) noexcept
+    {
+        x = ((x & 0x5555555555555555ull) << 1) | ((x >> 1) & 0x5555555555555555ull);
+        x = ((x & 0x3333333333333333ull) << 2) | ((x >> 2) & 0x3333333333333333ull);
+        x = ((x & 0x0f0f0f0f0f0f0f0full) << 4) | ((x >> 4) & 0x0f0f0f0f0f0f0f0full);
+        return std::byteswap(x);
+    }
+
+    // Karatsuba over 64-bit halves; the high half of each product is the bit-reversed low half
+    // of the product of the bit-reversed operands
+    inline void updateConstantTime(const std::uint8_t* data, std::size_t blocks) noexcept
+    {
+        const std::uint64_t h1 = m_key[0], h0 = m_key[1], h2 = h0 ^ h1;
+        const std::uint64_t h0r = reverseBits(h0), h1r = reverseBits(h1), h2r = h0r ^ h1r;
+        std::uint64_t y1 = loadBigEndian(m_state);
+        std::uint64_t y0 = loadBigEndian(m_state + 8);
+
+        for (std::size_t i = 0; i < blocks; ++i)
+        {
+            y1 ^= loadBigEndian(data + i * 16);
+            y0 ^= loadBigEndian(data + i * 16 + 8);
+            std::uint64_t y0r = reverseBits(y0), y1r = reverseBits(y1);
+
+            std::uint64_t z0 = carrylessMultiply(y0, h0);
+            std::uint64_t z1 = carrylessMultiply(y1, h1);
+            std::uint64_t z2 = carrylessMultiply(y0 ^ y1, h2) ^ z0 ^ z1;
+            std::uint64_t z0h = carrylessMultiply(y0r, h0r);
+            std::uint64_t z1h = carrylessMultiply(y1r, h1r);
+            std::uint64_t z2h = carrylessMultiply(y0r ^ y1r, h2r) ^ z0h ^ z1h;
+            z0h = reverseBits(z0h) >> 1;
+            z1h = reverseBits(z1h) >> 1;
+            z2h = reverseBits(z2h) >> 1;
+
+            // 256-bit reflected product, shifted left by one bit, then reduced by x^128 + x^7 + x^2 + x + 1
+            std::uint64_t v0 = z0, v1 = z0h ^ z2, v2 = z1 ^ z2h, v3 = z1h;
+            v3 = (v3 << 1) | (v2 >> 63);
+            v2 = (v2 << 1) | (v1 >> 63);
+            v1 = (v1 << 1) | (v0 >> 63);
+            v0 <<= 1;
+            v2 ^= v0 ^ (v0 >> 1) ^ (v0 >> 2) ^ (v0 >> 7);
+            v1 ^= (v0 << 63) ^ (v0 << 62) ^ (v0 << 57);
+            v3 ^= v1 ^ (v1 >> 1) ^ (v1 >> 2) ^ (v1 >> 7);
+            v2 ^= (v1 << 63) ^ (v1 << 62) ^ (v1 << 57);
+            y0 = v2;
+            y1 = v3;
+        }
+
+        storeBigEndian(y1, m_state);
+        storeBigEndian(y0, m_state + 8);
+    }
+
+#ifdef NSTD_AES_X86
+    NSTD_CLMUL_TARGET static inline __m128i reverse(__m128i value) noexcept
+    {
+        return _mm_shuffle_epi8(value, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+    }
+
+    // 256-bit carry-less product of a and b (schoolbook, 4 multiplications), as (low, high)
+    NSTD_CLMUL_TARGET static inline void multiplyWide(__m128i a, __m128i b, __m128i& low, __m128i& high) noexcept
+    {
+        __m128i lo = _mm_clmulepi64_si128(a, b, 0x00);
+        __m128i mid = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x10), _mm_clmulepi64_si128(a, b, 0x01));
+        __m128i hi = _mm_clmulepi64_si128(a, b, 0x11);
+        low = _mm_xor_si128(lo, _mm_slli_si128(mid, 8));
+        high = _mm_xor_si128(hi, _mm_srli_si128(mid, 8));
+    }
+
+    // Shifts the reflected product left by one bit and reduces it modulo x^128 + x^7 + x^2 + x + 1
+    NSTD_CLMUL_TARGET static inline __m128i reduce(__m128i low, __m128i high) noexcept
+    {
+        __m128i carryLow = _mm_srli_epi32(low, 31);
+        __m128i carryHigh = _mm_srli_epi32(high, 31);
+        low = _mm_slli_epi32(low, 1);
+        high = _mm_slli_epi32(high, 1);
+        __m128i across = _mm_srli_si128(carryLow, 12);
+        carryHigh = _mm_slli_si128(carryHigh, 4);
+        carryLow = _mm_slli_si128(carryLow, 4);
+        low = _mm_or_si128(low, carryLow);
+        high = _mm_or_si128(_mm_or_si128(high, carryHigh), across);
+
+        __m128i a = _mm_xor_si128(_mm_xor_si128(_mm_slli_epi32(low, 31), _mm_slli_epi32(low, 30)), _mm_slli_epi32(low, 25));
+        __m128i spill = _mm_srli_si128(a, 4);
+        low = _mm_xor_si128(low, _mm_slli_si128(a, 12));
+
+        __m128i b = _mm_xor_si128(_mm_xor_si128(_mm_srli_epi32(low, 1), _mm_srli_epi32(low, 2)), _mm_srli_epi32(low, 7));
+        b = _mm_xor_si128(b, spill);
+        return _mm_xor_si128(high, _mm_xor_si128(low, b));
+    }
+
+    NSTD_CLMUL_TARGET static inline __m128i multiplyReduce(__m128i a, __m128i b) noexcept
+    {
+        __m128i low, high;
+        multiplyWide(a, b, low, high);
+        return reduce(low, high);
+    }
+
+    NSTD_CLMUL_TARGET inline void preparePowers(const std::uint8_t key[16]) noexcept
+    {
+        __m128i h = reverse(_mm_loadu_si128(reinterpret_cast<const __m128i*>(key)));
+        __m128i power = h;
+        for (int i = 0; i < 4; ++i)
+        {
+            _mm_store_si128(reinterpret_cast<__m128i*>(m_powers[i]), power);
+            power = multiplyReduce(power, h);
+        }
+    }
+
+    // Four blocks share one reduction: X' = (X ^ B0) H^4 ^ B1 H^3 ^ B2 H^2 ^ B3 H
+    NSTD_CLMUL_TARGET inline void updateHardware(const std::uint8_t* data, std::size_t blocks) noexcept
+    {
+        const __m128i h1 = _mm_load_si128(reinterpret_cast<const __m128i*>(m_powers[0]));
+        const __m128i h2 = _mm_load_si128(reinterpret_cast<const __m128i*>(m_powers[1]));
+        const __m128i h3 = _mm_load_si128(reinterpret_cast<const __m128i*>(m_powers[2]));
+        const __m128i h4 = _mm_load_si128(reinterpret_cast<const __m128i*>(m_powers[3]));
+        __m128i x = reverse(_mm_loadu_si128(reinterpret_cast<const __m128i*>(m_state)));
+
+        std::size_t i = 0;
+        for (; i + 4 <= blocks; i += 4)
+        {
+            const __m128i* in = reinterpret_cast<const __m128i*>(data + i * 16);
+            __m128i low, high, l, h;
+            multiplyWide(_mm_xor_si128(x, reverse(_mm_loadu_si128(in))), h4, low, high);
+            multiplyWide(reverse(_mm_loadu_si128(in + 1)), h3, l, h);
+            low = _mm_xor_si128(low, l);
+            high = _mm_xor_si128(high, h);
+            multiplyWide(reverse(_mm_loadu_si128(in + 2)), h2, l, h);
+            low = _mm_xor_si128(low, l);
+            high = _mm_xor_si128(high, h);
+            multiplyWide(reverse(_mm_loadu_si128(in + 3)), h1, l, h);
+            low = _mm_xor_si128(low, l);
+            high = _mm_xor_si128(high, h);
+            x = reduce(low, high);
+        }
+        for (; i < blocks; ++i)
+        {
+            x = multiplyReduce(_mm_xor_si128(x, reverse(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 16)))), h1);
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(m_state), reverse(x));
+    }
+#endif
+}; // class ghash
+
+/**
+ * @brief AES-GCM authenticated encryption (NIST SP 800-38D) with 16-byte tags.
+ * 
+ * The data is encrypted with the CTR path (32-bit counter) and authenticated with GHASH,
+ * which uses PCLMULQDQ when the key schedule runs on the hardware backend and the
+ * constant-time software multiplier when it runs bitsliced, so GCM over Automatic has no
+ * secret-dependent memory access with or without AES-NI.
+ * 
+ * One-shot use goes through encrypt()/decrypt(). Streaming use is init(), any number of
+ * updateAad() calls, then any number of encryptUpdate() or decryptUpdate() calls, and
+ * final() or verify(). Updates may have any length. To release no plaintext before the
+ * tag is checked, hash the ciphertext with authenticateUpdate(), verify(), and only then
+ * decrypt it with decryptVerified().
+ * 
+ * @tparam Rounds The number of rounds: 10, 12 or 14 for AES-128, AES-192 or AES-256.
+ */
+template <int Rounds>
+class basic_gcm
+{
+public:
+    static constexpr std::size_t TAG_SIZE = 16;     // Authentication tag size in bytes.
+    static constexpr std::size_t MIN_TAG_SIZE = 12; // Shortest truncated tag accepted by verify().
+    static constexpr std::uint64_t MAX_DATA_SIZE = ((std::uint64_t(1) << 32) - 2) * 16; // Longest message in bytes (2^39 - 256 bits).
+    static constexpr std::uint64_t MAX_AAD_SIZE = (std::uint64_t(1) << 61) - 1;        // Longest additional data in bytes (2^64 - 1 bits).
+
+    /**
+     * @brief Expands the key and derives the hash key.
+     * 
+     * @param key The encryption key (4 * (Rounds - 6) bytes).
+     * @param backend The block cipher implementation to run on.
+     */
+    explicit basic_gcm(const std::uint8_t* key, Backend backend = Backend::Automatic)
+        : m_schedule(key, backend, KeyUsage::EncryptOnly), m_hash(hashKey(m_schedule).data(), m_schedule.backend())
+    {
+    }
+
+    /**
+     * @brief Starts a message.
+     * 
+     * @param iv The initialization vector; 12 bytes is the recommended size.
+     * @param iv_size The IV size in bytes.
+     * 
+     * @throws std::runtime_error if the iv is null or empty.
+     */
+    inline void init(const std::uint8_t* iv, std::size_t iv_size)
+    {
+        if (!iv || iv_size == 0)
+        {
+            throw std::runtime_error("IV must not be null or empty.");
+        }
+
+        m_hash.reset();
+        if (iv_size == 12)
+        {
+            std::memcpy(m_j0, iv, 12);
+            m_j0[12] = m_j0[13] = m_j0[14] = 0;
+            m_j0[15] = 1;
+        }
+        else
+        {
+            // J0 = GHASH(IV || 0-padding || [0]_64 || [len(IV)]_64)
+            m_hash.update(iv, iv_size / 16);
+            std::uint8_t block[16] = {};
+            if (iv_size % 16)
+            {
+                std::memcpy(block, iv + iv_size / 16 * 16, iv_size % 16);
+                m_hash.update(block, 1);
+                std::memset(block, 0, 16);
+            }
+            storeBigEndian(std::uint64_t(iv_size) * 8, block + 8);
+            m_hash.update(block, 1);
+            std::memcpy(m_j0, m_hash.digest(), 16);
+            m_hash.reset();
+        }
+
+        std::memcpy(m_counter, m_j0, 16);
+        std::uint32_t low = static_cast<std::uint32_t>(loadBigEndian(m_counter + 8)) + 1;
+        m_counter[12] = static_cast<std::uint8_t>(low >> 24);
+        m_counter[13] = static_cast<std::uint8_t>(low >> 16);
+        m_counter[14] = static_cast<std::uint8_t>(low >> 8);
+        m_counter[15] = static_cast<std::uint8_t>(low);
+
+        m_aadSize = m_dataSize = 0;
+        m_verifiedSize = 0;
+        m_pendingSize = 0;
+        m_aadClosed = false;
+        m_started = true;
+    }
+
+    /**
+     * @brief Authenticates additional data that is not encrypted.
+     * 
+     * @param aad The additional data.
+     * @param size The number of bytes.
+     * 
+     * @throws std::runtime_error if the message was not started, data was already processed or the
+     *         additional data would exceed MAX_AAD_SIZE.
+     */
+    inline void updateAad(const std::uint8_t* aad, std::size_t size)
+    {
+        if (!m_started || m_aadClosed)
+        {
+            throw std::runtime_error("Additional data must follow init() and precede the message data.");
+        }
+        if (size > MAX_AAD_SIZE - m_aadSize)
+        {
+            throw std::runtime_error("Additional data exceeds the GCM limit of 2^64 - 1 bits.");
+        }
+        absorb(aad, size);
+        m_aadSize += size;
+    }
+
+    /**
+     * @brief Encrypts the next part of the message.
+     * 
+     * @param input The plaintext.
+     * @param output The ciphertext; may alias input.
+     * @param size The number of bytes.
+     * 
+     * @throws std::runtime_error if the message was not started or would exceed MAX_DATA_SIZE.
+     */
+    inline void encryptUpdate(const std::uint8_t* input, std::uint8_t* output, std::size_t size)
+    {
+        process(input, output, size, Pass::Encrypt);
+    }
+
+    /**
+     * @brief Decrypts the next part of the message.
+     * 
+     * The plaintext is released before the tag is checked; discard it if verify() fails.
+     * 
+     * @param input The ciphertext.
+     * @param output The plaintext; may alias input.
+     * @param size The number of bytes.
+     * 
+     * @throws std::runtime_error if the message was not started or would exceed MAX_DATA_SIZE.
+     */
+    inline void decryptUpdate(const std::uint8_t* input, std::uint8_t* output, std::size_t size)
+    {
+        process(input, output, size, Pass::Decrypt);
+    }
+
+    /**
+     * @brief Authenticates the next part of the ciphertext without decrypting it.
+     * 
+     * @param input The ciphertext.
+     * @param size The number of bytes.
+     * 
+     * @throws std::runtime_error if the message was not started or would exceed MAX_DATA_SIZE.
+     */
+    inline void authenticateUpdate(const std::uint8_t* input, std::size_t size)
+    {
+        process(input, nullptr, size, Pass::Authenticate);
+    }
+
+    /**
+     * @brief Decrypts part of the message whose tag the last verify() accepted, without hashing it again.
+     * 
+     * @param input The ciphertext.
+     * @param output The plaintext; may alias input.
+     * @param size The number of bytes.
+     * @param offset The position of input[0] in the message, in bytes.
+     * 
+     * @throws std::runtime_error if the range lies outside the message the last verify() accepted.
+     */
+    inline void decryptVerified(const std::uint8_t* input, std::uint8_t* output, std::size_t size, std::uint64_t offset)
+    {
+        if (offset > m_verifiedSize || size > m_verifiedSize - offset)
+        {
+            throw std::runtime_error("Data was not authenticated by the last verify().");
+        }
+        ctrSerial<true>(m_schedule, m_counter, input, output, size, offset);
+    }
+
+    /**
+     * @brief Finishes the message and computes its tag.
+     * 
+     * @param tag The output tag (16 bytes).
+     * 
+     * @throws std::runtime_error if the message was not started.
+     */
+    inline void final(std::uint8_t tag[16])
+    {
+        if (!m_started)
+        {
+            throw std::runtime_error("Message was not started.");
+        }
+
+        flush();
+        std::uint8_t lengths[16];
+        storeBigEndian(m_aadSize * 8, lengths);
+        storeBigEndian(m_dataSize * 8, lengths + 8);
+        m_hash.update(lengths, 1);
+
+        m_schedule.encryptBlock(m_j0, tag);
+        xorBytes(tag, m_hash.digest(), tag, 16);
+        m_started = false;
+    }
+
+    /**
+     * @brief Finishes the message and compares its tag in constant time.
+     * 
+     * Truncated tags of 12 to 16 bytes are accepted (SP 800-38D 5.2.1.2). The 8 and 4-byte
+     * tags the standard allows for special applications are rejected: every forged message
+     * would pass with a chance of 2^-32 or more.
+     * 
+     * @param tag The expected tag.
+     * @param tag_size The tag size in bytes, between MIN_TAG_SIZE and TAG_SIZE.
+     * 
+     * @return Whether the tags match.
+     * 
+     * @throws std::runtime_error if the message was not started or tag_size is out of range.
+     */
+    inline bool verify(const std::uint8_t* tag, std::size_t tag_size = TAG_SIZE)
+    {
+        if (!tag || tag_size < MIN_TAG_SIZE || tag_size > TAG_SIZE)
+        {
+            throw std::runtime_error("Tag size must be between 12 and 16 bytes.");
+        }
+
+        std::uint8_t computed[16];
+        final(computed);
+        std::uint8_t difference = 0;
+        for (std::size_t i = 0; i < tag_size; ++i)
+        {
+            difference |= computed[i] ^ tag[i];
+        }
+        m_verifiedSize = difference == 0 ? m_dataSize : 0;
+        return difference == 0;
+    }
+
+    /**
+     * @brief Encrypts and authenticates a whole message.
+     * 
+     * @param iv The initialization vector.
+     * @param iv_size The IV size in bytes.
+     * @param aad The additional authenticated data (may be null when aad_size is 0).
+     * @param aad_size The additional data size in bytes.
+     * @param input The plaintext.
+     * @param output The ciphertext; may alias input.
+     * @param size The number of bytes.
+     * @param tag The output tag (16 bytes).
+     * 
+     * @throws std::runtime_error if the iv is null or empty.
+     */
+    inline void encrypt(const std::uint8_t* iv, std::size_t iv_size, const std::uint8_t* aad, std::size_t aad_size,
+                        const std::uint8_t* input, std::uint8_t* output, std::size_t size, std::uint8_t tag[16])
+    {
+        init(iv, iv_size);
+        updateAad(aad, aad_size);
+        encryptUpdate(input, output, size);
+        final(tag);
+    }
+
+    /**
+     * @brief Authenticates and decrypts a whole message.
+     * 
+     * On a tag mismatch the output is zeroed so no unauthenticated plaintext escapes.
+     * 
+     * @param iv The initialization vector.
+     * @param iv_size The IV size in bytes.
+     * @param aad The additional authenticated data (may be null when aad_size is 0).
+     * @param aad_size The additional data size in bytes.
+     * @param input The ciphertext.
+     * @param output The plaintext; may alias input.
+     * @param size The number of bytes.
+     * @param tag The expected tag (16 bytes).
+     * 
+     * @return Whether the tag matched.
+     * 
+     * @throws std::runtime_error if the iv is null or empty.
+     */
+    inline bool decrypt(const std::uint8_t* iv, std::size_t iv_size, const std::uint8_t* aad, std::size_t aad_size,
+                        const std::uint8_t* input, std::uint8_t* output, std::size_t size, const std::uint8_t tag[16])
+    {
+        init(iv, iv_size);
+        updateAad(aad, aad_size);
+        decryptUpdate(input, output, size);
+        if (!verify(tag))
+        {
+            if (size > 0)
+            {
+                std::memset(output, 0, size);
+            }
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Returns the underlying key schedule, which is encrypt-only.
+     */
+    inline const basic_key_schedule<Rounds>& schedule() const noexcept { return m_schedule; }
+
+    /**
+     * @brief Returns the GHASH state, mainly to query whether PCLMULQDQ is in use.
+     */
+    inline const ghash& hash() const noexcept { return m_hash; }
+
+private:
+    basic_key_schedule<Rounds> m_schedule; // Expanded key.
+    ghash m_hash;                // GHASH keyed with E(0).
+    std::uint8_t m_j0[16];       // Pre-counter block, encrypted to mask the tag.
+    std::uint8_t m_counter[16];  // First counter block of the message, inc32(J0).
+    std::uint8_t m_pending[16];  // Bytes waiting for a whole GHASH block.
+    std::size_t m_pendingSize = 0;  // Number of pending bytes.
+    std::uint64_t m_aadSize = 0;    // Additional data processed, in bytes.
+    std::uint64_t m_dataSize = 0;   // Message data processed, in bytes.
+    std::uint64_t m_verifiedSize = 0; // Message size the last verify() accepted, for decryptVerified().
+    bool m_aadClosed = false;       // Whether message data has started.
+    bool m_started = false;         // Whether init() was called since the last final().
+
+    static inline std::array<std::uint8_t, 16> hashKey(const basic_key_schedule<Rounds>& schedule) noexcept
+    {
+        std::array<std::uint8_t, 16> key{};
+        schedule.encryptBlock(key.data(), key.data());
+        return key;
+    }
+
+    inline void absorb(const std::uint8_t* data, std::size_t size) noexcept
+    {
+        if (size == 0)
+        {
+            return;
+        }
+        if (m_pendingSize > 0)
+        {
+            std::size_t take = std::min(size, 16 - m_pendingSize);
+            std::memcpy(m_pending + m_pendingSize, data, take);
+            m_pendingSize += take;
+            data += take;
+            size -= take;
+            if (m_pendingSize < 16)
+            {
+                return;
+            }
+            m_hash.update(m_pending, 1);
+            m_pendingSize = 0;
+        }
+
+        m_hash.update(data, size / 16);
+        m_pendingSize = size % 16;
+        if (m_pendingSize > 0)
+        {
+            std::memcpy(m_pending, data + size / 16 * 16, m_pendingSize);
+        }
+    }
+
+    // Zero-pads and hashes a partial block
+    inline void flush() noexcept
+    {
+        if (m_pendingSize > 0)
+        {
+            std::memset(m_pending + m_pendingSize, 0, 16 - m_pendingSize);
+            m_hash.update(m_pending, 1);
+            m_pendingSize = 0;
+        }
+    }
+
+    enum class Pass
+    {
+        Encrypt,     // CTR, then hash the ciphertext.
+        Decrypt,     // Hash the ciphertext, then CTR.
+        Authenticate // Hash the ciphertext only.
+    };
+
+    inline void process(const std::uint8_t* input, std::uint8_t* output, std::size_t size, Pass pass)
+    {
+        if (!m_started)
+        {
+            throw std::runtime_error("Message was not started.");
+        }
+        // Beyond this the 32-bit counter wraps and reuses key stream, including the tag mask E(J0)
+        if (size > MAX_DATA_SIZE - m_dataSize)
+        {
+            throw std::runtime_error("Message exceeds the GCM limit of 2^39 - 256 bits.");
+        }
+        if (!m_aadClosed)
+        {
+            flush();
+            m_aadClosed = true;
+        }
+
+        // Chunks small enough that GHASH reads the ciphertext back from L1
+        constexpr std::size_t CHUNK = 4096;
+        while (size > 0)
+        {
+            std::size_t bytes = std::min(size, CHUNK);
+            if (pass != Pass::Encrypt)
+            {
+                absorb(input, bytes);
+            }
+            if (pass != Pass::Authenticate)
+            {
+                ctrSerial<true>(m_schedule, m_counter, input, output, bytes, m_dataSize);
+                output += bytes;
+            }
+            if (pass == Pass::Encrypt)
+            {
+                absorb(output - bytes, bytes);
+            }
+            m_dataSize += bytes;
+            input += bytes;
+            size -= bytes;
+        }
+    }
+}; // class basic_gcm
+
+using gcm = basic_gcm<10>;    // AES-128-GCM
+using gcm192 = basic_gcm<12>; // AES-192-GCM
+using gcm256 = basic_gcm<14>; // AES-256-GCM
+
+/**
+ * @brief Returns the CBC ciphertext size of a message with PKCS#7 padding.
+ * 
+ * @param size The plaintext size in bytes.
+ * 
+ * @return The next multiple of 16 strictly above size.
+ */
+constexpr std::size_t cbcPaddedSize(std::size_t size) noexcept
+{
+    return (size / 16 + 1) * 16;
+}
+
+/**
+ * @brief Encrypts bytes with AES-CBC and PKCS#7 padding.
+ * 
+ * Each block depends on the one before, so encryption runs one block at a time.
+ * 
+ * @tparam Rounds The number of rounds of the key schedule.
+ * 
+ * @param schedule The expanded key.
+ * @param iv The initialization vector (16 bytes).
+ * @param input The plaintext.
+ * @param output The ciphertext, cbcPaddedSize(size) bytes; may alias input if it is that large.
+ * @param size The plaintext size in bytes.
+ * 
+ * @return The ciphertext size in bytes.
+ * 
+ * @throws std::runtime_error if the iv, input or output is null.
+ */
+template <int Rounds>
+inline std::size_t cbcEncrypt(const basic_key_schedule<Rounds>& schedule, const std::uint8_t iv[16], const std::uint8_t* input, std::uint8_t* output, std::size_t size)
+{
+    if (!iv || !output || (!input && size > 0))
+    {
+        throw std::runtime_error("IV, input, and output must not be null.");
+    }
+
+    const std::uint8_t* previous = iv;
+    std::size_t full = size / 16 * 16;
+    for (std::size_t i = 0; i < full; i += 16)
+    {
+        xorBytes(input + i, previous, output + i, 16);
+        schedule.encryptBlock(output + i, output + i);
+        previous = output + i;
+    }
+
+    std::uint8_t last[16];
+    std::uint8_t pad = static_cast<std::uint8_t>(16 - size % 16);
+    std::memset(last, pad, 16);
+    if (size > full)
+    {
+        std::memcpy(last, input + full, size - full);
+    }
+    xorBytes(last, previous, output + full, 16);
+    schedule.encryptBlock(output + full, output + full);
+    return full + 16;
+}
+
+/**
+ * @brief Decrypts CBC blocks without padding removal on one thread.
+ * 
+ * Blocks go through the inverse cipher 32 at a time, which the hardware backend runs
+ * 8 blocks deep, and are XORed with the preceding ciphertext afterwards.
+ * 
+ * @tparam Rounds The number of rounds of the key schedule.
+ * 
+ * @param schedule The expanded key.
+ * @param previous The block before input[0]: the IV or the preceding ciphertext block.
+ * @param input The ciphertext.
+ * @param output The plaintext; may alias input.
+ * @param blocks The number of 16-byte blocks.
+ */
+template <int Rounds>
+inline void cbcDecryptSerial(const basic_key_schedule<Rounds>& schedule, const std::uint8_t previous[16], const std::uint8_t* input, std::uint8_t* output, std::size_t blocks) noexcept
+{
+    constexpr std::size_t BATCH = 32;
+
+    alignas(16) std::uint8_t chain[16];
+    alignas(16) std::uint8_t plain[BATCH * 16];
+    std::memcpy(chain, previous, 16);
+    for (std::size_t i = 0; i < blocks; i += BATCH)
+    {
+        std::size_t n = std::min(BATCH, blocks - i);
+        const std::uint8_t* in = input + i * 16;
+        schedule.decryptBlocks(in, plain, n);
+
+        // Finish the batch before writing, so in-place output never clobbers a needed block
+        xorBytes(plain, chain, plain, 16);
+        xorBytes(plain + 16, in, plain + 16, (n - 1) * 16);
+        std::memcpy(chain, in + (n - 1) * 16, 16);
+        std::memcpy(output + i * 16, plain, n * 16);
+    }
+}
+
+/**
+ * @brief Decrypts bytes with AES-CBC and removes the PKCS#7 padding.
+ * 
+ * Unlike encryption, every block can be decrypted independently. Buffers of at least
+ * PARALLEL_THRESHOLD bytes are split across threads in 64 KB chunks, with each chunk's
+ * preceding ciphertext block saved up front so in-place decryption stays correct.
+ * 
+ * A padding error is reported as an exception; when the ciphertext is not authenticated
+ * this distinction can act as a padding oracle, so prefer GCM for untrusted input.
+ * 
+ * @tparam Rounds The number of rounds of the key schedule.
+ * 
+ * @param schedule The expanded key.
+ * @param iv The initialization vector (16 bytes).
+ * @param input The ciphertext.
+ * @param output The plaintext, size bytes; may alias input.
+ * @param size The ciphertext size in bytes, a non-zero multiple of 16.
+ * @param threads The number of threads for large buffers (0 selects the hardware concurrency).
+ * 
+ * @return The plaintext size in bytes.
+ * 
+ * @throws std::runtime_error if a pointer is null, the size is invalid, the schedule is encrypt-only or the padding is malformed.
+ */
+template <int Rounds>
+inline std::size_t cbcDecrypt(const basic_key_schedule<Rounds>& schedule, const std::uint8_t iv[16], const std::uint8_t* input, std::uint8_t* output, std::size_t size, unsigned threads = 0)
+{
+    if (!iv || !input || !output)
+    {
+        throw std::runtime_error("IV, input, and output must not be null.");
+    }
+    if (size == 0 || size % 16)
+    {
+        throw std::runtime_error("CBC ciphertext size must be a non-zero multiple of 16.");
+    }
+    schedule.requireInverse();
+
+    std::size_t blocks = size / 16;
+    if (size < PARALLEL_THRESHOLD || threads == 1)
+    {
+        cbcDecryptSerial(schedule, iv, input, output, blocks);
+    }
+    else
+    {
+        constexpr std::size_t CHUNK = 4096; // Blocks per chunk (64 KB).
+        std::size_t chunks = (blocks + CHUNK - 1) / CHUNK;
+        std::vector<std::uint8_t> chains(chunks * 16);
+        std::memcpy(chains.data(), iv, 16);
+        for (std::size_t c = 1; c < chunks; ++c)
+        {
+            std::memcpy(chains.data() + c * 16, input + (c * CHUNK - 1) * 16, 16);
+        }
+
+        parallelBlocks(chunks, threads, [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t c = begin; c < end; ++c)
+            {
+                std::size_t first = c * CHUNK;
+                cbcDecryptSerial(schedule, chains.data() + c * 16, input + first * 16, output + first * 16, std::min(CHUNK, blocks - first));
+            }
+        });
+    }
+
+    // Check every padding byte without an early exit
+    std::uint8_t pad = output[size - 1];
+    std::uint8_t bad = static_cast<std::uint8_t>((pad == 0) | (pad > 16));
+    for (std::size_t i = 1; i <= 16; ++i)
+    {
+        std::uint8_t inside = static_cast<std::uint8_t>(0 - static_cast<std::uint8_t>(i <= pad));
+        bad |= static_cast<std::uint8_t>((output[size - i] ^ pad) & inside);
+    }
+    if (bad)
+    {
+        throw std::runtime_error("Invalid CBC padding.");
+    }
+    return size - pad;
+}
+
+/**
+ * @brief AES-XTS for sector-based storage (IEEE 1619, NIST SP 800-38E).
+ * 
+ * The key is two AES keys back to back: the first encrypts data, the second encrypts
+ * the sector number into the initial tweak. Within a sector the tweak is multiplied by
+ * x in GF(2^128) for every block; tweaks are generated 32 at a time and XORed 8 bytes
+ * at a time around one encryptBlocks call. Sectors whose size is not a multiple of 16
+ * use ciphertext stealing.
+ * 
+ * @tparam Rounds The number of rounds: 10 for XTS-AES-128 (32-byte key), 14 for XTS-AES-256 (64-byte key).
+ */
+template <int Rounds>
+class basic_xts
+{
+public:
+    static constexpr std::size_t KEY_SIZE = 2 * basic_key_schedule<Rounds>::KEY_SIZE; // Combined key size in bytes.
+
+    /**
+     * @brief Expands the data and tweak keys.
+     * 
+     * @param key The data key followed by the tweak key (KEY_SIZE bytes).
+     * @param backend The block cipher implementation to run on.
+     */
+    explicit basic_xts(const std::uint8_t* key, Backend backend = Backend::Automatic)
+        : m_data(key, backend), m_tweak(key + KEY_SIZE / 2, backend, KeyUsage::EncryptOnly)
+    {
+    }
+
+    /**
+     * @brief Encrypts one sector.
+     * 
+     * @param sector The sector number (data unit sequence number).
+     * @param input The plaintext.
+     * @param output The ciphertext; may alias input.
+     * @param size The sector size in bytes, at least 16.
+     * 
+     * @throws std::runtime_error if the size is below 16 bytes.
+     */
+    inline void encryptSector(std::uint64_t sector, const std::uint8_t* input, std::uint8_t* output, std::size_t size) const
+    {
+        checkSize(size);
+        process<true>(sector, input, output, size);
+    }
+
+    /**
+     * @brief Decrypts one sector.
+     * 
+     * @param sector The sector number (data unit sequence number).
+     * @param input The ciphertext.
+     * @param output The plaintext; may alias input.
+     * @param size The sector size in bytes, at least 16.
+     * 
+     * @throws std::runtime_error if the size is below 16 bytes.
+     */
+    inline void decryptSector(std::uint64_t sector, const std::uint8_t* input, std::uint8_t* output, std::size_t size) const
+    {
+        checkSize(size);
+        process<false>(sector, input, output, size);
+    }
+
+    /**
+     * @brief Encrypts consecutive sectors, numbered from first_sector.
+     * 
+     * Batches of at least PARALLEL_THRESHOLD bytes are split across threads by sector.
+     * 
+     * @param first_sector The number of the first sector.
+     * @param input The plaintext sectors.
+     * @param output The ciphertext sectors; may alias input.
+     * @param sector_size The size of every sector in bytes, at least 16.
+     * @param sectors The number of sectors.
+     * @param threads The number of threads for large batches (0 selects the hardware concurrency).
+     * 
+     * @throws std::runtime_error if the sector size is below 16 bytes.
+     */
+    inline void encryptSectors(std::uint64_t first_sector, const std::uint8_t* input, std::uint8_t* output,
+                               std::size_t sector_size, std::size_t sectors, unsigned threads = 0) const
+    {
+        checkSize(sector_size);
+        batch<true>(first_sector, input, output, sector_size, sectors, threads);
+    }
+
+    /**
+     * @brief Decrypts consecutive sectors, numbered from first_sector.
+     * 
+     * Batches of at least PARALLEL_THRESHOLD bytes are split across threads by sector.
+     * 
+     * @param first_sector The number of the first sector.
+     * @param input The ciphertext sectors.
+     * @param output The plaintext sectors; may alias input.
+     * @param sector_size The size of every sector in bytes, at least 16.
+     * @param sectors The number of sectors.
+     * @param threads The number of threads for large batches (0 selects the hardware concurrency).
+     * 
+     * @throws std::runtime_error if the sector size is below 16 bytes.
+     */
+    inline void decryptSectors(std::uint64_t first_sector, const std::uint8_t* input, std::uint8_t* output,
+                               std::size_t sector_size, std::size_t sectors, unsigned threads = 0) const
+    {
+        checkSize(sector_size);
+        batch<false>(first_sector, input, output, sector_size, sectors, threads);
+    }
+
+private:
+    basic_key_schedule<Rounds> m_data;  // Data key.
+    basic_key_schedule<Rounds> m_tweak; // Tweak key.
+
+    static inline void checkSize(std::size_t size)
+    {
+        if (size < 16)
+        {
+            throw std::runtime_error("XTS needs at least one full block per sector.");
+        }
+    }
+
+    // Multiplies the tweak by x: a 128-bit little-endian shift with the carry folded back as 0x87
+    static inline void doubleTweak(std::uint64_t& low, std::uint64_t& high) noexcept
+    {
+        std::uint64_t carry = high >> 63;
+        high = (high << 1) | (low >> 63);
+        low = (low << 1) ^ (0x87 & (0 - carry));
+    }
+
+    template <bool Encrypt>
+    inline void cipher(const std::uint8_t* input, std::uint8_t* output, std::size_t blocks) const noexcept
+    {
+        if constexpr (Encrypt)
+        {
+            m_data.encryptBlocks(input, output, blocks);
+        }
+        else
+        {
+            m_data.decryptBlocks(input, output, blocks);
+        }
+    }
+
+    // One block with an explicit tweak: out = cipher(in ^ t) ^ t
+    template <bool Encrypt>
+    inline void cipherBlock(const std::uint8_t input[16], std::uint8_t output[16], std::uint64_t low, std::uint64_t high) const noexcept
+    {
+        std::uint8_t tweak[16];
+        storeLittleEndian(low, tweak);
+        storeLittleEndian(high, tweak + 8);
+        xorBytes(input, tweak, output, 16);
+        cipher<Encrypt>(output, output, 1);
+        xorBytes(output, tweak, output, 16);
+    }
+
+    template <bool Encrypt>
+    inline void process(std::uint64_t sector, const std::uint8_t* input, std::uint8_t* output, std::size_t size) const noexcept
+    {
+        constexpr std::size_t BATCH = 32;
+
+        alignas(16) std::uint8_t tweaks[BATCH * 16] = {};
+        storeLittleEndian(sector, tweaks);
+        m_tweak.encryptBlock(tweaks, tweaks);
+        std::uint64_t low = loadLittleEndian(tweaks);
+        std::uint64_t high = loadLittleEndian(tweaks + 8);
+
+        std::size_t remainder = size % 16;
+        std::size_t full = size / 16 - (remainder ? 1 : 0); // The last full block joins the stealing step
+        for (std::size_t i = 0; i < full; i += BATCH)
+        {
+            std::size_t n = std::min(BATCH, full - i);
+            for (std::size_t j = 0; j < n; ++j)
+            {
+                storeLittleEndian(low, tweaks + j * 16);
+                storeLittleEndian(high, tweaks + j * 16 + 8);
+                doubleTweak(low, high);
+            }
+            xorBytes(input + i * 16, tweaks, output + i * 16, n * 16);
+            cipher<Encrypt>(output + i * 16, output + i * 16, n);
+            xorBytes(output + i * 16, tweaks, output + i * 16, n * 16);
+        }
+
+        if (remainder == 0)
+        {
+            return;
+        }
+
+        // Ciphertext stealing over the last full block (tweak m - 1) and the partial block (tweak m)
+        const std::uint8_t* lastIn = input + full * 16;
+        std::uint8_t* lastOut = output + full * 16;
+        std::uint64_t nextLow = low, nextHigh = high;
+        doubleTweak(nextLow, nextHigh);
+
+        std::uint8_t whole[16], stolen[16];
+        if constexpr (Encrypt)
+        {
+            cipherBlock<true>(lastIn, whole, low, high);
+            std::memcpy(stolen, lastIn + 16, remainder);
+            std::memcpy(stolen + remainder, whole + remainder, 16 - remainder);
+            std::memcpy(lastOut + 16, whole, remainder);
+            cipherBlock<true>(stolen, lastOut, nextLow, nextHigh);
+        }
+        else
+        {
+            cipherBlock<false>(lastIn, whole, nextLow, nextHigh);
+            std::memcpy(stolen, lastIn + 16, remainder);
+            std::memcpy(stolen + remainder, whole + remainder, 16 - remainder);
+            std::memcpy(lastOut + 16, whole, remainder);
+            cipherBlock<false>(stolen, lastOut, low, high);
+        }
+    }
+
+    template <bool Encrypt>
+    inline void batch(std::uint64_t first_sector, const std::uint8_t* input, std::uint8_t* output,
+                      std::size_t sector_size, std::size_t sectors, unsigned threads) const
+    {
+        if ((!input || !output) && sectors > 0)
+        {
+            throw std::runtime_error("Input and output must not be null.");
+        }
+
+        if (sector_size * sectors < PARALLEL_THRESHOLD || threads == 1)
+        {
+            threads = 1;
+        }
+        parallelBlocks(sectors, threads, [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                process<Encrypt>(first_sector + i, input + i * sector_size, output + i * sector_size, sector_size);
+            }
+        });
+    }
+}; // class basic_xts
+
+using xts = basic_xts<10>;    // XTS-AES-128
+using xts256 = basic_xts<14>; // XTS-AES-256
+
+/**
+ * @brief An existing file mapped read-write, for in-place encryption.
+ */
+class mapped_file
+{
+public:
+    /**
+     * @brief Maps a whole file read-write.
+     * 
+     * @param path The path of the file.
+     * 
+     * @throws std::runtime_error if the file cannot be opened or mapped.
+     */
+    explicit mapped_file(const std::string& path)
+    {
+#ifdef _WIN32
+        m_file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE)
+        {
+            throw std::runtime_error("Failed to open " + path);
+        }
+
+        LARGE_INTEGER file_size;
+        GetFileSizeEx(m_file, &file_size);
+        m_size = static_cast<std::size_t>(file_size.QuadPart);
+        if (m_size > 0)
+        {
+            m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+            m_data = m_mapping ? MapViewOfFile(m_mapping, FILE_MAP_WRITE, 0, 0, m_size) : nullptr;
+        }
+#else
+        m_fd = ::open(path.c_str(), O_RDWR);
+        if (m_fd < 0)
+        {
+            throw std::runtime_error("Failed to open " + path);
+        }
+
+        struct stat info;
+        fstat(m_fd, &info);
+        m_size = static_cast<std::size_t>(info.st_size);
+        if (m_size > 0)
+        {
+            void* data = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+            m_data = data == MAP_FAILED ? nullptr : data;
+        }
+#endif
+        if (m_size > 0 && !m_data)
+        {
+            close();
+            throw std::runtime_error("Failed to map " + path);
+        }
+    }
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    ~mapped_file()
+    {
+        close();
+    }
+
+    inline std::uint8_t* data() const noexcept { return static_cast<std::uint8_t*>(m_data); }
+    inline std::size_t size() const noexcept { return m_size; }
+
+    /**
+     * @brief Asks the kernel to start reading a range in, so the reads overlap with other work.
+     * 
+     * @param offset The first byte of the range.
+     * @param length The length of the range in bytes.
+     */
+    inline void prefetch(std::size_t offset, std::size_t length) const noexcept
+    {
+#ifdef _WIN32
+        (void)offset, (void)length; // Sequential scan hint given at open time
+#else
+        if (!m_data || offset >= m_size)
+        {
+            return;
+        }
+
+        static const std::size_t page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        std::size_t begin = offset / page * page;
+        std::size_t end = std::min(m_size, offset + length);
+        madvise(data() + begin, end - begin, MADV_WILLNEED);
+#endif
+    }
+
+    /**
+     * @brief Calls func(chunk, offset, length) on consecutive chunks of the mapping.
+     * 
+     * The next chunk is prefetched before func runs, so the disk reads one chunk while
+     * the caller transforms the other.
+     * 
+     * @param chunk_size The chunk size in bytes.
+     * @param func The callable.
+     */
+    template <typename Func>
+    inline void forEachChunk(std::size_t chunk_size, Func&& func) const
+    {
+        prefetch(0, chunk_size);
+        for (std::size_t offset = 0; offset < m_size; offset += chunk_size)
+        {
+            prefetch(offset + chunk_size, chunk_size);
+            func(data() + offset, offset, std::min(chunk_size, m_size - offset));
+        }
+    }
+
+private:
+    void* m_data = nullptr; // Start of the mapping.
+    std::size_t m_size = 0; // Size of the file in bytes.
+#ifdef _WIN32
+    HANDLE m_file = INVALID_HANDLE_VALUE; // File handle.
+    HANDLE m_mapping = nullptr;           // File mapping handle.
+#else
+    int m_fd = -1;                        // File descriptor.
+#endif
+
+    inline void close() noexcept
+    {
+#ifdef _WIN32
+        if (m_data) UnmapViewOfFile(m_data);
+        if (m_mapping) CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+        m_mapping = nullptr;
+        m_file = INVALID_HANDLE_VALUE;
+#else
+        if (m_data) munmap(m_data, m_size);
+        if (m_fd >= 0) ::close(m_fd);
+        m_fd = -1;
+#endif
+        m_data = nullptr;
+        m_size = 0;
+    }
+}; // class mapped_file
+
+/**
+ * @brief Chunk size for file encryption: large enough to amortize threads, small enough to pipeline reads.
+ */
+inline constexpr std::size_t FILE_CHUNK = std::size_t(4) << 20;
+
+/**
+ * @brief Encrypts or decrypts a file in place with AES-CTR through a memory mapping.
+ * 
+ * @tparam Rounds The number of rounds of the key schedule.
+ * 
+ * @param schedule The expanded key.
+ * @param iv The initial counter block (16 bytes).
+ * @param path The path of the file.
+ * @param threads The number of threads per chunk (0 selects the hardware concurrency).
+ * 
+ * @throws std::runtime_error if the file cannot be opened or mapped.
+ */
+template <int Rounds>
+inline void ctrFile(const basic_key_schedule<Rounds>& schedule, const std::uint8_t iv[16], const std::string& path, unsigned threads = 0)
+{
+    mapped_file file(path);
+    file.forEachChunk(FILE_CHUNK, [&](std::uint8_t* chunk, std::size_t offset, std::size_t length)
+    {
+        ctr(schedule, iv, chunk, chunk, length, offset, threads);
+    });
+}
+
+/**
+ * @brief Encrypts a file in place with AES-GCM through a memory mapping.
+ * 
+ * @tparam Rounds The number of rounds of the cipher.
+ * 
+ * @param cipher The GCM context; its streaming state is reset.
+ * @param iv The initialization vector.
+ * @param iv_size The IV size in bytes.
+ * @param aad The additional authenticated data (may be null when aad_size is 0).
+ * @param aad_size The additional data size in bytes.
+ * @param path The path of the file.
+ * @param tag The output tag (16 bytes).
+ * 
+ * @throws std::runtime_error if the file cannot be opened or mapped, is longer than MAX_DATA_SIZE or the iv is invalid.
+ */
+template <int Rounds>
+inline void gcmEncryptFile(basic_gcm<Rounds>& cipher, const std::uint8_t* iv, std::size_t iv_size,
+                           const std::uint8_t* aad, std::size_t aad_size, const std::string& path, std::uint8_t tag[16])
+{
+    mapped_file file(path);
+    if (file.size() > basic_gcm<Rounds>::MAX_DATA_SIZE)
+    {
+        throw std::runtime_error("File exceeds the GCM message limit: " + path);
+    }
+    cipher.init(iv, iv_size);
+    cipher.updateAad(aad, aad_size);
+    file.forEachChunk(FILE_CHUNK, [&](std::uint8_t* chunk, std::size_t, std::size_t length)
+    {
+        cipher.encryptUpdate(chunk, chunk, length);
+    });
+    cipher.final(tag);
+}
+
+/**
+ * @brief Decrypts a file in place with AES-GCM through a memory mapping.
+ * 
+ * A first pass only hashes the ciphertext; the file is decrypted in a second pass once the
+ * tag has matched, so unauthenticated plaintext never reaches the mapping. If the tag does
+ * not match, the file is left untouched.
+ * 
+ * @tparam Rounds The number of rounds of the cipher.
+ * 
+ * @param cipher The GCM context; its streaming state is reset.
+ * @param iv The initialization vector.
+ * @param iv_size The IV size in bytes.
+ * @param aad The additional authenticated data (may be null when aad_size is 0).
+ * @param aad_size The additional data size in bytes.
+ * @param path The path of the file.
+ * @param tag The expected tag (16 bytes).
+ * 
+ * @return Whether the tag matched.
+ * 
+ * @throws std::runtime_error if the file cannot be opened or mapped or the iv is invalid.
+ */
+template <int Rounds>
+inline bool gcmDecryptFile(basic_gcm<Rounds>& cipher, const std::uint8_t* iv, std::size_t iv_size,
+                           const std::uint8_t* aad, std::size_t aad_size, const std::string& path, const std::uint8_t tag[16])
+{
+    mapped_file file(path);
+    cipher.init(iv, iv_size);
+    cipher.updateAad(aad, aad_size);
+    file.forEachChunk(FILE_CHUNK, [&](std::uint8_t* chunk, std::size_t, std::size_t length)
+    {
+        cipher.authenticateUpdate(chunk, length);
+    });
+    if (!cipher.verify(tag))
+    {
+        return false;
+    }
+
+    file.forEachChunk(FILE_CHUNK, [&](std::uint8_t* chunk, std::size_t offset, std::size_t length)
+    {
+        cipher.decryptVerified(chunk, chunk, length, offset);
+    });
+    return true;
+}
+
+/**
+ * @brief An in-place transformation of a byte range, applied to a stream chunk by chunk.
+ */
+using stream_transform = std::function<void(std::uint8_t*, std::size_t)>;
+
+/**
+ * @brief Creates an AES-CTR stream transform that tracks its own offset.
+ * 
+ * @tparam Rounds The number of rounds of the key schedule.
+ * 
+ * @param schedule The expanded key; must outlive the transform.
+ * @param iv The initial counter block (16 bytes), copied.
+ * @param offset The stream position of the first byte.
+ */
+template <int Rounds>
+inline stream_transform ctrTransform(const basic_key_schedule<Rounds>& schedule, const std::uint8_t iv[16], std::uint64_t offset = 0)
+{
+    std::array<std::uint8_t, 16> counter;
+    std::memcpy(counter.data(), iv, 16);
+    return [&schedule, counter, offset](std::uint8_t* data, std::size_t size) mutable
+    {
+        ctr(schedule, counter.data(), data, data, size, offset);
+        offset += size;
+    };
+}
+
+/**
+ * @brief Default buffer size of the cipher stream buffers.
+ */
+inline constexpr std::size_t STREAM_BUFFER = std::size_t(1) << 20;
+
+/**
+ * @brief An output stream buffer that encrypts everything written to it before passing it on.
+ * 
+ * Data collects in one of two buffers. A full buffer is transformed in place and
+ * written to the target on a background task while the caller fills the other buffer.
+ * Call finish() (or destroy the buffer) to push out the tail before using the target.
+ */
+class cipher_ostreambuf : public std::streambuf
+{
+public:
+    /**
+     * @brief Wraps a target stream buffer.
+     * 
+     * @param target The stream buffer receiving the transformed bytes; must outlive this one.
+     * @param transform The transformation, e.g. ctrTransform() or a GCM encryptUpdate() call.
+     * @param buffer_size The size of each of the two buffers in bytes.
+     */
+    cipher_ostreambuf(std::streambuf& target, stream_transform transform, std::size_t buffer_size = STREAM_BUFFER)
+        : m_target(target), m_transform(std::move(transform))
+    {
+        m_buffers[0].resize(std::max<std::size_t>(16, buffer_size));
+        m_buffers[1].resize(m_buffers[0].size());
+        resetPut();
+    }
+
+    cipher_ostreambuf(const cipher_ostreambuf&) = delete;
+    cipher_ostreambuf& operator=(const cipher_ostreambuf&) = delete;
+
+    ~cipher_ostreambuf() override
+    {
+        try
+        {
+            finish();
+        }
+        catch (...)
+        {
+        }
+    }
+
+    /**
+     * @brief Transforms and writes the buffered bytes and waits for the target.
+     * 
+     * @throws std::runtime_error if the target rejects a write.
+     */
+    inline void finish()
+    {
+        submit();
+        wait();
+        m_target.pubsync();
+    }
+
+protected:
+    int_type overflow(int_type ch) override
+    {
+        try
+        {
+            submit();
+        }
+        catch (...)
+        {
+            return traits_type::eof();
+        }
+        if (!traits_type::eq_int_type(ch, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    int sync() override
+    {
+        try
+        {
+            finish();
+        }
+        catch (...)
+        {
+            return -1;
+        }
+        return 0;
+    }
+
+private:
+    std::streambuf& m_target;               // Destination of the transformed bytes.
+    stream_transform m_transform;           // In-place transformation.
+    std::vector<std::uint8_t> m_buffers[2]; // Double buffer.
+    int m_current = 0;                      // Buffer being filled.
+    std::future<bool> m_pending;            // Write of the other buffer.
+
+    inline void resetPut() noexcept
+    {
+        char* begin = reinterpret_cast<char*>(m_buffers[m_current].data());
+        setp(begin, begin + m_buffers[m_current].size());
+    }
+
+    inline void wait()
+    {
+        if (m_pending.valid() && !m_pending.get())
+        {
+            throw std::runtime_error("Failed to write the encrypted stream.");
+        }
+    }
+
+    inline void submit()
+    {
+        std::size_t size = static_cast<std::size_t>(pptr() - pbase());
+        if (size == 0)
+        {
+            return;
+        }
+
+        std::uint8_t* data = m_buffers[m_current].data();
+        m_transform(data, size);
+        wait();
+        m_pending = std::async(std::launch::async, [this, data, size]()
+        {
+            return m_target.sputn(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size)) == static_cast<std::streamsize>(size);
+        });
+        m_current ^= 1;
+        resetPut();
+    }
+}; // class cipher_ostreambuf
+
+/**
+ * @brief An input stream buffer that decrypts everything read through it.
+ * 
+ * While the caller consumes one buffer, a background task reads the next chunk of the
+ * source into the other, so source reads overlap with decryption and parsing.
+ */
+class cipher_istreambuf : public std::streambuf
+{
+public:
+    /**
+     * @brief Wraps a source stream buffer and starts reading the first chunk.
+     * 
+     * @param source The stream buffer supplying the transformed bytes; must outlive this one.
+     * @param transform The transformation, e.g. ctrTransform() or a GCM decryptUpdate() call.
+     * @param buffer_size The size of each of the two buffers in bytes.
+     */
+    cipher_istreambuf(std::streambuf& source, stream_transform transform, std::size_t buffer_size = STREAM_BUFFER)
+        : m_source(source), m_transform(std::move(transform))
+    {
+        m_buffers[0].resize(std::max<std::size_t>(16, buffer_size));
+        m_buffers[1].resize(m_buffers[0].size());
+        setg(nullptr, nullptr, nullptr);
+        read(0);
+    }
+
+    cipher_istreambuf(const cipher_istreambuf&) = delete;
+    cipher_istreambuf& operator=(const cipher_istreambuf&) = delete;
+
+    ~cipher_istreambuf() override
+    {
+        if (m_pending.valid())
+        {
+            m_pending.wait();
+        }
+    }
+
+protected:
+    int_type underflow() override
+    {
+        if (gptr() < egptr())
+        {
+            return traits_type::to_int_type(*gptr());
+        }
+        if (!m_pending.valid())
+        {
+            return traits_type::eof();
+        }
+
+        std::size_t size = m_pending.get();
+        if (size == 0)
+        {
+            return traits_type::eof();
+        }
+
+        int ready = m_next;
+        std::uint8_t* data = m_buffers[ready].data();
+        m_transform(data, size);
+        char* begin = reinterpret_cast<char*>(data);
+        setg(begin, begin, begin + size);
+        read(ready ^ 1);
+        return traits_type::to_int_type(*gptr());
+    }
+
+private:
+    std::streambuf& m_source;               // Origin of the transformed bytes.
+    stream_transform m_transform;           // In-place transformation.
+    std::vector<std::uint8_t> m_buffers[2]; // Double buffer.
+    int m_next = 0;                         // Buffer being read into.
+    std::future<std::size_t> m_pending;     // Read into that buffer.
+
+    inline void read(int buffer)
+    {
+        m_next = buffer;
+        std::uint8_t* data = m_buffers[buffer].data();
+        std::size_t capacity = m_buffers[buffer].size();
+        m_pending = std::async(std::launch::async, [this, data, capacity]()
+        {
+            std::streamsize got = m_source.sgetn(reinterpret_cast<char*>(data), static_cast<std::streamsize>(capacity));
+            return got > 0 ? static_cast<std::size_t>(got) : std::size_t(0);
+        });
+    }
+}; // class cipher_istreambuf
+
+/**
+ * @brief A cryptographically secure random bit generator (CTR_DRBG, NIST SP 800-90A, AES-256 without derivation function).
+ * 
+ * Output is produced in BUFFER_SIZE batches through the pipelined CTR path and handed out from
+ * the buffer. Bytes are zeroed in the buffer as they are handed out, and the key and counter
+ * are replaced after every batch, so a later compromise of the state does not reveal earlier
+ * output. Satisfies UniformRandomBitGenerator, so it can drive the distributions in <random>.
+ * 
+ * An instance is not thread-safe; use local() for one per thread. Generators seeded from
+ * std::random_device reseed in a child process after fork(), so parent and child never share
+ * output; deterministic generators keep their stream across fork() by design.
+ */
+class ctr_drbg
+{
+public:
+    using result_type = std::uint64_t;
+
+    static constexpr std::size_t SEED_SIZE = 48;                         // Key and counter, as seed material.
+    static constexpr std::size_t BUFFER_SIZE = 4096;                     // Bytes generated per batch.
+    static constexpr std::uint64_t RESEED_INTERVAL = std::uint64_t(1) << 16; // Batches between automatic reseeds.
+
+    /**
+     * @brief Constructs a generator seeded from std::random_device; it reseeds itself every RESEED_INTERVAL batches.
+     */
+    ctr_drbg() : m_schedule(ZERO_KEY, Backend::Automatic, KeyUsage::EncryptOnly), m_automatic(true)
+    {
+        reseed();
+    }
+
+    /**
+     * @brief Constructs a deterministic generator from caller-supplied seed material.
+     * 
+     * @param seed The seed material, shorter inputs are zero-padded.
+     * @param size The size of the seed material in bytes, at most SEED_SIZE.
+     * 
+     * @throws std::runtime_error if the seed is null or too long.
+     */
+    ctr_drbg(const std::uint8_t* seed, std::size_t size) : m_schedule(ZERO_KEY, Backend::Automatic, KeyUsage::EncryptOnly), m_automatic(false)
+    {
+        reseed(seed, size);
+    }
+
+    // Copies would hand out the same stream twice
+    ctr_drbg(const ctr_drbg&) = delete;
+    ctr_drbg& operator=(const ctr_drbg&) = delete;
+
+    // m_schedule wipes its own round keys
+    ~ctr_drbg()
+    {
+        secureZero(m_counter, sizeof(m_counter));
+        secureZero(m_buffer, sizeof(m_buffer));
+    }
+
+    static constexpr result_type min() noexcept { return 0; }
+    static constexpr result_type max() noexcept { return std::numeric_limits<result_type>::max(); }
+
+    /**
+     * @brief Returns 64 random bits.
+     */
+    inline result_type operator()()
+    {
+        checkFork();
+        if (BUFFER_SIZE - m_position < sizeof(result_type))
+        {
+            refill(m_buffer, BUFFER_SIZE);
+            m_position = 0;
+        }
+
+        result_type value;
+        std::memcpy(&value, m_buffer + m_position, sizeof(value));
+        std::memset(m_buffer + m_position, 0, sizeof(value));
+        m_position += sizeof(value);
+        return value;
+    }
+
+    /**
+     * @brief Fills a buffer with random bytes; whole batches are generated straight into it.
+     * 
+     * @param output The destination.
+     * @param size The number of bytes.
+     */
+    inline void generate(std::uint8_t* output, std::size_t size)
+    {
+        if (!output && size > 0)
+        {
+            throw std::runtime_error("Output must not be null.");
+        }
+
+        checkFork();
+        while (size > 0)
+        {
+            if (m_position == BUFFER_SIZE && size >= BUFFER_SIZE)
+            {
+                std::size_t direct = size / BUFFER_SIZE * BUFFER_SIZE;
+                for (std::size_t done = 0; done < direct; done += BUFFER_SIZE)
+                {
+                    refill(output + done, BUFFER_SIZE);
+                }
+                output += direct;
+                size -= direct;
+                continue;
+            }
+            if (m_position == BUFFER_SIZE)
+            {
+                refill(m_buffer, BUFFER_SIZE);
+                m_position = 0;
+            }
+
+            std::size_t count = std::min(size, BUFFER_SIZE - m_position);
+            std::memcpy(output, m_buffer + m_position, count);
+            std::memset(m_buffer + m_position, 0, count);
+            m_position += count;
+            output += count;
+            size -= count;
+        }
+    }
+
+    /**
+     * @brief Mixes fresh entropy from std::random_device into the state and discards buffered output.
+     */
+    inline void reseed()
+    {
+        watchForks();
+        m_forks = forkGeneration().load(std::memory_order_relaxed);
+
+        std::random_device device;
+        std::uint8_t entropy[SEED_SIZE];
+        for (std::size_t i = 0; i < SEED_SIZE; i += 4)
+        {
+            std::uint32_t word = static_cast<std::uint32_t>(device());
+            std::memcpy(entropy + i, &word, 4);
+        }
+        reseed(entropy, SEED_SIZE);
+        secureZero(entropy, sizeof(entropy));
+    }
+
+    /**
+     * @brief Mixes caller-supplied entropy into the state and discards buffered output.
+     * 
+     * @param entropy The entropy input, shorter inputs are zero-padded.
+     * @param size The size of the entropy input in bytes, at most SEED_SIZE.
+     * 
+     * @throws std::runtime_error if the input is null or too long.
+     */
+    inline void reseed(const std::uint8_t* entropy, std::size_t size)
+    {
+        if (!entropy || size > SEED_SIZE)
+        {
+            throw std::runtime_error("Seed material must be at most 48 bytes.");
+        }
+
+        std::uint8_t material[SEED_SIZE] = {};
+        std::memcpy(material, entropy, size);
+        update(material);
+        secureZero(material, sizeof(material));
+        secureZero(m_buffer, sizeof(m_buffer));
+        m_batches = 0;
+        m_position = BUFFER_SIZE;
+    }
+
+    /**
+     * @brief Returns the calling thread's own generator, seeded from std::random_device on first use.
+     * 
+     * The instance reseeds itself in a child process after fork().
+     */
+    static inline ctr_drbg& local()
+    {
+        thread_local ctr_drbg instance;
+        return instance;
+    }
+
+private:
+    static constexpr std::uint8_t ZERO_KEY[32] = {};
+
+    basic_key_schedule<14> m_schedule;                // Current key.
+    std::uint8_t m_counter[16] = {};                  // Current counter block (V).
+    alignas(16) std::uint8_t m_buffer[BUFFER_SIZE];   // Batch being handed out.
+    std::size_t m_position = BUFFER_SIZE;             // Next unused byte of the batch.
+    std::uint64_t m_batches = 0;                      // Batches since the last reseed.
+    std::uint64_t m_forks = 0;                        // forkGeneration() at the last automatic reseed.
+    bool m_automatic;                                 // Whether to reseed from std::random_device.
+
+    // Number of fork() calls this process descends from, counted by a pthread_atfork child handler
+    static inline std::atomic<std::uint64_t>& forkGeneration() noexcept
+    {
+        static std::atomic<std::uint64_t> generation{0};
+        return generation;
+    }
+
+    static inline void watchForks() noexcept
+    {
+#ifndef _WIN32
+        static const bool registered = pthread_atfork(nullptr, nullptr, []() { forkGeneration().fetch_add(1, std::memory_order_relaxed); }) == 0;
+        (void)registered;
+#endif
+    }
+
+    // A child process must not hand out the parent's buffered bytes or continue its stream
+    inline void checkFork()
+    {
+        if (m_automatic && forkGeneration().load(std::memory_order_relaxed) != m_forks)
+        {
+            reseed();
+        }
+    }
+
+    inline void advance(std::uint64_t blocks) noexcept
+    {
+        std::uint64_t high = loadBigEndian(m_counter);
+        std::uint64_t low = loadBigEndian(m_counter + 8);
+        std::uint64_t sum = low + blocks;
+        storeBigEndian(high + (sum < low), m_counter);
+        storeBigEndian(sum, m_counter + 8);
+    }
+
+    // CTR_DRBG_Update: the next three blocks, XORed with the provided data, become the new key and counter.
+    inline void update(const std::uint8_t provided[SEED_SIZE])
+    {
+        std::uint8_t temp[SEED_SIZE];
+        for (std::size_t i = 0; i < SEED_SIZE; i += 16)
+        {
+            advance(1);
+            m_schedule.encryptBlock(m_counter, temp + i);
+        }
+        if (provided)
+        {
+            xorBytes(temp, provided, temp, SEED_SIZE);
+        }
+
+        m_schedule = basic_key_schedule<14>(temp, Backend::Automatic, KeyUsage::EncryptOnly);
+        std::memcpy(m_counter, temp + 32, 16);
+        secureZero(temp, sizeof(temp));
+    }
+
+    inline void refill(std::uint8_t* output, std::size_t size)
+    {
+        if (m_automatic && m_batches >= RESEED_INTERVAL)
+        {
+            reseed();
+        }
+
+        // The batch is E(K, V+1) .. E(K, V+n): the key stream of CTR over zeros starting at V+1.
+        advance(1);
+        std::memset(output, 0, size);
+        ctr(m_schedule, m_counter, output, output, size, 0, 1);
+        advance(size / 16 - 1);
+        update(nullptr);
+        ++m_batches;
+    }
+}; // class ctr_drbg
+
+inline constexpr std::size_t MULTI_KEY_LANES = 8; // Independent key/block lanes interleaved per group.
+
+#ifdef NSTD_AES_X86
+/**
+ * @brief Runs Lanes blocks, each under its own key, through AES-NI in lockstep.
+ * 
+ * Lanes share no round keys, so each round loads one key per lane; the instructions of
+ * different lanes are still independent and overlap in the pipeline. The lane count is a
+ * template parameter so the lane states stay in registers.
+ */
+template <bool Encrypt, std::size_t Lanes, int Rounds>
+NSTD_AES_TARGET inline void multiKeyHardware(const basic_key_schedule<Rounds>* const* schedules, const std::uint8_t* input, std::uint8_t* output) noexcept
+{
+    const std::uint8_t* keys[Lanes];
+    __m128i b[Lanes];
+    for (std::size_t j = 0; j < Lanes; ++j)
+    {
+        keys[j] = Encrypt ? schedules[j]->encryptionKeys() : schedules[j]->decryptionKeys();
+        b[j] = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + j * 16)),
+                             _mm_load_si128(reinterpret_cast<const __m128i*>(keys[j])));
+    }
+    for (int round = 1; round < Rounds; ++round)
+    {
+        for (std::size_t j = 0; j < Lanes; ++j)
+        {
+            __m128i rk = _mm_load_si128(reinterpret_cast<const __m128i*>(keys[j] + round * 16));
+            b[j] = Encrypt ? _mm_aesenc_si128(b[j], rk) : _mm_aesdec_si128(b[j], rk);
+        }
+    }
+    for (std::size_t j = 0; j < Lanes; ++j)
+    {
+        __m128i rk = _mm_load_si128(reinterpret_cast<const __m128i*>(keys[j] + Rounds * 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + j * 16), Encrypt ? _mm_aesenclast_si128(b[j], rk) : _mm_aesdeclast_si128(b[j], rk));
+    }
+}
+#endif
+
+/**
+ * @brief Runs up to MULTI_KEY_LANES blocks, each under its own key, through the bitsliced engine.
+ * 
+ * Each block occupies one bit of every plane, so bitslicing the lanes' round keys the same
+ * way gives key planes that hold a different key per block.
+ */
+template <bool Encrypt, int Rounds>
+inline void multiKeyBitsliced(const basic_key_schedule<Rounds>* const* schedules, const std::uint8_t* input, std::uint8_t* output, std::size_t lanes) noexcept
+{
+    const std::uint8_t* keys[MULTI_KEY_LANES];
+    for (std::size_t j = 0; j < lanes; ++j)
+    {
+        keys[j] = Encrypt ? schedules[j]->encryptionKeys() : schedules[j]->decryptionKeys();
+    }
+
+    auto addRoundKeys = [&](bit_plane q[8], int round)
+    {
+        alignas(16) std::uint8_t roundKeys[MULTI_KEY_LANES * 16];
+        for (std::size_t j = 0; j < lanes; ++j)
+        {
+            std::memcpy(roundKeys + j * 16, keys[j] + round * 16, 16);
+        }
+
+        bit_plane k[8];
+        bitslice(roundKeys, lanes, k);
+        for (int i = 0; i < 8; ++i)
+        {
+            q[i] = q[i] ^ k[i];
+        }
+    };
+
+    bit_plane q[8];
+    bitslice(input, lanes, q);
+    addRoundKeys(q, 0);
+    for (int round = 1; round <= Rounds; ++round)
+    {
+        if constexpr (Encrypt)
+        {
+            bitslicedSubBytes(q);
+            for (int k = 0; k < 8; ++k)
+            {
+                q[k] = q[k].rotateLanes<true>(); // ShiftRows
+            }
+            if (round < Rounds)
+            {
+                bitslicedMixColumns(q);
+            }
+        }
+        else
+        {
+            bitslicedInverseSubBytes(q);
+            for (int k = 0; k < 8; ++k)
+            {
+                q[k] = q[k].rotateLanes<false>(); // InvShiftRows
+            }
+            if (round < Rounds)
+            {
+                bitslicedInverseMixColumns(q);
+            }
+        }
+        addRoundKeys(q, round);
+    }
+    unbitslice(q, output, lanes);
+}
+
+// Shared body of multiKeyEncrypt() and multiKeyDecrypt(): dispatches each group of lanes by backend
+template <bool Encrypt, int Rounds>
+inline void multiKey(const basic_key_schedule<Rounds>* const* schedules, const std::uint8_t* input, std::uint8_t* output, std::size_t blocks)
+{
+    if ((!schedules || !input || !output) && blocks > 0)
+    {
+        throw std::runtime_error("Schedules, input and output must not be null.");
+    }
+    if constexpr (!Encrypt)
+    {
+        for (std::size_t i = 0; i < blocks; ++i)
+        {
+            schedules[i]->requireInverse();
+        }
+    }
+
+    for (std::size_t i = 0; i < blocks; i += MULTI_KEY_LANES)
+    {
+        std::size_t lanes = std::min(MULTI_KEY_LANES, blocks - i);
+        const basic_key_schedule<Rounds>* const* group = schedules + i;
+        auto all = [&](Backend backend)
+        {
+            return std::all_of(group, group + lanes, [&](const basic_key_schedule<Rounds>* schedule) { return schedule->backend() == backend; });
+        };
+
+#ifdef NSTD_AES_X86
+        if (all(Backend::Hardware))
+        {
+            if (lanes == MULTI_KEY_LANES)
+            {
+                multiKeyHardware<Encrypt, MULTI_KEY_LANES>(group, input + i * 16, output + i * 16);
+                continue;
+            }
+            for (std::size_t j = 0; j < lanes; ++j)
+            {
+                multiKeyHardware<Encrypt, 1>(group + j, input + (i + j) * 16, output + (i + j) * 16);
+            }
+            continue;
+        }
+#endif
+        if (all(Backend::Bitsliced))
+        {
+            multiKeyBitsliced<Encrypt>(group, input + i * 16, output + i * 16, lanes);
+            continue;
+        }
+
+        // Reference, Table or a mix of backends: one block at a time
+        for (std::size_t j = 0; j < lanes; ++j)
+        {
+            if constexpr (Encrypt)
+            {
+                group[j]->encryptBlock(input + (i + j) * 16, output + (i + j) * 16);
+            }
+            else
+            {
+                group[j]->decryptBlock(input + (i + j) * 16, output + (i + j) * 16);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Encrypts a batch of blocks where every block has its own key; input and output may alias.
+ * 
+ * Blocks are processed in groups of MULTI_KEY_LANES. A group whose schedules all use the
+ * Hardware or all use the Bitsliced backend goes through the round function together;
+ * other groups fall back to one block at a time.
+ * 
+ * @param schedules One schedule per block.
+ * @param input The input blocks.
+ * @param output The output blocks.
+ * @param blocks The number of 16-byte blocks.
+ * 
+ * @throws std::runtime_error if a pointer is null.
+ */
+template <int Rounds>
+inline void multiKeyEncrypt(const basic_key_schedule<Rounds>* const* schedules, const std::uint8_t* input, std::uint8_t* output, std::size_t blocks)
+{
+    multiKey<true>(schedules, input, output, blocks);
+}
+
+/**
+ * @brief Decrypts a batch of blocks where every block has its own key; input and output may alias.
+ * 
+ * @param schedules One schedule per block.
+ * @param input The input blocks.
+ * @param output The output blocks.
+ * @param blocks The number of 16-byte blocks.
+ * 
+ * @throws std::runtime_error if a pointer is null or a schedule is encrypt-only.
+ */
+template <int Rounds>
+inline void multiKeyDecrypt(const basic_key_schedule<Rounds>* const* schedules, const std::uint8_t* input, std::uint8_t* output, std::size_t blocks)
+{
+    multiKey<false>(schedules, input, output, blocks);
+}
+
+/**
+ * @brief A least-recently-used cache of expanded key schedules, for traffic that switches keys often.
+ * 
+ * Lookups hash the raw key with SipHash-2-4 under a per-cache random 128-bit key, so chosen keys
+ * cannot force bucket collisions.
+ * When the cache is full, a miss reuses the least recently used entry in place. Not thread-safe.
+ */
+template <int Rounds>
+class basic_schedule_cache
+{
+public:
+    using schedule_type = basic_key_schedule<Rounds>;
+
+    static constexpr std::size_t KEY_SIZE = schedule_type::KEY_SIZE;
+
+    /**
+     * @brief Constructs an empty cache.
+     * 
+     * @param capacity The maximum number of schedules kept.
+     * @param backend The backend of the schedules it builds.
+     * 
+     * @throws std::runtime_error if the capacity is zero.
+     */
+    explicit basic_schedule_cache(std::size_t capacity, Backend backend = Backend::Automatic)
+        : m_capacity(capacity), m_backend(backend), m_index(0, key_hash::random())
+    {
+        if (capacity == 0)
+        {
+            throw std::runtime_error("Cache capacity must be positive.");
+        }
+        m_index.reserve(capacity);
+    }
+
+    /**
+     * @brief Returns the schedule for a key, expanding it on a miss.
+     * 
+     * The reference stays valid until the entry is evicted, i.e. for at least the next
+     * capacity() - 1 lookups, so a batch of up to capacity() keys can be gathered before use.
+     * 
+     * @param key The key (KEY_SIZE bytes).
+     * 
+     * @throws std::runtime_error if the key is null.
+     * @throws std::bad_alloc if a Bitsliced schedule cannot be allocated; the cache is left unchanged.
+     */
+    inline const schedule_type& get(const std::uint8_t* key)
+    {
+        if (!key)
+        {
+            throw std::runtime_error("Key must not be null.");
+        }
+
+        key_type lookup;
+        std::memcpy(lookup.data(), key, KEY_SIZE);
+        auto found = m_index.find(lookup);
+        if (found != m_index.end())
+        {
+            ++m_hits;
+            m_entries.splice(m_entries.begin(), m_entries, found->second);
+            return found->second->schedule;
+        }
+
+        ++m_misses;
+        // Expand first: if that throws, the cache is left as it was
+        schedule_type schedule(key, m_backend);
+        if (m_entries.size() == m_capacity)
+        {
+            // Reuse the least recently used node rather than allocating a new one
+            auto oldest = std::prev(m_entries.end());
+            m_index.erase(oldest->key);
+            oldest->key = lookup;
+            oldest->schedule = schedule;
+            m_entries.splice(m_entries.begin(), m_entries, oldest);
+        }
+        else
+        {
+            m_entries.push_front(entry{lookup, schedule});
+        }
+        m_index.emplace(lookup, m_entries.begin());
+        return m_entries.front().schedule;
+    }
+
+    /**
+     * @brief Drops every cached schedule.
+     */
+    inline void clear() noexcept
+    {
+        m_index.clear();
+        m_entries.clear();
+    }
+
+    inline std::size_t size() const noexcept { return m_entries.size(); }
+    inline std::size_t capacity() const noexcept { return m_capacity; }
+    inline std::uint64_t hits() const noexcept { return m_hits; }
+    inline std::uint64_t misses() const noexcept { return m_misses; }
+
+private:
+    using key_type = std::array<std::uint8_t, KEY_SIZE>;
+
+    struct entry
+    {
+        key_type key;
+        schedule_type schedule;
+    };
+
+    // SipHash-2-4; KEY_SIZE is a multiple of 8, so the final block only carries the length
+    struct key_hash
+    {
+        std::uint64_t k0;
+        std::uint64_t k1;
+
+        static inline key_hash random()
+        {
+            std::random_device device;
+            std::uint64_t words[4];
+            for (std::uint64_t& word : words)
+            {
+                word = static_cast<std::uint32_t>(device());
+            }
+            return key_hash{words[0] << 32 | words[1], words[2] << 32 | words[3]};
+        }
+
+        static inline void round(std::uint64_t& v0, std::uint64_t& v1, std::uint64_t& v2, std::uint64_t& v3) noexcept
+        {
+            v0 += v1; v1 = std::rotl(v1, 13); v1 ^= v0; v0 = std::rotl(v0, 32);
+            v2 += v3; v3 = std::rotl(v3, 16); v3 ^= v2;
+            v0 += v3; v3 = std::rotl(v3, 21); v3 ^= v0;
+            v2 += v1; v1 = std::rotl(v1, 17); v1 ^= v2; v2 = std::rotl(v2, 32);
+        }
+
+        inline std::size_t operator()(const key_type& key) const noexcept
+        {
+            std::uint64_t v0 = k0 ^ 0x736f6d6570736575ull;
+            std::uint64_t v1 = k1 ^ 0x646f72616e646f6dull;
+            std::uint64_t v2 = k0 ^ 0x6c7967656e657261ull;
+            std::uint64_t v3 = k1 ^ 0x7465646279746573ull;
+            auto compress = [&](std::uint64_t word)
+            {
+                v3 ^= word;
+                round(v0, v1, v2, v3);
+                round(v0, v1, v2, v3);
+                v0 ^= word;
+            };
+
+            for (std::size_t i = 0; i < KEY_SIZE; i += 8)
+            {
+                std::uint64_t word = 0;
+                for (std::size_t j = 0; j < 8; ++j)
+                {
+                    word |= static_cast<std::uint64_t>(key[i + j]) << (8 * j);
+                }
+                compress(word);
+            }
+            compress(static_cast<std::uint64_t>(KEY_SIZE) << 56);
+
+            v2 ^= 0xff;
+            for (int i = 0; i < 4; ++i)
+            {
+                round(v0, v1, v2, v3);
+            }
+            return static_cast<std::size_t>(v0 ^ v1 ^ v2 ^ v3);
+        }
+    };
+
+    std::size_t m_capacity;                                                           // Maximum number of entries.
+    Backend m_backend;                                                                // Backend of new schedules.
+    std::list<entry> m_entries;                                                       // Most recently used first.
+    std::unordered_map<key_type, typename std::list<entry>::iterator, key_hash> m_index; // Key to entry.
+    std::uint64_t m_hits = 0;                                                         // Lookups served from the cache.
+    std::uint64_t m_misses = 0;                                                       // Lookups that expanded a key.
+}; // class basic_schedule_cache
+
+using schedule_cache = basic_schedule_cache<10>;    // AES-128 schedules
+using schedule_cache192 = basic_schedule_cache<12>; // AES-192 schedules
+using schedule_cache256 = basic_schedule_cache<14>; // AES-256 schedules
 
 } // namespace aes
 
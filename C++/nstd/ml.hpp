@@ -1,144 +1,5039 @@
 #pragma once
 
-#ifdef NEURALNETWORK
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <numbers>
+#include <numeric>
+#include <random>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+
+#else
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#endif
+
+namespace nstd
+{
+
+/**
+ * @brief Machine Learning.
+ */
+namespace ML
+{
+
+/**
+ * @brief A dense row-major matrix of doubles stored in a single contiguous buffer.
+ */
+class Matrix
+{
+public:
+    /**
+     * @brief Constructs an empty matrix.
+     */
+    Matrix() : m_rows(0), m_cols(0) {}
+
+    /**
+     * @brief Constructs a matrix of the given shape.
+     * 
+     * @param rows The number of rows.
+     * @param cols The number of columns.
+     * @param value The value every element is initialized to.
+     */
+    Matrix(std::size_t rows, std::size_t cols, double value = 0.0) : m_rows(rows), m_cols(cols), m_data(rows * cols, value) {}
+
+    /**
+     * @brief Packs a vector of rows into a contiguous matrix.
+     * 
+     * @param x A 2D vector of input features, all rows of the same length.
+     * 
+     * @throws std::invalid_argument if the rows have different lengths.
+     */
+    explicit Matrix(const std::vector<std::vector<double>>& x) : m_rows(x.size()), m_cols(x.empty() ? 0 : x[0].size())
+    {
+        m_data.resize(m_rows * m_cols);
+        for (std::size_t i = 0; i < m_rows; ++i)
+        {
+            if (x[i].size() != m_cols)
+            {
+                throw std::invalid_argument("All rows must have the same number of features");
+            }
+            std::copy(x[i].begin(), x[i].end(), row(i));
+        }
+    }
+
+    /**
+     * @brief Changes the shape of the matrix, discarding its contents.
+     * 
+     * @param rows The new number of rows.
+     * @param cols The new number of columns.
+     */
+    inline void resize(std::size_t rows, std::size_t cols)
+    {
+        m_rows = rows;
+        m_cols = cols;
+        m_data.assign(rows * cols, 0.0);
+    }
+
+    inline std::size_t rows() const noexcept { return m_rows; }
+    inline std::size_t cols() const noexcept { return m_cols; }
+
+    inline double* data() noexcept { return m_data.data(); }
+    inline const double* data() const noexcept { return m_data.data(); }
+
+    inline double* row(std::size_t i) noexcept { return m_data.data() + i * m_cols; }
+    inline const double* row(std::size_t i) const noexcept { return m_data.data() + i * m_cols; }
+
+    inline double& operator()(std::size_t i, std::size_t j) noexcept { return m_data[i * m_cols + j]; }
+    inline double operator()(std::size_t i, std::size_t j) const noexcept { return m_data[i * m_cols + j]; }
+
+private:
+    std::size_t m_rows;         // Number of rows.
+    std::size_t m_cols;         // Number of columns.
+    std::vector<double> m_data; // Row-major element storage.
+}; // class Matrix
+
+/**
+ * @brief Resolves the number of worker threads to use for a parallel loop.
+ * 
+ * @param threads The requested number of threads (0 selects the hardware concurrency).
+ * @param count The number of iterations to distribute.
+ * 
+ * @return The number of threads, never more than count and never less than 1.
+ */
+inline unsigned threadCount(unsigned threads, std::size_t count) noexcept
+{
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    return static_cast<unsigned>(std::max<std::size_t>(1, std::min<std::size_t>(threads, count)));
+}
+
+/**
+ * @brief Splits [0, count) into contiguous chunks and runs them on worker threads.
+ * 
+ * The first chunk runs on the calling thread. Chunk t is always handed thread index t,
+ * so callers can keep per-thread accumulators sized with threadCount().
+ * 
+ * @param count The number of iterations.
+ * @param threads The requested number of threads (0 selects the hardware concurrency).
+ * @param func A callable invoked as func(begin, end, thread_index).
+ */
+template <typename Func>
+inline void parallelFor(std::size_t count, unsigned threads, Func&& func)
+{
+    threads = threadCount(threads, count);
+    if (threads == 1)
+    {
+        func(std::size_t(0), count, 0u);
+        return;
+    }
+
+    std::size_t chunk = (count + threads - 1) / threads;
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (unsigned t = 1; t < threads; ++t)
+    {
+        std::size_t begin = std::min(count, t * chunk);
+        std::size_t end = std::min(count, begin + chunk);
+        workers.emplace_back([&func, begin, end, t]() { func(begin, end, t); });
+    }
+
+    func(std::size_t(0), std::min(count, chunk), 0u);
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+/**
+ * @brief Computes the squared Euclidean distance between two points.
+ * 
+ * Uses four independent accumulators so the loop vectorizes without -ffast-math.
+ * 
+ * @param a The first point.
+ * @param b The second point.
+ * @param n The number of dimensions.
+ * 
+ * @return The squared distance.
+ */
+inline double squaredDistance(const double* a, const double* b, std::size_t n) noexcept
+{
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        double d0 = a[i] - b[i];
+        double d1 = a[i + 1] - b[i + 1];
+        double d2 = a[i + 2] - b[i + 2];
+        double d3 = a[i + 3] - b[i + 3];
+        s0 += d0 * d0;
+        s1 += d1 * d1;
+        s2 += d2 * d2;
+        s3 += d3 * d3;
+    }
+
+    for (; i < n; ++i)
+    {
+        double d = a[i] - b[i];
+        s0 += d * d;
+    }
+
+    return (s0 + s1) + (s2 + s3);
+}
+
+/**
+ * @brief Accuracy tiers for the exp and log kernels used in the training loops.
+ */
+enum class MathPrecision
+{
+    Exact, // The standard library functions.
+    High,  // Branch-free polynomials, relative error around 1e-15.
+    Fast   // Branch-free polynomials of lower degree, relative error below 2e-7.
+};
+
+/**
+ * @brief Approximates e^x.
+ * 
+ * Splits x into n * ln(2) + r with |r| <= ln(2) / 2, evaluates a Taylor polynomial
+ * in r and scales by 2^n through the exponent bits. There are no branches or table
+ * lookups, so loops over arrays vectorize. Inputs above 709 are clamped, inputs below
+ * -708 return 0 (std::exp would return a subnormal there, or 0 below about -745).
+ * 
+ * @param x The exponent.
+ * 
+ * @return e^x.
+ */
+template <MathPrecision Precision>
+inline double approxExp(double x) noexcept
+{
+    if constexpr (Precision == MathPrecision::Exact)
+    {
+        return std::exp(x);
+    }
+    else
+    {
+        constexpr double SHIFTER = 6755399441055744.0; // 1.5 * 2^52, rounds to an integer in the low mantissa bits
+        constexpr double LN2_HI = 6.93147180369123816490e-01;
+        constexpr double LN2_LO = 1.90821492927058770002e-10;
+
+        const double input = x;
+        x = std::min(std::max(x, -708.0), 709.0);
+        const double shifted = x * std::numbers::log2e + SHIFTER;
+        const double n = shifted - SHIFTER;
+        const double r = (x - n * LN2_HI) - n * LN2_LO;
+
+        double p;
+        if constexpr (Precision == MathPrecision::Fast)
+        {
+            p = 1.0 + r * (1.0 + r * (1.0 / 2 + r * (1.0 / 6 + r * (1.0 / 24 + r * (1.0 / 120 + r * (1.0 / 720))))));
+        }
+        else
+        {
+            p = 1.0 / 479001600;
+            p = p * r + 1.0 / 39916800;
+            p = p * r + 1.0 / 3628800;
+            p = p * r + 1.0 / 362880;
+            p = p * r + 1.0 / 40320;
+            p = p * r + 1.0 / 5040;
+            p = p * r + 1.0 / 720;
+            p = p * r + 1.0 / 120;
+            p = p * r + 1.0 / 24;
+            p = p * r + 1.0 / 6;
+            p = p * r + 1.0 / 2;
+            p = p * r + 1.0;
+            p = p * r + 1.0;
+        }
+
+        const std::uint64_t scale = (std::bit_cast<std::uint64_t>(shifted) + 1023) << 52;
+        // Results that would be subnormal flush to zero, through a select rather than a branch
+        const double result = p * std::bit_cast<double>(scale);
+        return input < -708.0 ? 0.0 : result;
+    }
+}
+
+/**
+ * @brief Approximates log2(x) for positive normal x.
+ * 
+ * Splits x into m * 2^e with m in [sqrt(1/2), sqrt(2)) through the exponent bits and
+ * evaluates the atanh series of ln(m). Branch-free, so loops over arrays vectorize.
+ * 
+ * @param x The argument, positive and normal.
+ * 
+ * @return log2(x).
+ */
+template <MathPrecision Precision>
+inline double approxLog2(double x) noexcept
+{
+    if constexpr (Precision == MathPrecision::Exact)
+    {
+        return std::log2(x);
+    }
+    else
+    {
+        constexpr double EXPONENT_BIAS = 4503599627370496.0 + 1023.0; // 2^52 + bias, see below
+        const std::uint64_t bits = std::bit_cast<std::uint64_t>(x);
+
+        // Reads the biased exponent as a double by placing it in the mantissa of 2^52
+        double e = std::bit_cast<double>(0x4330000000000000ull | (bits >> 52)) - EXPONENT_BIAS;
+        double m = std::bit_cast<double>((bits & 0x000fffffffffffffull) | 0x3ff0000000000000ull);
+        const bool above = m > std::numbers::sqrt2;
+        m = above ? m * 0.5 : m;
+        e = above ? e + 1.0 : e;
+
+        const double s = (m - 1.0) / (m + 1.0);
+        const double z = s * s;
+        double p;
+        if constexpr (Precision == MathPrecision::Fast)
+        {
+            p = 1.0 + z * (1.0 / 3 + z * (1.0 / 5 + z * (1.0 / 7)));
+        }
+        else
+        {
+            p = 1.0 / 19;
+            p = p * z + 1.0 / 17;
+            p = p * z + 1.0 / 15;
+            p = p * z + 1.0 / 13;
+            p = p * z + 1.0 / 11;
+            p = p * z + 1.0 / 9;
+            p = p * z + 1.0 / 7;
+            p = p * z + 1.0 / 5;
+            p = p * z + 1.0 / 3;
+            p = p * z + 1.0;
+        }
+
+        return e + 2.0 * s * p * std::numbers::log2e;
+    }
+}
+
+/**
+ * @brief Replaces every value of an array with its exponential.
+ * 
+ * @param values The array.
+ * @param n The number of values.
+ */
+template <MathPrecision Precision>
+inline void expInPlace(double* values, std::size_t n) noexcept
+{
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        values[i] = approxExp<Precision>(values[i]);
+    }
+}
+
+/**
+ * @brief Replaces every value of an array with its exponential at a runtime-selected precision.
+ * 
+ * @param values The array.
+ * @param n The number of values.
+ * @param precision The accuracy tier.
+ */
+inline void expInPlace(double* values, std::size_t n, MathPrecision precision) noexcept
+{
+    switch (precision)
+    {
+    case MathPrecision::Exact: expInPlace<MathPrecision::Exact>(values, n); break;
+    case MathPrecision::High: expInPlace<MathPrecision::High>(values, n); break;
+    case MathPrecision::Fast: expInPlace<MathPrecision::Fast>(values, n); break;
+    }
+}
+
+/**
+ * @brief The random engine used by every model.
+ */
+using Engine = std::mt19937_64;
+
+/**
+ * @brief The seed models use when none is given, so runs are reproducible by default.
+ */
+constexpr std::uint64_t DEFAULT_SEED = 5489u;
+
+/**
+ * @brief Scrambles a 64-bit value with the SplitMix64 finalizer.
+ * 
+ * @param x The value to scramble.
+ * 
+ * @return The scrambled value.
+ */
+constexpr std::uint64_t splitMix64(std::uint64_t x) noexcept
+{
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * @brief Creates the engine for one stream of a seed.
+ * 
+ * Different streams of the same seed are statistically independent, so parallel work
+ * can give every task (a tree, a fold, a thread) its own stream and stay reproducible
+ * regardless of how many threads run it.
+ * 
+ * @param seed The seed of the run.
+ * @param stream The index of the stream within the run.
+ * 
+ * @return A freshly seeded engine.
+ */
+inline Engine makeEngine(std::uint64_t seed, std::uint64_t stream = 0)
+{
+    std::uint64_t a = splitMix64(seed);
+    std::uint64_t b = splitMix64(a ^ splitMix64(stream));
+    std::seed_seq sequence{ static_cast<std::uint32_t>(a), static_cast<std::uint32_t>(a >> 32),
+                            static_cast<std::uint32_t>(b), static_cast<std::uint32_t>(b >> 32) };
+    return Engine(sequence);
+}
+
+/**
+ * @brief A read-only view of selected rows of a data set.
+ * 
+ * Views share the feature rows and labels they were created from, so many training
+ * jobs (folds, bootstrap samples, parameter settings) can work on the same data set
+ * without copying it. The referenced data and indices must outlive the view.
+ */
+class DataView
+{
+public:
+    /**
+     * @brief Constructs a view of every row of a data set.
+     * 
+     * @param x A 2D vector of input features.
+     * @param y A vector of target class labels.
+     */
+    DataView(const std::vector<std::vector<double>>& x, const std::vector<int>& y)
+        : m_x(&x), m_y(&y), m_all(true) {}
+
+    /**
+     * @brief Constructs a view of selected rows of a data set.
+     * 
+     * @param x A 2D vector of input features.
+     * @param y A vector of target class labels.
+     * @param indices The rows of the view, repeats allowed.
+     */
+    DataView(const std::vector<std::vector<double>>& x, const std::vector<int>& y, std::span<const std::size_t> indices)
+        : m_x(&x), m_y(&y), m_indices(indices), m_all(false) {}
+
+    inline std::size_t size() const noexcept { return m_all ? m_x->size() : m_indices.size(); }
+
+    /**
+     * @brief Returns the row of the underlying data set behind position i of the view.
+     */
+    inline std::size_t index(std::size_t i) const noexcept { return m_all ? i : m_indices[i]; }
+
+    inline const std::vector<double>& row(std::size_t i) const noexcept { return (*m_x)[index(i)]; }
+    inline int label(std::size_t i) const noexcept { return (*m_y)[index(i)]; }
+
+    inline const std::vector<std::vector<double>>& features() const noexcept { return *m_x; }
+    inline const std::vector<int>& labels() const noexcept { return *m_y; }
+
+private:
+    const std::vector<std::vector<double>>* m_x; // Feature rows of the whole data set.
+    const std::vector<int>* m_y;                 // Labels of the whole data set.
+    std::span<const std::size_t> m_indices;      // Selected rows, unless m_all is set.
+    bool m_all;                                  // Whether the view covers every row in order.
+}; // class DataView
+
+/**
+ * @brief A source of training rows that can be streamed in chunks.
+ * 
+ * Out-of-core learners only ever hold one chunk in memory, so data sets far larger
+ * than RAM can be trained on.
+ */
+class DataSource
+{
+public:
+    virtual ~DataSource() = default;
+
+    virtual std::size_t rows() const = 0;
+    virtual std::size_t features() const = 0;
+
+    /**
+     * @brief Copies rows [begin, end) into a row-major chunk.
+     * 
+     * @param begin The first row.
+     * @param end One past the last row.
+     * @param x Receives the features, one row per sample; reused if its shape matches.
+     * @param y Receives the class labels.
+     */
+    virtual void readChunk(std::size_t begin, std::size_t end, Matrix& x, std::vector<int>& y) const = 0;
+
+    /**
+     * @brief Copies the class labels of rows [begin, end).
+     * 
+     * @param begin The first row.
+     * @param end One past the last row.
+     * @param y Receives the class labels.
+     */
+    virtual void readLabels(std::size_t begin, std::size_t end, std::vector<int>& y) const = 0;
+
+    /**
+     * @brief Hints that rows [begin, end) will be read soon.
+     */
+    virtual void prefetch(std::size_t, std::size_t) const {}
+
+    /**
+     * @brief Hints that rows [begin, end) will not be read again for a while.
+     */
+    virtual void release(std::size_t, std::size_t) const {}
+};
+
+/**
+ * @brief A DataSource over in-memory rows, so out-of-core learners also accept ordinary data.
+ */
+class MemoryDataSource : public DataSource
+{
+public:
+    /**
+     * @brief Constructs a source over every row of a data set; the data must outlive the source.
+     * 
+     * @param x A 2D vector of input features.
+     * @param y A vector of target class labels.
+     */
+    MemoryDataSource(const std::vector<std::vector<double>>& x, const std::vector<int>& y) : m_x(x), m_y(y) {}
+
+    inline std::size_t rows() const override { return m_x.size(); }
+    inline std::size_t features() const override { return m_x.empty() ? 0 : m_x[0].size(); }
+
+    inline void readChunk(std::size_t begin, std::size_t end, Matrix& x, std::vector<int>& y) const override
+    {
+        if (x.rows() != end - begin || x.cols() != features())
+        {
+            x.resize(end - begin, features());
+        }
+
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            std::copy(m_x[i].begin(), m_x[i].end(), x.row(i - begin));
+        }
+        readLabels(begin, end, y);
+    }
+
+    inline void readLabels(std::size_t begin, std::size_t end, std::vector<int>& y) const override
+    {
+        y.assign(m_y.begin() + begin, m_y.begin() + end);
+    }
+
+private:
+    const std::vector<std::vector<double>>& m_x; // Feature rows.
+    const std::vector<int>& m_y;                 // Class labels.
+}; // class MemoryDataSource
+
+/**
+ * @brief A file mapped into memory.
+ */
+class MappedFile
+{
+public:
+    /**
+     * @brief Access pattern hints for a mapped range.
+     */
+    enum class Advice
+    {
+        Sequential, // Read ahead aggressively.
+        WillNeed,   // Start reading the range in now.
+        DontNeed    // Drop the range from the working set.
+    };
+
+    MappedFile() = default;
+
+    /**
+     * @brief Maps an existing file read-only.
+     * 
+     * @param path The path of the file.
+     * 
+     * @throws std::runtime_error if the file cannot be opened or mapped.
+     */
+    explicit MappedFile(const std::string& path)
+    {
+        open(path, 0, false);
+    }
+
+    /**
+     * @brief Creates (or truncates) a file of the given size and maps it read-write.
+     * 
+     * @param path The path of the file.
+     * @param size The size of the file in bytes.
+     * 
+     * @throws std::runtime_error if the file cannot be created or mapped.
+     */
+    MappedFile(const std::string& path, std::size_t size)
+    {
+        open(path, size, true);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    MappedFile& operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other)
+        {
+            close();
+            m_data = std::exchange(other.m_data, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+#ifdef _WIN32
+            m_file = std::exchange(other.m_file, INVALID_HANDLE_VALUE);
+            m_mapping = std::exchange(other.m_mapping, nullptr);
+#else
+            m_fd = std::exchange(other.m_fd, -1);
+#endif
+        }
+        return *this;
+    }
+
+    ~MappedFile()
+    {
+        close();
+    }
+
+    inline std::uint8_t* data() const noexcept { return static_cast<std::uint8_t*>(m_data); }
+    inline std::size_t size() const noexcept { return m_size; }
+
+    /**
+     * @brief Passes an access pattern hint for a byte range to the kernel.
+     * 
+     * @param offset The first byte of the range.
+     * @param length The length of the range in bytes.
+     * @param advice The hint.
+     */
+    inline void advise(std::size_t offset, std::size_t length, Advice advice) const noexcept
+    {
+#ifdef _WIN32
+        (void)offset, (void)length, (void)advice; // No portable equivalent before PrefetchVirtualMemory
+#else
+        if (!m_data || length == 0)
+        {
+            return;
+        }
+
+        static const std::size_t page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        std::size_t begin = offset / page * page;
+        std::size_t end = std::min(m_size, offset + length);
+        int flag = advice == Advice::Sequential ? MADV_SEQUENTIAL : advice == Advice::WillNeed ? MADV_WILLNEED : MADV_DONTNEED;
+        madvise(data() + begin, end - begin, flag);
+#endif
+    }
+
+private:
+    void* m_data = nullptr; // Start of the mapping.
+    std::size_t m_size = 0; // Size of the mapping in bytes.
+#ifdef _WIN32
+    HANDLE m_file = INVALID_HANDLE_VALUE; // File handle.
+    HANDLE m_mapping = nullptr;           // File mapping handle.
+#else
+    int m_fd = -1;                        // File descriptor.
+#endif
+
+    inline void open(const std::string& path, std::size_t size, bool writable)
+    {
+#ifdef _WIN32
+        m_file = CreateFileA(path.c_str(), writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ, FILE_SHARE_READ, nullptr,
+                             writable ? CREATE_ALWAYS : OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE)
+        {
+            throw std::runtime_error("Failed to open " + path);
+        }
+
+        if (!writable)
+        {
+            LARGE_INTEGER file_size;
+            GetFileSizeEx(m_file, &file_size);
+            size = static_cast<std::size_t>(file_size.QuadPart);
+        }
+
+        m_mapping = CreateFileMappingA(m_file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY,
+                                       static_cast<DWORD>(static_cast<std::uint64_t>(size) >> 32), static_cast<DWORD>(size), nullptr);
+        m_data = m_mapping ? MapViewOfFile(m_mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size) : nullptr;
+#else
+        m_fd = ::open(path.c_str(), writable ? O_RDWR | O_CREAT | O_TRUNC : O_RDONLY, 0644);
+        if (m_fd < 0)
+        {
+            throw std::runtime_error("Failed to open " + path);
+        }
+
+        if (writable)
+        {
+            if (ftruncate(m_fd, static_cast<off_t>(size)) != 0)
+            {
+                close();
+                throw std::runtime_error("Failed to resize " + path);
+            }
+        }
+        else
+        {
+            struct stat info;
+            if (fstat(m_fd, &info) != 0)
+            {
+                close();
+                throw std::runtime_error("Failed to stat " + path);
+            }
+            size = static_cast<std::size_t>(info.st_size);
+        }
+
+        void* data = size ? mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, m_fd, 0) : MAP_FAILED;
+        m_data = data == MAP_FAILED ? nullptr : data;
+#endif
+        m_size = size;
+        if (!m_data)
+        {
+            close();
+            throw std::runtime_error("Failed to map " + path);
+        }
+    }
+
+    inline void close() noexcept
+    {
+#ifdef _WIN32
+        if (m_data) UnmapViewOfFile(m_data);
+        if (m_mapping) CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+        m_mapping = nullptr;
+        m_file = INVALID_HANDLE_VALUE;
+#else
+        if (m_data) munmap(m_data, m_size);
+        if (m_fd >= 0) ::close(m_fd);
+        m_fd = -1;
+#endif
+        m_data = nullptr;
+        m_size = 0;
+    }
+}; // class MappedFile
+
+inline constexpr char COLUMN_FILE_MAGIC[8] = { 'N', 'S', 'T', 'D', 'C', 'O', 'L', '1' }; // Identifies binary column files
+inline constexpr std::size_t COLUMN_FILE_HEADER = 64;                                       // Header size, keeps columns aligned
+
+/**
+ * @brief A DataSource backed by a memory-mapped binary column file.
+ * 
+ * Layout: a 64-byte header (magic, uint64 rows, uint64 features), then every feature
+ * column as rows doubles, then the labels as rows int32. Chunks are transposed into
+ * row-major matrices on read; reading the file is left to the page cache, steered
+ * with madvise read-ahead and release hints.
+ */
+class MappedDataset : public DataSource
+{
+public:
+    /**
+     * @brief Maps a binary column file.
+     * 
+     * @param path The path of a file written by convertCsv() or writeColumnFile().
+     * 
+     * @throws std::runtime_error if the file cannot be mapped or is not a column file.
+     */
+    explicit MappedDataset(const std::string& path) : m_file(path)
+    {
+        if (m_file.size() < COLUMN_FILE_HEADER || std::memcmp(m_file.data(), COLUMN_FILE_MAGIC, sizeof(COLUMN_FILE_MAGIC)) != 0)
+        {
+            throw std::runtime_error(path + " is not a column file");
+        }
+
+        std::memcpy(&m_rows, m_file.data() + 8, sizeof(m_rows));
+        std::memcpy(&m_features, m_file.data() + 16, sizeof(m_features));
+        // Divide rather than multiply, so a malformed header cannot overflow its way past the check
+        if (m_features > (std::numeric_limits<std::size_t>::max() - sizeof(std::int32_t)) / sizeof(double) ||
+            m_rows > (m_file.size() - COLUMN_FILE_HEADER) / (m_features * sizeof(double) + sizeof(std::int32_t)))
+        {
+            throw std::runtime_error(path + " is truncated");
+        }
+
+        m_file.advise(0, m_file.size(), MappedFile::Advice::Sequential);
+    }
+
+    inline std::size_t rows() const override { return m_rows; }
+    inline std::size_t features() const override { return m_features; }
+
+    /**
+     * @brief Returns a pointer to the values of one feature column.
+     */
+    inline const double* column(std::size_t j) const noexcept
+    {
+        return reinterpret_cast<const double*>(m_file.data() + COLUMN_FILE_HEADER) + j * m_rows;
+    }
+
+    /**
+     * @brief Returns a pointer to the class labels.
+     */
+    inline const std::int32_t* labels() const noexcept
+    {
+        return reinterpret_cast<const std::int32_t*>(m_file.data() + COLUMN_FILE_HEADER + m_features * m_rows * sizeof(double));
+    }
+
+    inline void readChunk(std::size_t begin, std::size_t end, Matrix& x, std::vector<int>& y) const override
+    {
+        if (x.rows() != end - begin || x.cols() != m_features)
+        {
+            x.resize(end - begin, m_features);
+        }
+
+        for (std::size_t j = 0; j < m_features; ++j)
+        {
+            const double* values = column(j);
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                x(i - begin, j) = values[i];
+            }
+        }
+        readLabels(begin, end, y);
+    }
+
+    inline void readLabels(std::size_t begin, std::size_t end, std::vector<int>& y) const override
+    {
+        y.assign(labels() + begin, labels() + end);
+    }
+
+    inline void prefetch(std::size_t begin, std::size_t end) const override
+    {
+        advise(begin, end, MappedFile::Advice::WillNeed);
+    }
+
+    inline void release(std::size_t begin, std::size_t end) const override
+    {
+        advise(begin, end, MappedFile::Advice::DontNeed);
+    }
+
+private:
+    MappedFile m_file;          // The mapped column file.
+    std::uint64_t m_rows = 0;     // Number of rows.
+    std::uint64_t m_features = 0; // Number of feature columns.
+
+    inline void advise(std::size_t begin, std::size_t end, MappedFile::Advice advice) const noexcept
+    {
+        std::size_t base = COLUMN_FILE_HEADER;
+        for (std::size_t j = 0; j < m_features; ++j)
+        {
+            m_file.advise(base + (j * m_rows + begin) * sizeof(double), (end - begin) * sizeof(double), advice);
+        }
+        m_file.advise(base + m_features * m_rows * sizeof(double) + begin * sizeof(std::int32_t),
+                      (end - begin) * sizeof(std::int32_t), advice);
+    }
+}; // class MappedDataset
+
+/**
+ * @brief Creates a binary column file of the given shape and returns it mapped for writing.
+ * 
+ * @param path The path of the file.
+ * @param rows The number of rows.
+ * @param features The number of feature columns.
+ * 
+ * @return The mapping; column j starts at COLUMN_FILE_HEADER + j * rows * 8, the labels after the last column.
+ */
+inline MappedFile createColumnFile(const std::string& path, std::uint64_t rows, std::uint64_t features)
+{
+    MappedFile file(path, COLUMN_FILE_HEADER + rows * (features * sizeof(double) + sizeof(std::int32_t)));
+    std::memcpy(file.data(), COLUMN_FILE_MAGIC, sizeof(COLUMN_FILE_MAGIC));
+    std::memcpy(file.data() + 8, &rows, sizeof(rows));
+    std::memcpy(file.data() + 16, &features, sizeof(features));
+    return file;
+}
+
+/**
+ * @brief Writes an in-memory data set as a binary column file.
+ * 
+ * @param path The path of the file.
+ * @param x A 2D vector of input features.
+ * @param y A vector of target class labels.
+ */
+inline void writeColumnFile(const std::string& path, const std::vector<std::vector<double>>& x, const std::vector<int>& y)
+{
+    const std::uint64_t rows = x.size();
+    const std::uint64_t features = x.empty() ? 0 : x[0].size();
+    MappedFile file = createColumnFile(path, rows, features);
+    double* columns = reinterpret_cast<double*>(file.data() + COLUMN_FILE_HEADER);
+    std::int32_t* labels = reinterpret_cast<std::int32_t*>(columns + rows * features);
+    for (std::size_t i = 0; i < rows; ++i)
+    {
+        for (std::size_t j = 0; j < features; ++j)
+        {
+            columns[j * rows + i] = x[i][j];
+        }
+        labels[i] = y[i];
+    }
+}
+
+/**
+ * @brief Converts a CSV file of numbers into a binary column file for MappedDataset.
+ * 
+ * Makes one pass to count the rows and a second pass that parses every line straight
+ * into the mapped output, so neither file has to fit in memory.
+ * 
+ * @param csv_path The path of the CSV file.
+ * @param out_path The path of the column file to write.
+ * @param label_column The column holding the integer class label, negative values count from the end.
+ * @param header Whether the first line is a header to skip.
+ * 
+ * @return The number of rows written.
+ * 
+ * @throws std::runtime_error if a file cannot be opened, a line is malformed or a label does not fit in 32 bits.
+ */
+inline std::size_t convertCsv(const std::string& csv_path, const std::string& out_path, int label_column = -1, bool header = true)
+{
+    auto split = [](const std::string& line, std::vector<std::string_view>& fields)
+    {
+        fields.clear();
+        std::size_t start = 0;
+        for (;;)
+        {
+            std::size_t comma = line.find(',', start);
+            fields.emplace_back(line.data() + start, (comma == std::string::npos ? line.size() : comma) - start);
+            if (comma == std::string::npos)
+            {
+                return;
+            }
+            start = comma + 1;
+        }
+    };
+
+    std::ifstream in(csv_path);
+    if (!in)
+    {
+        throw std::runtime_error("Failed to open " + csv_path);
+    }
+
+    std::string line;
+    std::vector<std::string_view> fields;
+    std::size_t rows = 0, columns = 0;
+    if (header)
+    {
+        std::getline(in, line);
+    }
+    while (std::getline(in, line))
+    {
+        if (line.empty() || line == "\r")
+        {
+            continue;
+        }
+        if (rows++ == 0)
+        {
+            split(line, fields);
+            columns = fields.size();
+        }
+    }
+
+    if (columns < 2)
+    {
+        throw std::runtime_error(csv_path + " needs at least one feature and one label column");
+    }
+
+    const std::size_t label = label_column < 0 ? columns + label_column : static_cast<std::size_t>(label_column);
+    if (label >= columns)
+    {
+        throw std::runtime_error("Label column out of range");
+    }
+
+    const std::size_t features = columns - 1;
+    MappedFile file = createColumnFile(out_path, rows, features);
+    double* out = reinterpret_cast<double*>(file.data() + COLUMN_FILE_HEADER);
+    std::int32_t* labels = reinterpret_cast<std::int32_t*>(out + rows * features);
+
+    in.clear();
+    in.seekg(0);
+    if (header)
+    {
+        std::getline(in, line);
+    }
+
+    std::size_t row = 0, line_number = header ? 1 : 0;
+    while (std::getline(in, line))
+    {
+        ++line_number;
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+        if (line.empty())
+        {
+            continue;
+        }
+
+        split(line, fields);
+        if (fields.size() != columns)
+        {
+            throw std::runtime_error("Wrong number of fields on line " + std::to_string(line_number));
+        }
+
+        for (std::size_t c = 0, j = 0; c < columns; ++c)
+        {
+            std::string_view field = fields[c];
+            while (!field.empty() && field.front() == ' ') field.remove_prefix(1);
+            while (!field.empty() && field.back() == ' ') field.remove_suffix(1);
+
+            double value = 0.0;
+            std::from_chars_result result = std::from_chars(field.data(), field.data() + field.size(), value);
+            if (result.ec != std::errc() || result.ptr != field.data() + field.size())
+            {
+                throw std::runtime_error("Invalid number on line " + std::to_string(line_number));
+            }
+
+            if (c == label)
+            {
+                if (!(value >= std::numeric_limits<std::int32_t>::min() && value <= std::numeric_limits<std::int32_t>::max()))
+                {
+                    throw std::runtime_error("Label out of range on line " + std::to_string(line_number));
+                }
+                labels[row] = static_cast<std::int32_t>(value);
+            }
+            else
+            {
+                out[j++ * rows + row] = value;
+            }
+        }
+        ++row;
+    }
+
+    return rows;
+}
+
+/**
+ * @brief Streams a data source chunk by chunk, prefetching the next chunk while the current one is processed.
+ * 
+ * @param data The data source.
+ * @param chunk_rows The number of rows per chunk.
+ * @param func Called as func(x, y, first_row) for every chunk.
+ */
+template <typename Func>
+inline void forEachChunk(const DataSource& data, std::size_t chunk_rows, Func&& func)
+{
+    chunk_rows = std::max<std::size_t>(1, chunk_rows);
+    Matrix x;
+    std::vector<int> y;
+    const std::size_t rows = data.rows();
+    for (std::size_t begin = 0; begin < rows; begin += chunk_rows)
+    {
+        std::size_t end = std::min(rows, begin + chunk_rows);
+        if (end < rows)
+        {
+            data.prefetch(end, std::min(rows, end + chunk_rows));
+        }
+
+        data.readChunk(begin, end, x, y);
+        data.release(begin, end);
+        func(static_cast<const Matrix&>(x), static_cast<const std::vector<int>&>(y), begin);
+    }
+}
+
+/**
+ * @brief The smallest information gain (in bits) that justifies a split; smaller gains are rounding noise.
+ */
+inline constexpr double MIN_SPLIT_GAIN = 1e-9;
+
+/**
+ * @brief Computes the entropy of a label distribution from its class counts.
+ * 
+ * Uses H = log2(total) - sum(count * log2(count)) / total, so only counts are passed to log2.
+ * The two terms do not cancel exactly, so a distribution with a single class returns 0 directly.
+ * 
+ * @param counts The number (or weight) of samples of each class.
+ * @param classes The number of classes.
+ * @param total The total number (or weight) of samples, positive.
+ * 
+ * @return The entropy in bits.
+ */
+template <MathPrecision Precision, typename Count>
+inline double classEntropy(const Count* counts, std::size_t classes, double total) noexcept
+{
+    double sum = 0.0;
+    std::size_t present = 0;
+    for (std::size_t c = 0; c < classes; ++c)
+    {
+        const double count = static_cast<double>(counts[c]);
+        sum += count > 0.0 ? count * approxLog2<Precision>(count) : 0.0;
+        present += count > 0.0;
+    }
+
+    return present < 2 ? 0.0 : std::max(0.0, approxLog2<Precision>(total) - sum / total);
+}
+
+/**
+ * @brief Computes the entropy of a label distribution at a runtime-selected precision.
+ * 
+ * @param counts The number (or weight) of samples of each class.
+ * @param classes The number of classes.
+ * @param total The total number (or weight) of samples, positive.
+ * @param precision The accuracy tier.
+ * 
+ * @return The entropy in bits.
+ */
+template <typename Count>
+inline double classEntropy(const Count* counts, std::size_t classes, double total, MathPrecision precision = MathPrecision::High) noexcept
+{
+    switch (precision)
+    {
+    case MathPrecision::Exact: return classEntropy<MathPrecision::Exact>(counts, classes, total);
+    case MathPrecision::Fast: return classEntropy<MathPrecision::Fast>(counts, classes, total);
+    default: return classEntropy<MathPrecision::High>(counts, classes, total);
+    }
+}
+
+/**
+ * @brief The step of training a TrainingEvent reports.
+ */
+enum class TrainingStage
+{
+    Fit,       // A whole fit, for models trained in one step.
+    Epoch,     // One pass over the data of an iterative model.
+    Iteration, // One update of a clustering model.
+    Tree,      // One tree of an ensemble.
+    Level,     // One level of a tree grown breadth-first.
+    Split      // One leaf split of an incremental tree.
+};
+
+/**
+ * @brief Metrics of one training step, passed to a TrainingObserver.
+ */
+struct TrainingEvent
+{
+    const char* m_model;  // Name of the model class.
+    TrainingStage m_stage; // The step that finished.
+    std::size_t m_index;  // Number of the epoch, iteration, tree, level or split.
+    double m_seconds;     // Wall time of the step.
+    double m_loss;        // Training objective after the step, NaN if the model has none.
+    std::size_t m_nodes;  // Nodes in the model (or the tree of a Tree event), 0 if not a tree model.
+    std::size_t m_bytes;  // Approximate heap memory held by the model and its training buffers.
+};
+
+/**
+ * @brief Receives training metrics from models.
+ * 
+ * Models call onEvent() from the thread running fit(), except RandomForest, which
+ * reports its trees from worker threads one at a time.
+ */
+class TrainingObserver
+{
+public:
+    virtual ~TrainingObserver() = default;
+
+    /**
+     * @brief Called after every reported training step.
+     * 
+     * @param event The metrics of the step.
+     */
+    virtual void onEvent(const TrainingEvent& event) = 0;
+};
+
+/**
+ * @brief A TrainingObserver forwarding every event to a callable.
+ */
+class CallbackObserver : public TrainingObserver
+{
+public:
+    /**
+     * @brief Constructs a CallbackObserver object.
+     * 
+     * @param callback Called with every event.
+     */
+    explicit CallbackObserver(std::function<void(const TrainingEvent&)> callback) : m_callback(std::move(callback)) {}
+
+    inline void onEvent(const TrainingEvent& event) override
+    {
+        m_callback(event);
+    }
+
+private:
+    std::function<void(const TrainingEvent&)> m_callback; // The forwarded-to callable.
+}; // class CallbackObserver
+
+/**
+ * @brief Base of every model that can report training metrics.
+ * 
+ * Without an observer, fit() reads no clocks and computes no extra metrics; the
+ * only cost is a null check per reported step.
+ */
+class Observable
+{
+public:
+    /**
+     * @brief Sets the observer notified during training.
+     * 
+     * @param observer The observer, which must outlive any fit; null disables reporting.
+     */
+    inline void setObserver(TrainingObserver* observer) noexcept { m_observer = observer; }
+    inline TrainingObserver* observer() const noexcept { return m_observer; }
+
+protected:
+    using Clock = std::chrono::steady_clock;
+
+    TrainingObserver* m_observer = nullptr; // Receives training metrics, if set.
+
+    /**
+     * @brief Returns the start time of a step, or a dummy without an observer.
+     */
+    inline Clock::time_point startStep() const noexcept
+    {
+        return m_observer ? Clock::now() : Clock::time_point{};
+    }
+
+    /**
+     * @brief Sends the metrics of a finished step to the observer, which must be set.
+     * 
+     * @param model The name of the model class.
+     * @param stage The step that finished.
+     * @param index The number of the step.
+     * @param start The value startStep() returned when the step began.
+     * @param loss The training objective after the step.
+     * @param nodes The number of nodes in the model.
+     * @param bytes The approximate heap memory held by the model.
+     */
+    inline void report(const char* model, TrainingStage stage, std::size_t index, Clock::time_point start,
+                       double loss = std::numeric_limits<double>::quiet_NaN(), std::size_t nodes = 0, std::size_t bytes = 0) const
+    {
+        m_observer->onEvent(TrainingEvent{ model, stage, index, std::chrono::duration<double>(Clock::now() - start).count(),
+                                           loss, nodes, bytes });
+    }
+}; // class Observable
+
+/**
+ * @brief A class for performing Linear Regression with L2 Regularization.
+ */
+class LinearRegression : public Observable
+{
+public:
+    /**
+     * @brief Constructs a LinearRegression object.
+     * 
+     * @param lambda The L2 regularization parameter.
+     */
+    LinearRegression(double lambda = 0.0) : m_slope(0), m_intercept(0), m_lambda(lambda) {}
+
+    /**
+     * @brief Fits the linear regression model to the provided data.
+     * 
+     * @param x A vector of input features.
+     * @param y A vector of target values.
+     */
+    inline void fit(const std::vector<double>& x, const std::vector<double>& y)
+    {
+        int n = x.size();
+        if (n == 0) return;
+        const auto start = startStep();
+
+        double x_mean = std::accumulate(x.begin(), x.end(), 0.0) / n;
+        double y_mean = std::accumulate(y.begin(), y.end(), 0.0) / n;
+
+        double numerator = 0, denominator = 0;
+        for (int i = 0; i < n; ++i)
+        {
+            numerator += (x[i] - x_mean) * (y[i] - y_mean);
+            denominator += (x[i] - x_mean) * (x[i] - x_mean);
+        }
+
+        m_slope = numerator / (denominator + m_lambda);
+        m_intercept = y_mean - m_slope * x_mean;
+
+        if (m_observer)
+        {
+            double squared_error = 0.0;
+            for (int i = 0; i < n; ++i)
+            {
+                squared_error += (predict(x[i]) - y[i]) * (predict(x[i]) - y[i]);
+            }
+            report("LinearRegression", TrainingStage::Fit, 0, start, squared_error / n);
+        }
+    }
+
+    /**
+     * @brief Predicts the target value for a given input feature.
+     * 
+     * @param x The input feature.
+     * 
+     * @return The predicted target value.
+     */
+    inline double predict(double x) const
+    {
+        return m_slope * x + m_intercept;
+    }
+
+private:
+    double m_slope;     // Slope of the regression line.
+    double m_intercept; // Intercept of the regression line.
+    double m_lambda;    // L2 regularization parameter.
+}; // class LinearRegression
+
+/**
+ * @brief A class for performing Logistic Regression with support for multi-class classification.
+ */
+class LogisticRegression : public Observable
+{
+public:
+    /**
+     * @brief Constructs a LogisticRegression object.
+     * 
+     * @param num_classes The number of classes for classification.
+     * @param input_size The number of input features.
+     * @param seed The seed for weight initialization.
+     * @param precision The accuracy of the exponentials in the softmax.
+     */
+    LogisticRegression(int num_classes, int input_size, std::uint64_t seed = DEFAULT_SEED, MathPrecision precision = MathPrecision::High)
+        : num_classes(num_classes), m_inputSize(input_size), m_precision(precision)
+    {
+        m_weights.resize(num_classes, std::vector<double>(input_size));
+        m_biases.resize(num_classes);
+        initializeWeights(seed);
+    }
+
+    /**
+     * @brief Fits the logistic regression model to the provided data.
+     * 
+     * @param x A 2D vector of input features.
+     * @param y A vector of target class labels.
+     * @param learning_rate The learning rate for gradient descent.
+     * @param epochs The number of iterations for training.
+     */
+    inline void fit(const std::vector<std::vector<double>>& x,
+                    const std::vector<int>& y,
+                    double learning_rate = 0.01,
+                    int epochs = 10000)
+    {
+        fit(DataView(x, y), learning_rate, epochs);
+    }
+
+    /**
+     * @brief Fits the logistic regression model to the rows selected by a view.
+     * 
+     * @param data A view of the input features and target class labels.
+     * @param learning_rate The learning rate for gradient descent.
+     * @param epochs The number of iterations for training.
+     */
+    inline void fit(const DataView& data, double learning_rate = 0.01, int epochs = 10000)
+    {
+        train(data.size(), [&](std::size_t i) { return data.row(i).data(); }, [&](std::size_t i) { return data.label(i); },
+              learning_rate, epochs);
+    }
+
+    /**
+     * @brief Fits the logistic regression model to a contiguous matrix, e.g. the output of a Pipeline.
+     * 
+     * @param x The data matrix, one sample per row.
+     * @param y A vector of target class labels.
+     * @param learning_rate The learning rate for gradient descent.
+     * @param epochs The number of iterations for training.
+     */
+    inline void fit(const Matrix& x, const std::vector<int>& y, double learning_rate = 0.01, int epochs = 10000)
+    {
+        train(x.rows(), [&](std::size_t i) { return x.row(i); }, [&](std::size_t i) { return y[i]; }, learning_rate, epochs);
+    }
+
+    /**
+     * @brief Fits the logistic regression model out of core with mini-batch gradient descent.
+     * 
+     * Every epoch streams the source chunk by chunk, so only one chunk is resident at a
+     * time; each update uses the averaged gradient of a mini-batch within a chunk.
+     * 
+     * @param data The data source, e.g. a MappedDataset.
+     * @param learning_rate The learning rate for gradient descent.
+     * @param epochs The number of passes over the data.
+     * @param batch_size The number of rows per gradient step.
+     * @param chunk_rows The number of rows read from the source at a time.
+     */
+    inline void fit(const DataSource& data, double learning_rate = 0.01, int epochs = 100,
+                    std::size_t batch_size = 256, std::size_t chunk_rows = 65536)
+    {
+        const std::size_t inputs = static_cast<std::size_t>(m_inputSize);
+        std::vector<std::vector<double>> weight_gradient(num_classes, std::vector<double>(inputs));
+        std::vector<double> bias_gradient(num_classes);
+        batch_size = std::max<std::size_t>(1, batch_size);
+
+        for (int epoch = 0; epoch < epochs; ++epoch)
+        {
+            const auto start = startStep();
+            double loss = 0.0;
+            forEachChunk(data, chunk_rows, [&](const Matrix& x, const std::vector<int>& y, std::size_t)
+            {
+                for (std::size_t begin = 0; begin < x.rows(); begin += batch_size)
+                {
+                    const std::size_t end = std::min(x.rows(), begin + batch_size);
+                    for (int j = 0; j < num_classes; ++j)
+                    {
+                        std::ranges::fill(weight_gradient[j], 0.0);
+                        bias_gradient[j] = 0.0;
+                    }
+
+                    for (std::size_t i = begin; i < end; ++i)
+                    {
+                        const double* sample = x.row(i);
+                        std::vector<double> probs = softmax(computeScores(sample));
+                        if (m_observer)
+                        {
+                            loss -= std::log(std::max(probs[y[i]], std::numeric_limits<double>::min()));
+                        }
+                        for (int j = 0; j < num_classes; ++j)
+                        {
+                            double error = ((j == y[i]) ? 1.0 : 0.0) - probs[j];
+                            for (std::size_t k = 0; k < inputs; ++k)
+                            {
+                                weight_gradient[j][k] += error * sample[k];
+                            }
+                            bias_gradient[j] += error;
+                        }
+                    }
+
+                    const double step = learning_rate / static_cast<double>(end - begin);
+                    for (int j = 0; j < num_classes; ++j)
+                    {
+                        for (std::size_t k = 0; k < inputs; ++k)
+                        {
+                            m_weights[j][k] += step * weight_gradient[j][k];
+                        }
+                        m_biases[j] += step * bias_gradient[j];
+                    }
+                }
+            });
+
+            if (m_observer)
+            {
+                report("LogisticRegression", TrainingStage::Epoch, epoch, start, loss / data.rows(), 0, parameterBytes());
+            }
+        }
+    }
+
+    /**
+     * @brief Predicts the class probabilities for a given input sample.
+     * 
+     * @param sample A vector representing the input features.
+     * 
+     * @return A vector of predicted probabilities for each class.
+     */
+    inline std::vector<double> predict(const std::vector<double>& sample) const
+    {
+        return softmax(computeScores(sample.data()));
+    }
+
+    /**
+     * @brief Predicts the class label for a given input sample.
+     * 
+     * @param sample A vector representing the input features.
+     * 
+     * @return The predicted class label.
+     */
+    inline int predictClass(const std::vector<double>& sample) const
+    {
+        std::vector<double> probs = predict(sample);
+        return std::ranges::distance(probs.begin(), std::ranges::max_element(probs));
+    }
+
+private:
+    int num_classes;                            // Number of classes for classification.
+    int m_inputSize;                            // Number of input features.
+    std::vector<std::vector<double>> m_weights; // Weights for each class.
+    std::vector<double> m_biases;               // Biases for each class.
+    MathPrecision m_precision;                  // Accuracy of the softmax exponentials.
+
+    /**
+     * @brief Runs stochastic gradient descent over rows supplied by accessors.
+     * 
+     * @param rows The number of rows.
+     * @param row_at Returns a pointer to the features of row i.
+     * @param label_at Returns the class label of row i.
+     * @param learning_rate The learning rate for gradient descent.
+     * @param epochs The number of iterations for training.
+     */
+    template <typename RowAt, typename LabelAt>
+    inline void train(std::size_t rows, RowAt&& row_at, LabelAt&& label_at, double learning_rate, int epochs)
+    {
+        for (int epoch = 0; epoch < epochs; ++epoch)
+        {
+            const auto start = startStep();
+            double loss = 0.0;
+            for (std::size_t i = 0; i < rows; ++i)
+            {
+                const double* sample = row_at(i);
+                std::vector<double> scores = computeScores(sample);
+                std::vector<double> probs = softmax(scores);
+                if (m_observer)
+                {
+                    loss -= std::log(std::max(probs[label_at(i)], std::numeric_limits<double>::min()));
+                }
+
+                // Update weights and biases
+                for (int j = 0; j < num_classes; ++j)
+                {
+                    double error = (j == label_at(i)) ? 1.0 : 0.0;
+                    for (std::size_t k = 0; k < static_cast<std::size_t>(m_inputSize); ++k)
+                    {
+                        m_weights[j][k] += learning_rate * (error - probs[j]) * sample[k];
+                    }
+
+                    m_biases[j] += learning_rate * (error - probs[j]);
+                }
+            }
+
+            if (m_observer)
+            {
+                report("LogisticRegression", TrainingStage::Epoch, epoch, start, rows ? loss / rows : 0.0, 0, parameterBytes());
+            }
+        }
+    }
+
+    /**
+     * @brief Returns the memory held by the weights and biases.
+     */
+    inline std::size_t parameterBytes() const noexcept
+    {
+        return static_cast<std::size_t>(num_classes) * (m_inputSize + 1) * sizeof(double);
+    }
+
+    /**
+     * @brief Computes the raw scores for each class given an input sample.
+     * 
+     * @param sample A pointer to the input features.
+     * 
+     * @return A vector of raw scores for each class.
+     */
+    inline std::vector<double> computeScores(const double* sample) const
+    {
+        std::vector<double> scores(num_classes, 0.0);
+        for (int i = 0; i < num_classes; ++i)
+        {
+            for (std::size_t j = 0; j < static_cast<std::size_t>(m_inputSize); ++j)
+            {
+                scores[i] += m_weights[i][j] * sample[j];
+            }
+            scores[i] += m_biases[i];
+        }
+
+        return scores;
+    }
+
+    /**
+     * @brief Computes the softmax activation for multi-class classification.
+     * 
+     * @param scores A vector of raw scores for each class.
+     * 
+     * @return A vector of softmax probabilities.
+     */
+    inline std::vector<double> softmax(const std::vector<double>& scores) const
+    {
+        std::vector<double> exp_scores(scores.size());
+        double max_score = *std::ranges::max_element(scores);
+        for (std::size_t i = 0; i < scores.size(); ++i)
+        {
+            exp_scores[i] = scores[i] - max_score;
+        }
+
+        expInPlace(exp_scores.data(), exp_scores.size(), m_precision);
+        double sum_exp = std::accumulate(exp_scores.begin(), exp_scores.end(), 0.0);
+        for (std::size_t i = 0; i < exp_scores.size(); ++i)
+        {
+            exp_scores[i] /= sum_exp;
+        }
+
+        return exp_scores;
+    }
+
+    /**
+     * @brief Initializes weights and biases randomly.
+     * 
+     * @param seed The seed for the initialization.
+     */
+    void initializeWeights(std::uint64_t seed)
+    {
+        Engine gen = makeEngine(seed);
+        std::uniform_real_distribution<> dis(-0.01, 0.01);
+        for (std::vector<double>& w : m_weights)
+        {
+            for (double& weight : w)
+            {
+                weight = dis(gen);
+            }
+        }
+
+        for (double& bias : m_biases)
+        {
+            bias = dis(gen);
+        }
+    }
+}; // class LogisticRegression
+
+/**
+ * @brief A struct representing a node in the decision tree.
+ */
+struct TreeNode
+{
+    double m_value;                    // Value of the node (used for leaf nodes).
+    int m_featureIndex;                // Index of the feature used for splitting.
+    double m_threshold;                // Threshold value for the split.
+    std::shared_ptr<TreeNode> m_left;  // Pointer to the left child node.
+    std::shared_ptr<TreeNode> m_right; // Pointer to the right child node.
+    bool m_isLeaf;                     // Indicates if the node is a leaf.
+
+    TreeNode() : m_value(0), m_featureIndex(-1), m_threshold(0), m_left(nullptr), m_right(nullptr), m_isLeaf(true) {}
+};
+
+/**
+ * @brief A class for performing Decision Tree classification.
+ */
+class DecisionTree : public Observable
+{
+public:
+    /**
+     * @brief Constructs a DecisionTree object.
+     * 
+     * @param max_depth The maximum depth of the tree.
+     * @param precision The accuracy of the logarithms in the split entropy.
+     */
+    DecisionTree(int max_depth = 5, MathPrecision precision = MathPrecision::High)
+        : m_root(nullptr), m_maxDepth(max_depth), m_precision(precision) {}
+
+    /**
+     * @brief Fits the decision tree model to the provided data.
+     * 
+     * @param x A 2D vector of input features.
+     * @param y A vector of target values.
+     */
+    inline void fit(const std::vector<std::vector<double>>& x, const std::vector<int>& y)
+    {
+        fit(DataView(x, y));
+    }
+
+    /**
+     * @brief Fits the decision tree model to the rows selected by a view.
+     * 
+     * @param data A view of the input features and target values.
+     */
+    inline void fit(const DataView& data)
+    {
+        const auto start = startStep();
+
+        // Map labels to dense class ids so class counts live in flat arrays
+        m_classes.clear();
+        for (std::size_t i = 0; i < data.size(); ++i)
+        {
+            m_classes.push_back(data.label(i));
+        }
+        std::sort(m_classes.begin(), m_classes.end());
+        m_classes.erase(std::unique(m_classes.begin(), m_classes.end()), m_classes.end());
+
+        std::vector<Sample> samples(data.size());
+        for (std::size_t i = 0; i < data.size(); ++i)
+        {
+            samples[i].m_row = data.index(i);
+            samples[i].m_class = static_cast<int>(std::ranges::lower_bound(m_classes, data.label(i)) - m_classes.begin());
+        }
+
+        m_root = buildTree(data.features(), samples, 0, samples.size(), 0);
+        if (m_observer)
+        {
+            const std::size_t nodes = nodeCount();
+            report("DecisionTree", TrainingStage::Fit, 0, start, std::numeric_limits<double>::quiet_NaN(), nodes, nodes * sizeof(TreeNode));
+        }
+    }
+
+    /**
+     * @brief Predicts the class label for a given input sample.
+     * 
+     * @param sample A vector representing the input features.
+     * 
+     * @return The predicted class label.
+     */
+    inline int predict(const std::vector<double>& sample) const
+    {
+        return predict(sample, m_root);
+    }
+
+    /**
+     * @brief Returns the root of the trained tree, or null before fit().
+     */
+    inline const std::shared_ptr<TreeNode>& root() const noexcept { return m_root; }
+
+    /**
+     * @brief Counts the nodes of the trained tree.
+     */
+    inline std::size_t nodeCount() const noexcept
+    {
+        auto count = [](auto&& self, const TreeNode* node) -> std::size_t
+        {
+            return node ? 1 + self(self, node->m_left.get()) + self(self, node->m_right.get()) : 0;
+        };
+        return count(count, m_root.get());
+    }
+
+private:
+    /**
+     * @brief A training row together with its dense class id.
+     */
+    struct Sample
+    {
+        std::size_t m_row; // Row in the feature matrix.
+        int m_class;       // Dense class id of the row's label.
+    };
+
+    std::shared_ptr<TreeNode> m_root; // Pointer to the root node of the tree.
+    int m_maxDepth;                   // Maximum depth of the tree.
+    std::vector<int> m_classes;       // Sorted distinct labels seen by the last fit.
+    MathPrecision m_precision;        // Accuracy of the split entropy logarithms.
+
+    /**
+     * @brief Builds the decision tree recursively over samples[begin, end).
+     * 
+     * For every feature the samples are sorted once and all thresholds are evaluated in
+     * a single sweep that moves samples from the right class counts to the left ones.
+     * 
+     * @param x A 2D vector of input features.
+     * @param samples The training samples; the range is reordered in place.
+     * @param begin The first sample of the node.
+     * @param end One past the last sample of the node.
+     * @param depth The current depth of the tree.
+     * 
+     * @return A shared pointer to the root node of the constructed subtree.
+     */
+    inline std::shared_ptr<TreeNode> buildTree(const std::vector<std::vector<double>>& x, std::vector<Sample>& samples,
+                                               std::size_t begin, std::size_t end, int depth)
+    {
+        std::vector<std::size_t> parent_counts(m_classes.size(), 0);
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            parent_counts[samples[i].m_class]++;
+        }
+
+        if (begin == end || depth >= m_maxDepth || std::ranges::count(parent_counts, 0) + 1 >= static_cast<std::ptrdiff_t>(m_classes.size()))
+        {
+            return createLeafNode(parent_counts);
+        }
+
+        const std::size_t n = end - begin;
+        const double parent_entropy = entropy(parent_counts, n);
+        int best_feature = -1;
+        double best_threshold = 0.0;
+        double best_gain = MIN_SPLIT_GAIN;
+
+        std::vector<Sample> sorted(samples.begin() + begin, samples.begin() + end);
+        std::vector<std::size_t> left_counts(m_classes.size());
+        std::vector<std::size_t> right_counts(m_classes.size());
+        for (std::size_t feature_index = 0; feature_index < x[samples[begin].m_row].size(); ++feature_index)
+        {
+            std::sort(sorted.begin(), sorted.end(), [&](const Sample& a, const Sample& b)
+            {
+                return x[a.m_row][feature_index] < x[b.m_row][feature_index];
+            });
+
+            std::fill(left_counts.begin(), left_counts.end(), 0);
+            right_counts = parent_counts;
+            for (std::size_t i = 0; i + 1 < n; ++i)
+            {
+                left_counts[sorted[i].m_class]++;
+                right_counts[sorted[i].m_class]--;
+
+                double threshold = x[sorted[i].m_row][feature_index];
+                if (x[sorted[i + 1].m_row][feature_index] == threshold)
+                {
+                    continue; // Only split between distinct values
+                }
+
+                std::size_t left_size = i + 1;
+                std::size_t right_size = n - left_size;
+                double weighted_entropy = (left_size * entropy(left_counts, left_size) + right_size * entropy(right_counts, right_size)) / n;
+                double gain = parent_entropy - weighted_entropy;
+                if (gain > best_gain)
+                {
+                    best_gain = gain;
+                    best_feature = static_cast<int>(feature_index);
+                    best_threshold = threshold;
+                }
+            }
+        }
+
+        if (best_feature < 0)
+        {
+            return createLeafNode(parent_counts);
+        }
+
+        std::size_t middle = std::stable_partition(samples.begin() + begin, samples.begin() + end, [&](const Sample& sample)
+        {
+            return x[sample.m_row][best_feature] <= best_threshold;
+        }) - samples.begin();
+
+        std::shared_ptr<TreeNode> node = std::make_shared<TreeNode>();
+        node->m_featureIndex = best_feature;
+        node->m_threshold = best_threshold;
+        node->m_left = buildTree(x, samples, begin, middle, depth + 1);
+        node->m_right = buildTree(x, samples, middle, end, depth + 1);
+        node->m_isLeaf = false;
+
+        return node;
+    }
+
+    /**
+     * @brief Creates a leaf node with the most common class label.
+     * 
+     * @param counts The number of samples of each dense class id.
+     * 
+     * @return A shared pointer to the created leaf node.
+     */
+    inline std::shared_ptr<TreeNode> createLeafNode(const std::vector<std::size_t>& counts)
+    {
+        std::shared_ptr<nstd::ML::TreeNode> node = std::make_shared<TreeNode>();
+        if (!counts.empty())
+        {
+            node->m_value = m_classes[std::ranges::max_element(counts) - counts.begin()];
+        }
+
+        node->m_isLeaf = true;
+
+        return node;
+    }
+
+    /**
+     * @brief Computes the entropy of a set of labels from its class counts.
+     * 
+     * @param counts The number of samples of each dense class id.
+     * @param total The total number of samples.
+     * 
+     * @return The entropy of the labels.
+     */
+    inline double entropy(const std::vector<std::size_t>& counts, std::size_t total) const
+    {
+        return classEntropy(counts.data(), counts.size(), total, m_precision);
+    }
+
+    /**
+     * @brief Predicts the class label for a given input sample using the decision tree.
+     * 
+     * @param sample A vector representing the input features.
+     * @param node A pointer to the current node in the tree.
+     * 
+     * @return The predicted class label.
+     */
+    inline int predict(const std::vector<double>& sample, const std::shared_ptr<TreeNode>& node) const
+    {
+        if (node->m_isLeaf)
+        {
+            return static_cast<int>(node->m_value);
+        }
+        if (sample[node->m_featureIndex] <= node->m_threshold)
+        {
+            return predict(sample, node->m_left);
+        }
+        else
+        {
+            return predict(sample, node->m_right);
+        }
+    }
+}; // class DecisionTree
+
+/**
+ * @brief A class for performing Random Forest classification.
+ */
+class RandomForest : public Observable
+{
+public:
+    /**
+     * @brief Constructs a RandomForest object.
+     * 
+     * @param m_trees The number of trees in the forest.
+     * @param max_depth The maximum depth of each tree.
+     * @param seed The seed for bootstrap sampling.
+     * @param threads The number of trees trained in parallel (0 selects the hardware concurrency).
+     */
+    RandomForest(int m_trees, int max_depth = 5, std::uint64_t seed = DEFAULT_SEED, unsigned threads = 1)
+        : m_trees(m_trees), m_maxDepth(max_depth), m_seed(seed), m_threads(threads) {}
+
+    /**
+     * @brief Fits the random forest model to the provided data.
+     * 
+     * Tree i always draws its bootstrap sample from stream i of the seed, so the
+     * forest is identical for any number of threads.
+     * 
+     * @param x A 2D vector of input features.
+     * @param y A vector of target values.
+     */
+    inline void fit(const std::vector<std::vector<double>>& x, const std::vector<int>& y)
+    {
+        fit(DataView(x, y));
+    }
+
+    /**
+     * @brief Fits the random forest model to the rows selected by a view.
+     * 
+     * Bootstrap samples are index lists into the view's data, so no rows are copied.
+     * 
+     * @param data A view of the input features and target values.
+     */
+    inline void fit(const DataView& data)
+    {
+        trees.assign(m_trees, DecisionTree(m_maxDepth));
+        std::mutex report_mutex;
+        parallelFor(m_trees, m_threads, [&](std::size_t begin, std::size_t end, unsigned)
+        {
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                const auto start = startStep();
+                Engine gen = makeEngine(m_seed, i);
+                std::vector<std::size_t> sample = bootstrapSample(data, gen);
+                trees[i].fit(DataView(data.features(), data.labels(), sample));
+                if (m_observer)
+                {
+                    const std::size_t nodes = trees[i].nodeCount();
+                    std::lock_guard<std::mutex> lock(report_mutex);
+                    report("RandomForest", TrainingStage::Tree, i, start, std::numeric_limits<double>::quiet_NaN(), nodes, nodes * sizeof(TreeNode));
+                }
+            }
+        });
+    }
+
+    /**
+     * @brief Predicts the class label for a given input sample.
+     * 
+     * @param sample A vector representing the input features.
+     * 
+     * @return The predicted class label.
+     */
+    inline int predict(const std::vector<double>& sample) const
+    {
+        std::map<int, int> votes;
+        for (const DecisionTree& tree : trees)
+        {
+            int prediction = tree.predict(sample);
+            votes[prediction]++;
+        }
+
+        return std::ranges::max_element(votes, [](const auto& a, const auto& b)
+        {
+            return a.second < b.second;
+        })->first;
+    }
+
+    inline const std::vector<DecisionTree>& decisionTrees() const noexcept { return trees; }
+
+private:
+    int m_trees;                          // Number of trees in the forest.
+    int m_maxDepth;                       // Maximum depth of each tree.
+    std::uint64_t m_seed;                 // Seed for bootstrap sampling.
+    unsigned m_threads;                   // Number of trees trained in parallel.
+    std::vector<DecisionTree> trees;      // Vector of decision trees.
+
+    /**
+     * @brief Draws a bootstrap sample of the rows of a view.
+     * 
+     * @param data A view of the input features and target values.
+     * @param gen The engine to draw the sample indices from.
+     * 
+     * @return The sampled rows of the underlying data set.
+     */
+    inline std::vector<std::size_t> bootstrapSample(const DataView& data, Engine& gen) const
+    {
+        std::uniform_int_distribution<> dis(0, data.size() - 1);
+        std::vector<std::size_t> sample(data.size());
+        for (std::size_t& index : sample)
+        {
+            index = data.index(dis(gen));
+        }
+        return sample;
+    }
+}; // class RandomForest
+
+/**
+ * @brief A decision tree trained out of core on quantile-binned histograms.
+ * 
+ * Features are bucketed into at most `bins` quantile bins estimated from a sample of
+ * the source. The tree then grows level by level: one streaming pass per level routes
+ * every row to its open leaf and accumulates per-bin class counts, from which every
+ * leaf of the level picks its best entropy split. Memory depends on the number of
+ * open leaves, features, bins and classes, never on the number of rows.
+ */
+class HistogramTree : public Observable
+{
+public:
+    /**
+     * @brief Constructs a HistogramTree object.
+     * 
+     * @param max_depth The maximum depth of the tree.
+     * @param bins The maximum number of bins per feature.
+     * @param chunk_rows The number of rows read from the source at a time.
+     * @param sample_rows The number of rows sampled to estimate the bin edges.
+     * @param threads The number of threads accumulating histograms (0 selects the hardware concurrency).
+     * @param precision The accuracy of the logarithms in the split entropy.
+     */
+    HistogramTree(int max_depth = 8, int bins = 64, std::size_t chunk_rows = 65536, std::size_t sample_rows = 100000,
+                  unsigned threads = 0, MathPrecision precision = MathPrecision::High)
+        : m_maxDepth(max_depth), m_bins(std::max(2, bins)), m_chunkRows(std::max<std::size_t>(1, chunk_rows)),
+          m_sampleRows(std::max<std::size_t>(1, sample_rows)), m_threads(threads), m_precision(precision) {}
+
+    /**
+     * @brief Fits the tree to in-memory data.
+     * 
+     * @param x A 2D vector of input features.
+     * @param y A vector of target class labels.
+     */
+    inline void fit(const std::vector<std::vector<double>>& x, const std::vector<int>& y)
+    {
+        fit(MemoryDataSource(x, y));
+    }
+
+    /**
+     * @brief Fits the tree to a data source, streaming it once per level.
+     * 
+     * @param data The data source, e.g. a MappedDataset.
+     */
+    inline void fit(const DataSource& data)
+    {
+        m_nodes.clear();
+        collectClasses(data);
+        computeEdges(data);
+        if (m_classes.empty())
+        {
+            return;
+        }
+
+        const std::size_t classes = m_classes.size();
+        const std::size_t features = m_edges.size();
+        std::vector<std::size_t> offsets(features + 1, 0); // Start of each feature within a node histogram
+        for (std::size_t j = 0; j < features; ++j)
+        {
+            offsets[j + 1] = offsets[j] + (m_edges[j].size() + 1) * classes;
+        }
+        const std::size_t stride = offsets[features] + classes; // Per-feature bins, then the node's class totals
+
+        m_nodes.push_back(Node{});
+        std::vector<std::size_t> open = { 0 };   // Leaves that may still split
+        std::vector<int> slot(1, 0);             // Position of each node in open, -1 once closed
+
+        for (int depth = 0; !open.empty(); ++depth)
+        {
+            const auto start = startStep();
+            std::vector<std::vector<std::size_t>> histograms(threadCount(m_threads, m_chunkRows),
+                                                             std::vector<std::size_t>(open.size() * stride, 0));
+            std::vector<int> classIds;
+            forEachChunk(data, m_chunkRows, [&](const Matrix& x, const std::vector<int>& y, std::size_t)
+            {
+                classIds.resize(y.size());
+                for (std::size_t i = 0; i < y.size(); ++i)
+                {
+                    classIds[i] = static_cast<int>(std::ranges::lower_bound(m_classes, y[i]) - m_classes.begin());
+                }
+
+                parallelFor(x.rows(), m_threads, [&](std::size_t begin, std::size_t end, unsigned t)
+                {
+                    std::vector<std::size_t>& histogram = histograms[t];
+                    for (std::size_t i = begin; i < end; ++i)
+                    {
+                        const double* sample = x.row(i);
+                        int node = route(sample);
+                        if (slot[node] < 0)
+                        {
+                            continue;
+                        }
+
+                        std::size_t* counts = histogram.data() + slot[node] * stride + classIds[i];
+                        for (std::size_t j = 0; j < features; ++j)
+                        {
+                            counts[offsets[j] + bin(j, sample[j]) * classes] += 1;
+                        }
+                        counts[offsets[features]] += 1;
+                    }
+                });
+            });
+
+            for (std::size_t t = 1; t < histograms.size(); ++t)
+            {
+                std::ranges::transform(histograms[0], histograms[t], histograms[0].begin(), std::plus<>());
+            }
+
+            std::vector<std::size_t> next;
+            for (std::size_t s = 0; s < open.size(); ++s)
+            {
+                const std::size_t node = open[s];
+                slot[node] = -1;
+                const std::size_t* histogram = histograms[0].data() + s * stride;
+                split(node, histogram, offsets, depth, next, slot);
+            }
+            open = std::move(next);
+
+            if (m_observer)
+            {
+                const std::size_t histogram_bytes = histograms.size() * histograms[0].size() * sizeof(std::size_t);
+                report("HistogramTree", TrainingStage::Level, depth, start, std::numeric_limits<double>::quiet_NaN(), m_nodes.size(),
+                       m_nodes.size() * sizeof(Node) + histogram_bytes);
+            }
+        }
+    }
+
+    /**
+     * @brief Predicts the class label for a given input sample.
+     * 
+     * @param sample A vector representing the input features.
+     * 
+     * @return The predicted class label.
+     */
+    inline int predict(const std::vector<double>& sample) const
+    {
+        return predict(sample.data());
+    }
+
+    /**
+     * @brief Predicts the class label for a given input sample.
+     * 
+     * @param sample A pointer to the input features.
+     * 
+     * @return The predicted class label.
+     */
+    inline int predict(const double* sample) const
+    {
+        return m_nodes[route(sample)].m_value;
+    }
+
+    inline std::size_t nodeCount() const noexcept { return m_nodes.size(); }
+
+private:
+    /**
+     * @brief A node of the flattened tree; leaves have a negative feature.
+     */
+    struct Node
+    {
+        int m_feature = -1;      // Index of the feature used for splitting.
+        double m_threshold = 0.0; // Samples with feature <= threshold go left.
+        int m_left = -1;         // Index of the left child.
+        int m_right = -1;        // Index of the right child.
+        int m_value = 0;         // Predicted class label.
+    };
+
+    int m_maxDepth;                          // Maximum depth of the tree.
+    int m_bins;                              // Maximum number of bins per feature.
+    std::size_t m_chunkRows;                 // Rows read from the source at a time.
+    std::size_t m_sampleRows;                // Rows sampled for the bin edges.
+    unsigned m_threads;                      // Threads accumulating histograms.
+    MathPrecision m_precision;               // Accuracy of the split entropy logarithms.
+    std::vector<int> m_classes;              // Sorted unique class labels.
+    std::vector<std::vector<double>> m_edges; // Upper bin edges of each feature.
+    std::vector<Node> m_nodes;               // Flattened nodes, the root first.
+
+    /**
+     * @brief Follows a sample from the root to the node it currently ends up in.
+     */
+    inline int route(const double* sample) const noexcept
+    {
+        int node = 0;
+        while (m_nodes[node].m_feature >= 0)
+        {
+            node = sample[m_nodes[node].m_feature] <= m_nodes[node].m_threshold ? m_nodes[node].m_left : m_nodes[node].m_right;
+        }
+        return node;
+    }
+
+    /**
+     * @brief Returns the bin of a feature value; bin b holds values in (edges[b - 1], edges[b]].
+     */
+    inline std::size_t bin(std::size_t feature, double value) const noexcept
+    {
+        return static_cast<std::size_t>(std::ranges::lower_bound(m_edges[feature], value) - m_edges[feature].begin());
+    }
+
+    /**
+     * @brief Collects the sorted unique class labels with a labels-only pass.
+     */
+    inline void collectClasses(const DataSource& data)
+    {
+        m_classes.clear();
+        std::vector<int> y;
+        for (std::size_t begin = 0; begin < data.rows(); begin += m_chunkRows)
+        {
+            data.readLabels(begin, std::min(data.rows(), begin + m_chunkRows), y);
+            std::ranges::sort(y);
+            y.erase(std::unique(y.begin(), y.end()), y.end());
+
+            std::vector<int> merged;
+            std::ranges::set_union(m_classes, y, std::back_inserter(merged));
+            m_classes = std::move(merged);
+        }
+    }
+
+    /**
+     * @brief Estimates quantile bin edges from evenly spaced blocks of rows.
+     */
+    inline void computeEdges(const DataSource& data)
+    {
+        const std::size_t rows = data.rows();
+        const std::size_t features = data.features();
+        const std::size_t sampled = std::min(rows, m_sampleRows);
+        const std::size_t block = std::min(m_chunkRows, sampled);
+        const std::size_t blocks = block ? (sampled + block - 1) / block : 0;
+
+        std::vector<std::vector<double>> values(features);
+        Matrix x;
+        std::vector<int> y;
+        for (std::size_t b = 0; b < blocks; ++b)
+        {
+            std::size_t begin = blocks > 1 ? b * (rows - block) / (blocks - 1) : 0;
+            data.readChunk(begin, begin + block, x, y);
+            for (std::size_t i = 0; i < x.rows(); ++i)
+            {
+                for (std::size_t j = 0; j < features; ++j)
+                {
+                    values[j].push_back(x(i, j));
+                }
+            }
+        }
+
+        m_edges.assign(features, {});
+        for (std::size_t j = 0; j < features; ++j)
+        {
+            std::vector<double>& v = values[j];
+            std::ranges::sort(v);
+            for (int q = 1; q < m_bins && !v.empty(); ++q)
+            {
+                double edge = v[q * (v.size() - 1) / m_bins];
+                if (m_edges[j].empty() || edge > m_edges[j].back())
+                {
+                    m_edges[j].push_back(edge);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Turns an open leaf into a split or a final leaf from its histogram.
+     * 
+     * @param node The index of the leaf.
+     * @param histogram The per-feature, per-bin class counts of the leaf.
+     * @param offsets The start of each feature within the histogram.
+     * @param depth The depth of the leaf.
+     * @param next Receives the children that stay open.
+     * @param slot Receives the position of the children in next.
+     */
+    inline void split(std::size_t node, const std::size_t* histogram, const std::vector<std::size_t>& offsets, int depth,
+                      std::vector<std::size_t>& next, std::vector<int>& slot)
+    {
+        const std::size_t classes = m_classes.size();
+        std::vector<std::size_t> parent(histogram + offsets.back(), histogram + offsets.back() + classes);
+        const std::size_t total = std::accumulate(parent.begin(), parent.end(), std::size_t{ 0 });
+        m_nodes[node].m_value = m_classes[std::ranges::max_element(parent) - parent.begin()];
+        if (depth >= m_maxDepth || total < 2 || std::ranges::count(parent, 0) + 1 >= static_cast<std::ptrdiff_t>(classes))
+        {
+            return;
+        }
+
+        const double parent_entropy = classEntropy(parent.data(), classes, total, m_precision);
+        double best_gain = MIN_SPLIT_GAIN;
+        int best_feature = -1;
+        double best_threshold = 0.0;
+        std::vector<std::size_t> left(classes), right(classes);
+        for (std::size_t j = 0; j < m_edges.size(); ++j)
+        {
+            std::ranges::fill(left, 0);
+            std::size_t left_size = 0;
+            for (std::size_t b = 0; b < m_edges[j].size(); ++b)
+            {
+                const std::size_t* counts = histogram + offsets[j] + b * classes;
+                for (std::size_t c = 0; c < classes; ++c)
+                {
+                    left[c] += counts[c];
+                    left_size += counts[c];
+                }
+                if (left_size == 0 || left_size == total)
+                {
+                    continue;
+                }
+
+                for (std::size_t c = 0; c < classes; ++c)
+                {
+                    right[c] = parent[c] - left[c];
+                }
+                const std::size_t right_size = total - left_size;
+                double gain = parent_entropy - (left_size * classEntropy(left.data(), classes, left_size, m_precision) +
+                                                right_size * classEntropy(right.data(), classes, right_size, m_precision)) / total;
+                if (gain > best_gain)
+                {
+                    best_gain = gain;
+                    best_feature = static_cast<int>(j);
+                    best_threshold = m_edges[j][b];
+                }
+            }
+        }
+
+        if (best_feature < 0)
+        {
+            return;
+        }
+
+        m_nodes[node].m_feature = best_feature;
+        m_nodes[node].m_threshold = best_threshold;
+        m_nodes[node].m_left = static_cast<int>(m_nodes.size());
+        m_nodes[node].m_right = static_cast<int>(m_nodes.size() + 1);
+        m_nodes.resize(m_nodes.size() + 2);
+        for (int child : { m_nodes[node].m_left, m_nodes[node].m_right })
+        {
+            slot.push_back(static_cast<int>(next.size()));
+            next.push_back(static_cast<std::size_t>(child));
+        }
+    }
+}; // class HistogramTree
+
+/**
+ * @brief An incremental decision tree (Hoeffding tree / VFDT) for streaming data.
+ * 
+ * Each leaf keeps class counts and, per feature and class, a Gaussian estimator
+ * (count, mean, variance, range). A sample costs one walk down the tree plus one
+ * estimator update per feature, never a rebuild. Every grace period a leaf scores
+ * candidate thresholds from its estimators and splits once the information gain of
+ * the best candidate beats the runner-up by more than the Hoeffding bound
+ * sqrt(R^2 ln(1/delta) / 2n), or the bound drops below the tie threshold.
+ */
+class HoeffdingTree : public Observable
+{
+public:
+    /**
+     * @brief Constructs a HoeffdingTree object.
+     * 
+     * @param num_classes The number of classes; labels must be in [0, num_classes).
+     * @param input_size The number of input features.
+     * @param delta The probability of choosing a different split than a batch learner would.
+     * @param grace_period The number of samples a leaf sees between split attempts.
+     * @param tie_threshold The bound below which near-equal candidates are split on anyway.
+     * @param max_depth The maximum depth of the tree.
+     * @param split_candidates The number of thresholds tried per feature.
+     */
+    HoeffdingTree(int num_classes, int input_size, double delta = 1e-7, std::size_t grace_period = 200,
+                  double tie_threshold = 0.05, int max_depth = 20, int split_candidates = 10)
+        : m_classes(static_cast<std::size_t>(num_classes)), m_features(static_cast<std::size_t>(input_size)), m_delta(delta),
+          m_gracePeriod(std::max<std::size_t>(1, grace_period)), m_tieThreshold(tie_threshold), m_maxDepth(max_depth),
+          m_candidates(std::max(1, split_candidates))
+    {
+        m_nodes.push_back(Node{});
+        m_nodes[0].m_leaf = newLeaf();
+    }
+
+    /**
+     * @brief Updates the tree with one sample.
+     * 
+     * @param sample A vector representing the input features.
+     * @param label The class label of the sample.
+     * 
+     * @throws std::invalid_argument if the label is out of range.
+     */
+    inline void partialFit(const std::vector<double>& sample, int label)
+    {
+        partialFit(sample.data(), label);
+    }
+
+    /**
+     * @brief Updates the tree with one sample.
+     * 
+     * @param sample A pointer to the input features.
+     * @param label The class label of the sample.
+     * 
+     * @throws std::invalid_argument if the label is out of range.
+     */
+    inline void partialFit(const double* sample, int label)
+    {
+        if (label < 0 || static_cast<std::size_t>(label) >= m_classes)
+        {
+            throw std::invalid_argument("Label out of range");
+        }
+
+        const int node = route(sample);
+        Leaf& leaf = m_leaves[m_nodes[node].m_leaf];
+        leaf.m_classCounts[label] += 1.0;
+        ++leaf.m_seen;
+        if (m_nodes[node].m_depth >= m_maxDepth)
+        {
+            return;
+        }
+
+        for (std::size_t j = 0; j < m_features; ++j)
+        {
+            double* estimator = leaf.m_estimators.data() + (j * m_classes + label) * ESTIMATOR_SIZE;
+            const double value = sample[j];
+            const double n = ++estimator[0];
+            const double delta = value - estimator[1];
+            estimator[1] += delta / n;
+            estimator[2] += delta * (value - estimator[1]);
+            estimator[3] = n == 1.0 ? value : std::min(estimator[3], value);
+            estimator[4] = n == 1.0 ? value : std::max(estimator[4], value);
+        }
+
+        if (leaf.m_seen - leaf.m_lastAttempt >= m_gracePeriod)
+        {
+            leaf.m_lastAttempt = leaf.m_seen;
+            attemptSplit(node);
+        }
+    }
+
+    /**
+     * @brief Feeds every row of a data set to partialFit, continuing from the current tree.
+     * 
+     * @param x A 2D vector of input features.
+     * @param y A vector of target class labels.
+     */
+    inline void fit(const std::vector<std::vector<double>>& x, const std::vector<int>& y)
+    {
+        fit(DataView(x, y));
+    }
+
+    /**
+     * @brief Feeds the rows selected by a view to partialFit, continuing from the current tree.
+     * 
+     * @param data A view of the input features and target class labels.
+     */
+    inline void fit(const DataView& data)
+    {
+        for (std::size_t i = 0; i < data.size(); ++i)
+        {
+            partialFit(data.row(i).data(), data.label(i));
+        }
+    }
+
+    /**
+     * @brief Predicts the class label for a given input sample.
+     * 
+     * @param sample A vector representing the input features.
+     * 
+     * @return The majority class of the sample's leaf.
+     */
+    inline int predict(const std::vector<double>& sample) const
+    {
+        return predict(sample.data());
+    }
+
+    /**
+     * @brief Predicts the class label for a given input sample.
+     * 
+     * @param sample A pointer to the input features.
+     * 
+     * @return The majority class of the sample's leaf.
+     */
+    inline int predict(const double* sample) const
+    {
+        const std::vector<double>& counts = m_leaves[m_nodes[route(sample)].m_leaf].m_classCounts;
+        return static_cast<int>(std::ranges::max_element(counts) - counts.begin());
+    }
+
+    inline std::size_t nodeCount() const noexcept { return m_nodes.size(); }
+    inline std::size_t leafCount() const noexcept { return m_leaves.size() - m_freeLeaves.size(); }
+
+private:
+    static constexpr std::size_t ESTIMATOR_SIZE = 5; // count, mean, sum of squared deviations, min, max
+
+    /**
+     * @brief A node of the flattened tree; leaves have a negative feature.
+     */
+    struct Node
+    {
+        int m_feature = -1;       // Index of the feature used for splitting.
+        double m_threshold = 0.0; // Samples with feature <= threshold go left.
+        int m_left = -1;          // Index of the left child.
+        int m_right = -1;         // Index of the right child.
+        int m_leaf = -1;          // Index of the leaf statistics while this node is a leaf.
+        int m_depth = 0;          // Depth of the node.
+    };
+
+    /**
+     * @brief The sufficient statistics of a leaf.
+     */
+    struct Leaf
+    {
+        std::vector<double> m_classCounts; // Observed (or inherited) weight of each class.
+        std::vector<double> m_estimators;  // Per feature, per class Gaussian estimators.
+        std::size_t m_seen = 0;            // Samples seen since the leaf was created.
+        std::size_t m_lastAttempt = 0;     // Value of m_seen at the last split attempt.
+    };
+
+    std::size_t m_classes;         // Number of classes.
+    std::size_t m_features;        // Number of input features.
+    double m_delta;                // Confidence parameter of the Hoeffding bound.
+    std::size_t m_gracePeriod;     // Samples between split attempts.
+    double m_tieThreshold;         // Bound below which ties are broken.
+    int m_maxDepth;                // Maximum depth of the tree.
+    int m_candidates;              // Thresholds tried per feature.
+    std::vector<Node> m_nodes;     // Flattened nodes, the root first.
+    std::vector<Leaf> m_leaves;    // Statistics of the current leaves.
+    std::vector<int> m_freeLeaves; // Statistics slots released by splits.
+
+    /**
+     * @brief Follows a sample from the root to its leaf.
+     */
+    inline int route(const double* sample) const noexcept
+    {
+        int node = 0;
+        while (m_nodes[node].m_feature >= 0)
+        {
+            node = sample[m_nodes[node].m_feature] <= m_nodes[node].m_threshold ? m_nodes[node].m_left : m_nodes[node].m_right;
+        }
+        return node;
+    }
+
+    /**
+     * @brief Allocates zeroed leaf statistics, reusing a released slot if there is one.
+     * 
+     * @return The index of the statistics.
+     */
+    inline int newLeaf()
+    {
+        int index;
+        if (m_freeLeaves.empty())
+        {
+            index = static_cast<int>(m_leaves.size());
+            m_leaves.emplace_back();
+        }
+        else
+        {
+            index = m_freeLeaves.back();
+            m_freeLeaves.pop_back();
+        }
+
+        Leaf& leaf = m_leaves[index];
+        leaf.m_classCounts.assign(m_classes, 0.0);
+        leaf.m_estimators.assign(m_features * m_classes * ESTIMATOR_SIZE, 0.0);
+        leaf.m_seen = 0;
+        leaf.m_lastAttempt = 0;
+        return index;
+    }
+
+    /**
+     * @brief Estimates how much of each class falls at or below a threshold.
+     * 
+     * @param leaf The leaf statistics.
+     * @param feature The feature.
+     * @param threshold The threshold.
+     * @param left Receives the estimated weight of each class at or below the threshold.
+     */
+    inline void splitWeights(const Leaf& leaf, std::size_t feature, double threshold, double* left) const noexcept
+    {
+        for (std::size_t c = 0; c < m_classes; ++c)
+        {
+            const double* estimator = leaf.m_estimators.data() + (feature * m_classes + c) * ESTIMATOR_SIZE;
+            const double n = estimator[0];
+            if (n == 0.0)
+            {
+                left[c] = 0.0;
+                continue;
+            }
+
+            // Values outside the observed range are known exactly; inside it the Gaussian decides
+            if (threshold < estimator[3])
+            {
+                left[c] = 0.0;
+            }
+            else if (threshold >= estimator[4])
+            {
+                left[c] = n;
+            }
+            else
+            {
+                const double sd = std::sqrt(estimator[2] / n);
+                left[c] = sd > 0.0 ? n * 0.5 * std::erfc((estimator[1] - threshold) / (sd * std::numbers::sqrt2))
+                                   : (threshold >= estimator[1] ? n : 0.0);
+            }
+        }
+    }
+
+    /**
+     * @brief Splits a leaf if the Hoeffding bound separates its best candidate split.
+     * 
+     * @param node The index of the leaf node.
+     */
+    inline void attemptSplit(int node)
+    {
+        const auto start = startStep();
+        const Leaf& leaf = m_leaves[m_nodes[node].m_leaf];
+        if (m_features == 0)
+        {
+            return;
+        }
+
+        // Feature 0 sees every sample of the leaf, without the weight inherited from the parent
+        std::vector<double> counts(m_classes);
+        for (std::size_t c = 0; c < m_classes; ++c)
+        {
+            counts[c] = leaf.m_estimators[c * ESTIMATOR_SIZE];
+        }
+        if (std::ranges::count_if(counts, [](double count) { return count > 0.0; }) < 2)
+        {
+            return;
+        }
+
+        const double observed = static_cast<double>(leaf.m_seen);
+        const double parent_entropy = classEntropy(counts.data(), m_classes, observed);
+
+        double best_gain = 0.0, second_gain = 0.0, best_threshold = 0.0;
+        int best_feature = -1;
+        std::vector<double> left(m_classes), right(m_classes), best_left(m_classes), best_right(m_classes);
+        for (std::size_t j = 0; j < m_features; ++j)
+        {
+            double low = std::numeric_limits<double>::infinity(), high = -low;
+            for (std::size_t c = 0; c < m_classes; ++c)
+            {
+                const double* estimator = leaf.m_estimators.data() + (j * m_classes + c) * ESTIMATOR_SIZE;
+                if (estimator[0] > 0.0)
+                {
+                    low = std::min(low, estimator[3]);
+                    high = std::max(high, estimator[4]);
+                }
+            }
+            if (!(low < high))
+            {
+                continue;
+            }
+
+            double feature_gain = 0.0, feature_threshold = 0.0;
+            for (int k = 1; k <= m_candidates; ++k)
+            {
+                const double threshold = low + (high - low) * k / (m_candidates + 1);
+                splitWeights(leaf, j, threshold, left.data());
+                double left_total = 0.0, right_total = 0.0;
+                for (std::size_t c = 0; c < m_classes; ++c)
+                {
+                    right[c] = std::max(0.0, leaf.m_estimators[(j * m_classes + c) * ESTIMATOR_SIZE] - left[c]);
+                    left_total += left[c];
+                    right_total += right[c];
+                }
+                if (left_total <= 0.0 || right_total <= 0.0)
+                {
+                    continue;
+                }
+
+                const double gain = parent_entropy - (left_total * classEntropy(left.data(), m_classes, left_total) +
+                                                      right_total * classEntropy(right.data(), m_classes, right_total)) / observed;
+                if (gain > feature_gain)
+                {
+                    feature_gain = gain;
+                    feature_threshold = threshold;
+                    if (gain > best_gain)
+                    {
+                        best_left = left;
+                        best_right = right;
+                    }
+                }
+            }
+
+            // Candidates of the same feature are not independent, so the runner-up is the best other feature
+            if (feature_gain > best_gain)
+            {
+                second_gain = best_gain;
+                best_gain = feature_gain;
+                best_feature = static_cast<int>(j);
+                best_threshold = feature_threshold;
+            }
+            else if (feature_gain > second_gain)
+            {
+                second_gain = feature_gain;
+            }
+        }
+
+        if (best_feature < 0)
+        {
+            return;
+        }
+
+        const double range = std::log2(static_cast<double>(m_classes));
+        const double bound = std::sqrt(range * range * std::log(1.0 / m_delta) / (2.0 * observed));
+        if (best_gain - second_gain <= bound && bound >= m_tieThreshold)
+        {
+            return;
+        }
+
+        // Children start from the class distribution the split predicts for them
+        const int depth = m_nodes[node].m_depth + 1;
+        const int left_node = static_cast<int>(m_nodes.size());
+        m_freeLeaves.push_back(m_nodes[node].m_leaf);
+        for (const std::vector<double>* prior : { &best_left, &best_right })
+        {
+            Node child;
+            child.m_depth = depth;
+            child.m_leaf = newLeaf();
+            m_leaves[child.m_leaf].m_classCounts = *prior;
+            m_nodes.push_back(child);
+        }
+
+        Node& parent = m_nodes[node];
+        parent.m_feature = best_feature;
+        parent.m_threshold = best_threshold;
+        parent.m_left = left_node;
+        parent.m_right = left_node + 1;
+        parent.m_leaf = -1;
+
+        if (m_observer)
+        {
+            const std::size_t leaf_bytes = (m_classes + m_features * m_classes * ESTIMATOR_SIZE) * sizeof(double);
+            report("HoeffdingTree", TrainingStage::Split, m_nodes.size() / 2 - 1, start, std::numeric_limits<double>::quiet_NaN(),
+                   m_nodes.size(), m_nodes.size() * sizeof(Node) + m_leaves.size() * leaf_bytes);
+        }
+    }
+}; // class HoeffdingTree
+
+/**
+ * @brief The shape of the C++ code emitted for a tree.
+ */
+enum class CodeStyle
+{
+    NestedIf, // One if/else per split; the branches mirror the tree, fastest when they predict well.
+    Bitmask   // Predicated QuickScorer-style leaf bitmasks; every split is evaluated, so the time is input-independent.
+};
+
+/**
+ * @brief Formats a double as a C++ expression that evaluates to exactly the same value.
+ * 
+ * Infinities are spelled with std::numeric_limits, since to_chars writes "inf".
+ * 
+ * @throws std::invalid_argument if the value is NaN, which no comparison could use.
+ */
+inline std::string formatDouble(double value)
+{
+    if (std::isnan(value))
+    {
+        throw std::invalid_argument("Cannot generate code for a NaN threshold");
+    }
+    if (std::isinf(value))
+    {
+        return value > 0 ? "std::numeric_limits<double>::infinity()" : "-std::numeric_limits<double>::infinity()";
+    }
+
+    char buffer[32];
+    std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    return std::string(buffer, result.ptr);
+}
+
+/**
+ * @brief Emits the function body of one trained tree.
+ * 
+ * Bitmask trees number their leaves left to right, which keeps every subtree a
+ * contiguous bit range. Each split clears the bits of its left subtree when the
+ * sample goes right; the lowest surviving bit is the exit leaf, and its value is
+ * recovered with one mask per distinct value. Trees with more than 64 leaves fall
+ * back to nested ifs.
+ * 
+ * @param root The root of the tree.
+ * @param style The code style.
+ * @param value_of Maps a leaf's class label to the value the function returns.
+ * @param code Receives the statements of the function body.
+ */
+template <typename ValueOf>
+inline void generateTreeBody(const std::shared_ptr<TreeNode>& root, CodeStyle style, ValueOf&& value_of, std::string& code)
+{
+    std::vector<const TreeNode*> leaves;
+    std::vector<std::pair<const TreeNode*, std::uint64_t>> splits; // Node and the mask applied when it goes right
+    auto collect = [&](auto&& self, const TreeNode* node) -> std::pair<std::size_t, std::size_t>
+    {
+        if (node->m_isLeaf)
+        {
+            leaves.push_back(node);
+            return { leaves.size() - 1, leaves.size() };
+        }
+
+        std::size_t split = splits.size();
+        splits.emplace_back(node, 0);
+        auto [first, last] = self(self, node->m_left.get());
+        std::uint64_t left = 0;
+        for (std::size_t leaf = first; leaf < last && leaf < 64; ++leaf)
+        {
+            left |= std::uint64_t{ 1 } << leaf;
+        }
+        splits[split].second = ~left;
+        return { first, self(self, node->m_right.get()).second };
+    };
+
+    if (!root)
+    {
+        code += "    (void)x;\n    return " + std::to_string(value_of(0)) + ";\n";
+        return;
+    }
+    collect(collect, root.get());
+
+    if (style == CodeStyle::Bitmask && leaves.size() <= 64)
+    {
+        auto hex = [](std::uint64_t value)
+        {
+            char buffer[24] = "0x";
+            std::to_chars_result result = std::to_chars(buffer + 2, buffer + sizeof(buffer), value, 16);
+            return std::string(buffer, result.ptr) + "ull";
+        };
+
+        const std::uint64_t all = leaves.size() == 64 ? ~std::uint64_t{ 0 } : (std::uint64_t{ 1 } << leaves.size()) - 1;
+        if (splits.empty())
+        {
+            code += "    (void)x;\n";
+        }
+        code += "    std::uint64_t leaves = " + hex(all) + ";\n";
+        for (const auto& [node, mask] : splits)
+        {
+            code += "    leaves &= " + hex(mask & all) + " | (0ull - static_cast<std::uint64_t>(x[" + std::to_string(node->m_featureIndex) +
+                    "] <= " + formatDouble(node->m_threshold) + "));\n";
+        }
+
+        std::map<int, std::uint64_t> values;
+        for (std::size_t leaf = 0; leaf < leaves.size(); ++leaf)
+        {
+            values[value_of(static_cast<int>(leaves[leaf]->m_value))] |= std::uint64_t{ 1 } << leaf;
+        }
+
+        code += "    const std::uint64_t exit = leaves & (0ull - leaves);\n    return ";
+        bool first = true;
+        for (const auto& [value, mask] : values)
+        {
+            code += (first ? "" : "\n         + ") + std::to_string(value) + " * ((exit & " + hex(mask) + ") != 0)";
+            first = false;
+        }
+        code += ";\n";
+        return;
+    }
+
+    if (leaves.size() == 1)
+    {
+        code += "    (void)x;\n";
+    }
+    auto emit = [&](auto&& self, const TreeNode* node, const std::string& indent) -> void
+    {
+        if (node->m_isLeaf)
+        {
+            code += indent + "return " + std::to_string(value_of(static_cast<int>(node->m_value))) + ";\n";
+            return;
+        }
+
+        code += indent + "if (x[" + std::to_string(node->m_featureIndex) + "] <= " + formatDouble(node->m_threshold) + ")\n";
+        code += indent + "{\n";
+        self(self, node->m_left.get(), indent + "    ");
+        code += indent + "}\n" + indent + "else\n" + indent + "{\n";
+        self(self, node->m_right.get(), indent + "    ");
+        code += indent + "}\n";
+    };
+    emit(emit, root.get(), "    ");
+}
+
+/**
+ * @brief Compiles a trained decision tree into a self-contained C++ header.
+ * 
+ * The header defines `inline int <name>(const double* x) noexcept`, which returns the
+ * same label as DecisionTree::predict without touching the model at run time.
+ * 
+ * @param tree The trained tree.
+ * @param name The name of the generated function.
+ * @param style The code style.
+ * 
+ * @return The source code of the header.
+ * 
+ * @throws std::invalid_argument if a split threshold is NaN.
+ */
+inline std::string generateCode(const DecisionTree& tree, const std::string& name, CodeStyle style = CodeStyle::NestedIf)
+{
+    std::string code = "// Generated by nstd::ML from a DecisionTree. Do not edit.\n#pragma once\n\n#include <cstdint>\n#include <limits>\n\n";
+    code += "inline int " + name + "(const double* x) noexcept\n{\n";
+    generateTreeBody(tree.root(), style, [](int label) { return label; }, code);
+    code += "}\n";
+    return code;
+}
+
+/**
+ * @brief Compiles a trained random forest into a self-contained C++ header.
+ * 
+ * Every tree becomes `<name>_tree<i>`, returning a dense class id; `<name>` counts the
+ * votes with comparisons and selects, breaking ties towards the smallest label like
+ * RandomForest::predict.
+ * 
+ * @param forest The trained forest.
+ * @param name The name of the generated function.
+ * @param style The code style of the trees.
+ * 
+ * @return The source code of the header.
+ * 
+ * @throws std::invalid_argument if a split threshold is NaN.
+ */
+inline std::string generateCode(const RandomForest& forest, const std::string& name, CodeStyle style = CodeStyle::NestedIf)
+{
+    std::vector<int> labels;
+    auto gather = [&](auto&& self, const TreeNode* node) -> void
+    {
+        if (node->m_isLeaf)
+        {
+            labels.push_back(static_cast<int>(node->m_value));
+            return;
+        }
+        self(self, node->m_left.get());
+        self(self, node->m_right.get());
+    };
+    for (const DecisionTree& tree : forest.decisionTrees())
+    {
+        if (tree.root())
+        {
+            gather(gather, tree.root().get());
+        }
+    }
+    std::ranges::sort(labels);
+    labels.erase(std::unique(labels.begin(), labels.end()), labels.end());
+    if (labels.empty())
+    {
+        labels.push_back(0);
+    }
+
+    auto dense = [&](int label) { return static_cast<int>(std::ranges::lower_bound(labels, label) - labels.begin()); };
+    const std::size_t trees = forest.decisionTrees().size();
+    std::string code = "// Generated by nstd::ML from a RandomForest of " + std::to_string(trees) +
+                       " trees. Do not edit.\n#pragma once\n\n#include <cstdint>\n#include <limits>\n";
+    for (std::size_t t = 0; t < trees; ++t)
+    {
+        code += "\ninline int " + name + "_tree" + std::to_string(t) + "(const double* x) noexcept\n{\n";
+        generateTreeBody(forest.decisionTrees()[t].root(), style, dense, code);
+        code += "}\n";
+    }
+
+    code += "\ninline int " + name + "(const double* x) noexcept\n{\n";
+    for (std::size_t t = 0; t < trees; ++t)
+    {
+        code += "    const int t" + std::to_string(t) + " = " + name + "_tree" + std::to_string(t) + "(x);\n";
+    }
+    for (std::size_t c = 0; c < labels.size(); ++c)
+    {
+        code += "    const int v" + std::to_string(c) + " = 0";
+        for (std::size_t t = 0; t < trees; ++t)
+        {
+            code += " + (t" + std::to_string(t) + " == " + std::to_string(c) + ")";
+        }
+        code += ";\n";
+    }
+
+    code += "    int label = " + std::to_string(labels[0]) + ", most = v0;\n";
+    for (std::size_t c = 1; c < labels.size(); ++c)
+    {
+        const std::string v = std::string("v") + std::to_string(c);
+        code += "    label = " + v + " > most ? " + std::to_string(labels[c]) + " : label;\n";
+        code += "    most = " + v + " > most ? " + v + " : most;\n";
+    }
+    code += "    return label;\n}\n";
+    return code;
+}
+
+/**
+ * @brief Picks initial cluster centers with k-means++ seeding.
+ * 
+ * Each new center is drawn with probability proportional to its squared distance
+ * to the closest center chosen so far.
+ * 
+ * @param x The data matrix, one sample per row.
+ * @param k The number of centers to pick.
+ * @param gen The random engine to draw from.
+ * @param threads The number of threads for the distance updates (0 selects the hardware concurrency).
+ * 
+ * @return A k x cols matrix of initial centers.
+ */
+inline Matrix kmeansPlusPlus(const Matrix& x, int k, Engine& gen, unsigned threads = 0)
+{
+    const std::size_t n = x.rows();
+    const std::size_t d = x.cols();
+    Matrix centers(k, d);
+
+    std::uniform_int_distribution<std::size_t> pick(0, n - 1);
+    std::size_t first = pick(gen);
+    std::copy(x.row(first), x.row(first) + d, centers.row(0));
+
+    std::vector<double> closest(n, std::numeric_limits<double>::max());
+    std::vector<double> partial(threadCount(threads, n));
+    for (int c = 1; c < k; ++c)
+    {
+        const double* last = centers.row(c - 1);
+        parallelFor(n, threads, [&](std::size_t begin, std::size_t end, unsigned t)
+        {
+            double sum = 0.0;
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                closest[i] = std::min(closest[i], squaredDistance(x.row(i), last, d));
+                sum += closest[i];
+            }
+            partial[t] = sum;
+        });
+
+        double total = std::accumulate(partial.begin(), partial.end(), 0.0);
+        std::size_t chosen = n - 1;
+        if (total > 0.0)
+        {
+            double target = std::uniform_real_distribution<double>(0.0, total)(gen);
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                target -= closest[i];
+                if (target <= 0.0)
+                {
+                    chosen = i;
+                    break;
+                }
+            }
+        }
+        else
+        {
+            chosen = pick(gen); // Every point coincides with a center already.
+        }
+
+        std::copy(x.row(chosen), x.row(chosen) + d, centers.row(c));
+    }
+
+    return centers;
+}
+
+/**
+ * @brief Finds the closest and second closest center to a point.
+ * 
+ * @param sample The point.
+ * @param centers The cluster centers.
+ * @param best Receives the squared distance to the closest center.
+ * @param second Receives the squared distance to the second closest center.
+ * 
+ * @return The index of the closest center.
+ */
+inline int nearestCenters(const double* sample, const Matrix& centers, double& best, double& second) noexcept
+{
+    int index = 0;
+    best = std::numeric_limits<double>::max();
+    second = std::numeric_limits<double>::max();
+    for (std::size_t c = 0; c < centers.rows(); ++c)
+    {
+        double dist = squaredDistance(sample, centers.row(c), centers.cols());
+        if (dist < best)
+        {
+            second = best;
+            best = dist;
+            index = static_cast<int>(c);
+        }
+        else if (dist < second)
+        {
+            second = dist;
+        }
+    }
+    return index;
+}
+
+/**
+ * @brief A class for performing k-means clustering.
+ * 
+ * Seeds with k-means++ and runs Lloyd iterations accelerated with Hamerly's
+ * triangle-inequality bounds, so most points skip the distance computations to all
+ * k centers once the clustering starts to settle. Assignment and center updates
+ * are spread over threads on a contiguous Matrix.
+ */
+class KMeans : public Observable
+{
+public:
+    /**
+     * @brief Constructs a KMeans object.
+     * 
+     * @param k The number of clusters.
+     * @param max_iterations The maximum number of Lloyd iterations.
+     * @param tolerance Training stops once no center moves further than this.
+     * @param threads The number of worker threads (0 selects the hardware concurrency).
+     * @param seed The seed for k-means++ initialization.
+     */
+    KMeans(int k, int max_iterations = 300, double tolerance = 1e-4, unsigned threads = 0,
+           std::uint64_t seed = DEFAULT_SEED)
+        : m_k(k), m_maxIterations(max_iterations), m_tolerance(tolerance), m_threads(threads), m_seed(seed),
+          m_inertia(0), m_iterations(0) {}
+
+    /**
+     * @brief Fits the model to the provided data.
+     * 
+     * @param x The data matrix, one sample per row.
+     * 
+     * @throws std::invalid_argument if there are fewer samples than clusters.
+     */
+    inline void fit(const Matrix& x)
+    {
+        const std::size_t n = x.rows();
+        const std::size_t d = x.cols();
+        if (m_k <= 0 || n < static_cast<std::size_t>(m_k))
+        {
+            throw std::invalid_argument("KMeans needs at least k samples");
+        }
+
+        Engine gen = makeEngine(m_seed);
+        m_centroids = kmeansPlusPlus(x, m_k, gen, m_threads);
+
+        std::vector<int>& assign = m_labels;
+        std::vector<double> upper(n), lower(n);
+        assign.assign(n, 0);
+
+        parallelFor(n, m_threads, [&](std::size_t begin, std::size_t end, unsigned)
+        {
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                double best, second;
+                assign[i] = nearestCenters(x.row(i), m_centroids, best, second);
+                upper[i] = std::sqrt(best);
+                lower[i] = std::sqrt(second);
+            }
+        });
+
+        const unsigned threads = threadCount(m_threads, n);
+        std::vector<double> sums(threads * m_k * d);
+        std::vector<std::size_t> counts(threads * m_k);
+        std::vector<double> shift(m_k), half(m_k);
+        std::vector<std::size_t> changed(threads);
+
+        for (m_iterations = 1; m_iterations <= m_maxIterations; ++m_iterations)
+        {
+            const auto start = startStep();
+
+            // Move every center to the mean of its points
+            std::fill(sums.begin(), sums.end(), 0.0);
+            std::fill(counts.begin(), counts.end(), 0);
+            parallelFor(n, m_threads, [&](std::size_t begin, std::size_t end, unsigned t)
+            {
+                double* local_sums = sums.data() + t * m_k * d;
+                std::size_t* local_counts = counts.data() + t * m_k;
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    double* target = local_sums + assign[i] * d;
+                    const double* sample = x.row(i);
+                    for (std::size_t j = 0; j < d; ++j)
+                    {
+                        target[j] += sample[j];
+                    }
+                    local_counts[assign[i]]++;
+                }
+            });
+
+            double max_shift = 0.0, second_shift = 0.0;
+            int max_index = -1;
+            std::vector<double> center(d);
+            for (int c = 0; c < m_k; ++c)
+            {
+                std::size_t count = 0;
+                std::fill(center.begin(), center.end(), 0.0);
+                for (unsigned t = 0; t < threads; ++t)
+                {
+                    const double* local = sums.data() + (t * m_k + c) * d;
+                    for (std::size_t j = 0; j < d; ++j)
+                    {
+                        center[j] += local[j];
+                    }
+                    count += counts[t * m_k + c];
+                }
+
+                shift[c] = 0.0;
+                if (count == 0)
+                {
+                    continue; // Keep empty clusters where they are
+                }
+
+                for (double& value : center)
+                {
+                    value /= count;
+                }
+
+                shift[c] = std::sqrt(squaredDistance(center.data(), m_centroids.row(c), d));
+                std::copy(center.begin(), center.end(), m_centroids.row(c));
+                if (shift[c] > max_shift)
+                {
+                    second_shift = max_shift;
+                    max_shift = shift[c];
+                    max_index = c;
+                }
+                else if (shift[c] > second_shift)
+                {
+                    second_shift = shift[c];
+                }
+            }
+
+            if (m_observer)
+            {
+                const std::size_t bytes = (m_centroids.rows() * d + sums.size() + 2 * n) * sizeof(double) + n * sizeof(int);
+                report("KMeans", TrainingStage::Iteration, m_iterations, start, computeInertia(x), 0, bytes);
+            }
+
+            if (max_shift <= m_tolerance)
+            {
+                break;
+            }
+
+            // Loosen the bounds by how far the centers moved
+            parallelFor(n, m_threads, [&](std::size_t begin, std::size_t end, unsigned)
+            {
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    upper[i] += shift[assign[i]];
+                    lower[i] -= (assign[i] == max_index) ? second_shift : max_shift;
+                }
+            });
+
+            // Half the distance from each center to its nearest other center
+            for (int c = 0; c < m_k; ++c)
+            {
+                double nearest = std::numeric_limits<double>::max();
+                for (int other = 0; other < m_k; ++other)
+                {
+                    if (other != c)
+                    {
+                        nearest = std::min(nearest, squaredDistance(m_centroids.row(c), m_centroids.row(other), d));
+                    }
+                }
+                half[c] = 0.5 * std::sqrt(nearest);
+            }
+
+            // Reassign only the points whose bounds can no longer rule out a closer center
+            std::fill(changed.begin(), changed.end(), 0);
+            parallelFor(n, m_threads, [&](std::size_t begin, std::size_t end, unsigned t)
+            {
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    double bound = std::max(half[assign[i]], lower[i]);
+                    if (upper[i] <= bound)
+                    {
+                        continue;
+                    }
+
+                    upper[i] = std::sqrt(squaredDistance(x.row(i), m_centroids.row(assign[i]), d));
+                    if (upper[i] <= bound)
+                    {
+                        continue;
+                    }
+
+                    double best, second;
+                    int nearest = nearestCenters(x.row(i), m_centroids, best, second);
+                    if (nearest != assign[i])
+                    {
+                        assign[i] = nearest;
+                        changed[t]++;
+                    }
+                    upper[i] = std::sqrt(best);
+                    lower[i] = std::sqrt(second);
+                }
+            });
+
+            if (std::accumulate(changed.begin(), changed.end(), std::size_t(0)) == 0)
+            {
+                break;
+            }
+        }
+
+        m_iterations = std::min(m_iterations, m_maxIterations);
+        m_inertia = computeInertia(x);
+    }
+
+    /**
+     * @brief Fits the model to the provided data.
+     * 
+     * @param x A 2D vector of input features.
+     */
+    inline void fit(const std::vector<std::vector<double>>& x)
+    {
+        fit(Matrix(x));
+    }
+
+    /**
+     * @brief Predicts the cluster of a given input sample.
+     * 
+     * @param sample A vector representing the input features.
+     * 
+     * @return The index of the closest cluster center.
+     */
+    inline int predict(const std::vector<double>& sample) const noexcept
+    {
+        double best, second;
+        return nearestCenters(sample.data(), m_centroids, best, second);
+    }
+
+    /**
+     * @brief Predicts the clusters of every row of a matrix in parallel.
+     * 
+     * @param x The data matrix, one sample per row.
+     * 
+     * @return The index of the closest cluster center for each row.
+     */
+    inline std::vector<int> predictBatch(const Matrix& x) const
+    {
+        std::vector<int> labels(x.rows());
+        parallelFor(x.rows(), m_threads, [&](std::size_t begin, std::size_t end, unsigned)
+        {
+            double best, second;
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                labels[i] = nearestCenters(x.row(i), m_centroids, best, second);
+            }
+        });
+        return labels;
+    }
+
+    inline const Matrix& centroids() const noexcept { return m_centroids; }
+    inline const std::vector<int>& labels() const noexcept { return m_labels; }
+    inline double inertia() const noexcept { return m_inertia; }
+    inline int iterations() const noexcept { return m_iterations; }
+
+private:
+    int m_k;                   // Number of clusters.
+    int m_maxIterations;       // Maximum number of Lloyd iterations.
+    double m_tolerance;        // Largest center movement considered converged.
+    unsigned m_threads;        // Number of worker threads (0 = hardware concurrency).
+    std::uint64_t m_seed;      // Seed for k-means++ initialization.
+    Matrix m_centroids;        // Cluster centers, one per row.
+    std::vector<int> m_labels; // Cluster of each training sample.
+    double m_inertia;          // Sum of squared distances to the assigned centers.
+    int m_iterations;          // Number of iterations run by the last fit.
+
+    /**
+     * @brief Computes the sum of squared distances of the training samples to their centers.
+     * 
+     * @param x The data matrix the model was fitted on.
+     * 
+     * @return The inertia.
+     */
+    inline double computeInertia(const Matrix& x) const
+    {
+        std::vector<double> partial(threadCount(m_threads, x.rows()));
+        parallelFor(x.rows(), m_threads, [&](std::size_t begin, std::size_t end, unsigned t)
+        {
+            double sum = 0.0;
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                sum += squaredDistance(x.row(i), m_centroids.row(m_labels[i]), x.cols());
+            }
+            partial[t] = sum;
+        });
+        return std::accumulate(partial.begin(), partial.end(), 0.0);
+    }
+}; // class KMeans
+
+/**
+ * @brief A class for performing mini-batch k-means clustering.
+ * 
+ * Each iteration only touches a random batch of rows, which keeps the working set
+ * in cache for data sets far larger than it. Centers move towards their batch points
+ * with a per-center learning rate of 1 / (points seen so far).
+ */
+class MiniBatchKMeans : public Observable
+{
+public:
+    /**
+     * @brief Constructs a MiniBatchKMeans object.
+     * 
+     * @param k The number of clusters.
+     * @param batch_size The number of rows sampled per iteration.
+     * @param max_iterations The number of batches processed by fit().
+     * @param threads The number of worker threads (0 selects the hardware concurrency).
+     * @param seed The seed for initialization and batch sampling.
+     */
+    MiniBatchKMeans(int k, std::size_t batch_size = 1024, int max_iterations = 100, unsigned threads = 0,
+                    std::uint64_t seed = DEFAULT_SEED)
+        : m_k(k), m_batchSize(batch_size), m_maxIterations(max_iterations), m_threads(threads), m_gen(makeEngine(seed)) {}
+
+    /**
+     * @brief Fits the model by sampling batches from the provided data.
+     * 
+     * @param x The data matrix, one sample per row.
+     * 
+     * @throws std::invalid_argument if there are fewer samples than clusters.
+     */
+    inline void fit(const Matrix& x)
+    {
+        if (m_k <= 0 || x.rows() < static_cast<std::size_t>(m_k))
+        {
+            throw std::invalid_argument("MiniBatchKMeans needs at least k samples");
+        }
+
+        m_centroids = Matrix();
+        initialize(x, std::min(x.rows(), std::max<std::size_t>(3 * m_batchSize, m_k)));
+
+        std::uniform_int_distribution<std::size_t> pick(0, x.rows() - 1);
+        std::vector<std::size_t> batch(std::min(m_batchSize, x.rows()));
+        for (int iteration = 0; iteration < m_maxIterations; ++iteration)
+        {
+            for (std::size_t& index : batch)
+            {
+                index = pick(m_gen);
+            }
+            update(x, batch);
+        }
+    }
+
+    /**
+     * @brief Updates the model with one batch, e.g. a chunk streamed from disk.
+     * 
+     * The first batch seen also initializes the centers with k-means++.
+     * 
+     * @param batch A matrix of samples, one per row.
+     * 
+     * @throws std::invalid_argument if the first batch has fewer samples than clusters.
+     */
+    inline void partialFit(const Matrix& batch)
+    {
+        if (m_centroids.rows() == 0)
+        {
+            if (m_k <= 0 || batch.rows() < static_cast<std::size_t>(m_k))
+            {
+                throw std::invalid_argument("MiniBatchKMeans needs at least k samples");
+            }
+            initialize(batch, batch.rows());
+        }
+
+        std::vector<std::size_t> indices(batch.rows());
+        std::iota(indices.begin(), indices.end(), 0);
+        update(batch, indices);
+    }
+
+    /**
+     * @brief Predicts the cluster of a given input sample.
+     * 
+     * @param sample A vector representing the input features.
+     * 
+     * @return The index of the closest cluster center.
+     */
+    inline int predict(const std::vector<double>& sample) const noexcept
+    {
+        double best, second;
+        return nearestCenters(sample.data(), m_centroids, best, second);
+    }
+
+    /**
+     * @brief Predicts the clusters of every row of a matrix in parallel.
+     * 
+     * @param x The data matrix, one sample per row.
+     * 
+     * @return The index of the closest cluster center for each row.
+     */
+    inline std::vector<int> predictBatch(const Matrix& x) const
+    {
+        std::vector<int> labels(x.rows());
+        parallelFor(x.rows(), m_threads, [&](std::size_t begin, std::size_t end, unsigned)
+        {
+            double best, second;
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                labels[i] = nearestCenters(x.row(i), m_centroids, best, second);
+            }
+        });
+        return labels;
+    }
+
+    inline const Matrix& centroids() const noexcept { return m_centroids; }
+
+private:
+    int m_k;                          // Number of clusters.
+    std::size_t m_batchSize;          // Number of rows sampled per iteration.
+    int m_maxIterations;              // Number of batches processed by fit().
+    unsigned m_threads;               // Number of worker threads (0 = hardware concurrency).
+    Engine m_gen;                     // Engine for initialization and batch sampling.
+    Matrix m_centroids;               // Cluster centers, one per row.
+    std::vector<std::size_t> m_seen;  // Number of points each center has absorbed.
+    std::size_t m_batches = 0;        // Number of batches processed so far.
+
+    /**
+     * @brief Seeds the centers with k-means++ on a random subset of rows.
+     * 
+     * @param x The data matrix.
+     * @param sample_size The number of rows to seed from.
+     */
+    inline void initialize(const Matrix& x, std::size_t sample_size)
+    {
+        Matrix sample(sample_size, x.cols());
+        std::uniform_int_distribution<std::size_t> pick(0, x.rows() - 1);
+        for (std::size_t i = 0; i < sample_size; ++i)
+        {
+            std::size_t index = sample_size == x.rows() ? i : pick(m_gen);
+            std::copy(x.row(index), x.row(index) + x.cols(), sample.row(i));
+        }
+
+        m_centroids = kmeansPlusPlus(sample, m_k, m_gen, m_threads);
+        m_seen.assign(m_k, 0);
+    }
+
+    /**
+     * @brief Assigns a batch in parallel, then moves the centers towards their points.
+     * 
+     * @param x The data matrix.
+     * @param batch The rows of x forming the batch.
+     */
+    inline void update(const Matrix& x, const std::vector<std::size_t>& batch)
+    {
+        const auto start = startStep();
+        std::vector<int> nearest(batch.size());
+        std::vector<double> distances(m_observer ? batch.size() : 0);
+        parallelFor(batch.size(), m_threads, [&](std::size_t begin, std::size_t end, unsigned)
+        {
+            double best, second;
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                nearest[i] = nearestCenters(x.row(batch[i]), m_centroids, best, second);
+                if (!distances.empty())
+                {
+                    distances[i] = best;
+                }
+            }
+        });
+
+        for (std::size_t i = 0; i < batch.size(); ++i)
+        {
+            double* center = m_centroids.row(nearest[i]);
+            const double* sample = x.row(batch[i]);
+            double rate = 1.0 / static_cast<double>(++m_seen[nearest[i]]);
+            for (std::size_t j = 0; j < x.cols(); ++j)
+            {
+                center[j] += rate * (sample[j] - center[j]);
+            }
+        }
+
+        ++m_batches;
+        if (m_observer)
+        {
+            // Loss is the inertia of the batch against the centers before the update
+            report("MiniBatchKMeans", TrainingStage::Iteration, m_batches, start, std::accumulate(distances.begin(), distances.end(), 0.0), 0,
+                   m_centroids.rows() * m_centroids.cols() * sizeof(double) + batch.size() * (sizeof(int) + sizeof(double)));
+        }
+    }
+}; // class MiniBatchKMeans
+
+/**
+ * @brief Algorithms the nearest neighbour index can search with.
+ */
+enum class NeighborAlgorithm
+{
+    Auto,       // KD-tree for low-dimensional data, brute force otherwise.
+    BruteForce, // Tiled exhaustive search.
+    KDTree      // Axis-aligned space partitioning tree.
+};
+
+/**
+ * @brief A struct representing one result of a nearest neighbour query.
+ */
+struct Neighbor
+{
+    double m_distance;   // Squared Euclidean distance to the query.
+    std::size_t m_index; // Row of the neighbour in the fitted data.
+
+    inline bool operator<(const Neighbor& other) const noexcept
+    {
+        return m_distance < other.m_distance;
+    }
+};
+
+/**
+ * @brief Computes the squared distances from one point to four others at once.
+ * 
+ * Every query element is loaded once and reused for the four rows, which keeps
+ * the inner loop bound by arithmetic rather than loads.
+ * 
+ * @param q The query point.
+ * @param r The four reference points.
+ * @param n The number of dimensions.
+ * @param out Receives the four squared distances.
+ */
+inline void squaredDistances4(const double* q, const double* const r[4], std::size_t n, double out[4]) noexcept
+{
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    for (std::size_t j = 0; j < n; ++j)
+    {
+        double v = q[j];
+        double d0 = v - r[0][j];
+        double d1 = v - r[1][j];
+        double d2 = v - r[2][j];
+        double d3 = v - r[3][j];
+        s0 += d0 * d0;
+        s1 += d1 * d1;
+        s2 += d2 * d2;
+        s3 += d3 * d3;
+    }
+
+    out[0] = s0;
+    out[1] = s1;
+    out[2] = s2;
+    out[3] = s3;
+}
+
+/**
+ * @brief An index answering k-nearest-neighbour queries over a fixed set of points.
+ */
+class NearestNeighbors : public Observable
+{
+public:
+    /**
+     * @brief Constructs a NearestNeighbors object.
+     * 
+     * @param algorithm The search algorithm.
+     * @param leaf_size The maximum number of points in a KD-tree leaf.
+     * @param threads The number of worker threads for batch queries (0 selects the hardware concurrency).
+     */
+    NearestNeighbors(NeighborAlgorithm algorithm = NeighborAlgorithm::Auto, std::size_t leaf_size = 32, unsigned threads = 0)
+        : m_algorithm(algorithm), m_leafSize(std::max<std::size_t>(1, leaf_size)), m_threads(threads) {}
+
+    /**
+     * @brief Indexes the provided points.
+     * 
+     * @param x The data matrix, one point per row.
+     */
+    inline void fit(const Matrix& x)
+    {
+        const auto start = startStep();
+        m_useTree = m_algorithm == NeighborAlgorithm::KDTree
+                 || (m_algorithm == NeighborAlgorithm::Auto && x.cols() <= s_maxTreeDimensions);
+
+        m_order.resize(x.rows());
+        std::iota(m_order.begin(), m_order.end(), 0);
+        m_nodes.clear();
+
+        if (m_useTree && x.rows() > 0)
+        {
+            buildTree(x, 0, x.rows());
+        }
+
+        // Store the points in search order so every leaf is one contiguous block
+        m_points.resize(x.rows(), x.cols());
+        for (std::size_t i = 0; i < x.rows(); ++i)
+        {
+            std::copy(x.row(m_order[i]), x.row(m_order[i]) + x.cols(), m_points.row(i));
+        }
+
+        if (m_observer)
+        {
+            const std::size_t bytes = m_points.rows() * m_points.cols() * sizeof(double) + m_order.size() * sizeof(std::size_t) +
+                                      m_nodes.size() * sizeof(decltype(m_nodes)::value_type);
+            report("NearestNeighbors", TrainingStage::Fit, 0, start, std::numeric_limits<double>::quiet_NaN(), m_nodes.size(), bytes);
+        }
+    }
+
+    /**
+     * @brief Finds the k nearest neighbours of a single point.
+     * 
+     * @param query The query point.
+     * @param k The number of neighbours.
+     * 
+     * @return Up to k neighbours, closest first.
+     */
+    inline std::vector<Neighbor> query(const double* query, int k) const
+    {
+        std::vector<Neighbor> heap;
+        if (k <= 0)
+        {
+            return heap;
+        }
+
+        heap.reserve(k);
+        if (m_useTree)
+        {
+            if (!m_nodes.empty())
+            {
+                searchTree(query, 0, static_cast<std::size_t>(k), heap);
+            }
+        }
+        else
+        {
+            Matrix single(1, m_points.cols());
+            std::copy(query, query + m_points.cols(), single.row(0));
+            std::vector<std::vector<Neighbor>> result(1);
+            bruteForce(single, 0, 1, static_cast<std::size_t>(k), result);
+            heap.swap(result[0]);
+        }
+
+        std::sort_heap(heap.begin(), heap.end());
+        return heap;
+    }
+
+    /**
+     * @brief Finds the k nearest neighbours of every row of a matrix in parallel.
+     * 
+     * @param queries The query matrix, one point per row.
+     * @param k The number of neighbours.
+     * 
+     * @return Up to k neighbours per query, closest first.
+     */
+    inline std::vector<std::vector<Neighbor>> queryBatch(const Matrix& queries, int k) const
+    {
+        std::vector<std::vector<Neighbor>> result(queries.rows());
+        if (m_useTree)
+        {
+            parallelFor(queries.rows(), m_threads, [&](std::size_t begin, std::size_t end, unsigned)
+            {
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    result[i] = query(queries.row(i), k);
+                }
+            });
+            return result;
+        }
+
+        std::size_t tiles = (queries.rows() + s_queryTile - 1) / s_queryTile;
+        parallelFor(tiles, m_threads, [&](std::size_t begin, std::size_t end, unsigned)
+        {
+            bruteForce(queries, begin * s_queryTile, std::min(queries.rows(), end * s_queryTile), static_cast<std::size_t>(k), result);
+        });
+
+        for (std::vector<Neighbor>& heap : result)
+        {
+            std::sort_heap(heap.begin(), heap.end());
+        }
+        return result;
+    }
+
+    inline std::size_t size() const noexcept { return m_points.rows(); }
+    inline std::size_t dimensions() const noexcept { return m_points.cols(); }
+    inline bool usesTree() const noexcept { return m_useTree; }
+
+private:
+    /**
+     * @brief A struct representing a node of the flattened KD-tree.
+     */
+    struct KDNode
+    {
+        std::size_t m_begin;  // First point of the node in search order.
+        std::size_t m_end;    // One past the last point of the node.
+        int m_splitDimension; // Dimension the node splits on, -1 for leaves.
+        double m_splitValue;  // Points with a value <= this go left.
+        std::size_t m_left;   // Index of the left child.
+        std::size_t m_right;  // Index of the right child.
+    };
+
+    static constexpr std::size_t s_maxTreeDimensions = 16; // Auto picks the KD-tree up to this many dimensions.
+    static constexpr std::size_t s_queryTile = 16;         // Queries processed against each database tile.
+    static constexpr std::size_t s_tileBytes = 64 * 1024;  // Size of a database tile, about half of L2.
+
+    NeighborAlgorithm m_algorithm;    // Requested search algorithm.
+    std::size_t m_leafSize;           // Maximum number of points in a KD-tree leaf.
+    unsigned m_threads;               // Number of worker threads (0 = hardware concurrency).
+    bool m_useTree = false;           // Whether the last fit built a KD-tree.
+    Matrix m_points;                  // Indexed points, in search order.
+    std::vector<std::size_t> m_order; // Original row of each point in search order.
+    std::vector<KDNode> m_nodes;      // Flattened KD-tree, root first.
+
+    /**
+     * @brief Pushes a candidate into a bounded max-heap of the best neighbours.
+     */
+    static inline void offer(std::vector<Neighbor>& heap, std::size_t k, double distance, std::size_t index)
+    {
+        if (heap.size() < k)
+        {
+            heap.push_back({distance, index});
+            std::push_heap(heap.begin(), heap.end());
+        }
+        else if (distance < heap.front().m_distance)
+        {
+            std::pop_heap(heap.begin(), heap.end());
+            heap.back() = {distance, index};
+            std::push_heap(heap.begin(), heap.end());
+        }
+    }
+
+    /**
+     * @brief Builds the KD-tree over [begin, end) of m_order, splitting at the median of the widest dimension.
+     * 
+     * @return The index of the created node.
+     */
+    inline std::size_t buildTree(const Matrix& x, std::size_t begin, std::size_t end)
+    {
+        std::size_t index = m_nodes.size();
+        m_nodes.push_back({begin, end, -1, 0.0, 0, 0});
+        if (end - begin <= m_leafSize)
+        {
+            return index;
+        }
+
+        int dimension = 0;
+        double widest = -1.0;
+        for (std::size_t j = 0; j < x.cols(); ++j)
+        {
+            double low = std::numeric_limits<double>::max();
+            double high = std::numeric_limits<double>::lowest();
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                low = std::min(low, x(m_order[i], j));
+                high = std::max(high, x(m_order[i], j));
+            }
+            if (high - low > widest)
+            {
+                widest = high - low;
+                dimension = static_cast<int>(j);
+            }
+        }
+
+        if (widest <= 0.0)
+        {
+            return index; // All points coincide
+        }
+
+        std::size_t middle = begin + (end - begin) / 2;
+        std::nth_element(m_order.begin() + begin, m_order.begin() + middle, m_order.begin() + end,
+                         [&](std::size_t a, std::size_t b) { return x(a, dimension) < x(b, dimension); });
+
+        m_nodes[index].m_splitDimension = dimension;
+        m_nodes[index].m_splitValue = x(m_order[middle], dimension);
+        std::size_t left = buildTree(x, begin, middle);
+        std::size_t right = buildTree(x, middle, end);
+        m_nodes[index].m_left = left;
+        m_nodes[index].m_right = right;
+        return index;
+    }
+
+    /**
+     * @brief Searches the KD-tree, visiting the far side of a split only if it can hold a closer point.
+     */
+    inline void searchTree(const double* query, std::size_t node_index, std::size_t k, std::vector<Neighbor>& heap) const
+    {
+        const KDNode& node = m_nodes[node_index];
+        if (node.m_splitDimension < 0)
+        {
+            for (std::size_t i = node.m_begin; i < node.m_end; ++i)
+            {
+                offer(heap, k, squaredDistance(query, m_points.row(i), m_points.cols()), m_order[i]);
+            }
+            return;
+        }
+
+        double delta = query[node.m_splitDimension] - node.m_splitValue;
+        std::size_t near_child = delta <= 0.0 ? node.m_left : node.m_right;
+        std::size_t far_child = delta <= 0.0 ? node.m_right : node.m_left;
+
+        searchTree(query, near_child, k, heap);
+        if (heap.size() < k || delta * delta < heap.front().m_distance)
+        {
+            searchTree(query, far_child, k, heap);
+        }
+    }
+
+    /**
+     * @brief Exhaustive search for rows [begin, end) of the queries.
+     * 
+     * Queries are processed in tiles of s_queryTile against database tiles sized to stay
+     * in cache, so each database row is loaded once per query tile instead of once per query.
+     */
+    inline void bruteForce(const Matrix& queries, std::size_t begin, std::size_t end, std::size_t k,
+                           std::vector<std::vector<Neighbor>>& result) const
+    {
+        const std::size_t n = m_points.rows();
+        const std::size_t d = m_points.cols();
+        const std::size_t tile_rows = std::max<std::size_t>(4, s_tileBytes / (sizeof(double) * std::max<std::size_t>(1, d)));
+
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            result[i].clear();
+            result[i].reserve(k);
+        }
+
+        double dist[4];
+        for (std::size_t q_begin = begin; q_begin < end; q_begin += s_queryTile)
+        {
+            std::size_t q_end = std::min(end, q_begin + s_queryTile);
+            for (std::size_t t_begin = 0; t_begin < n; t_begin += tile_rows)
+            {
+                std::size_t t_end = std::min(n, t_begin + tile_rows);
+                for (std::size_t q = q_begin; q < q_end; ++q)
+                {
+                    const double* query = queries.row(q);
+                    std::vector<Neighbor>& heap = result[q];
+                    std::size_t r = t_begin;
+                    for (; r + 4 <= t_end; r += 4)
+                    {
+                        const double* rows[4] = { m_points.row(r), m_points.row(r + 1), m_points.row(r + 2), m_points.row(r + 3) };
+                        squaredDistances4(query, rows, d, dist);
+                        for (std::size_t l = 0; l < 4; ++l)
+                        {
+                            offer(heap, k, dist[l], m_order[r + l]);
+                        }
+                    }
+
+                    for (; r < t_end; ++r)
+                    {
+                        offer(heap, k, squaredDistance(query, m_points.row(r), d), m_order[r]);
+                    }
+                }
+            }
+        }
+    }
+}; // class NearestNeighbors
+
+/**
+ * @brief A class for performing k-nearest-neighbour classification.
+ */
+class KNNClassifier : public Observable
+{
+public:
+    /**
+     * @brief Constructs a KNNClassifier object.
+     * 
+     * @param k The number of neighbours that vote.
+     * @param algorithm The search algorithm.
+     * @param threads The number of worker threads for batch prediction (0 selects the hardware concurrency).
+     * 
+     * @throws std::invalid_argument if k is not positive.
+     */
+    KNNClassifier(int k = 5, NeighborAlgorithm algorithm = NeighborAlgorithm::Auto, unsigned threads = 0)
+        : m_k(k), m_index(algorithm, 32, threads)
+    {
+        if (k <= 0)
+        {
+            throw std::invalid_argument("Number of neighbours must be positive");
+        }
+    }
+
+    /**
+     * @brief Fits the classifier to the provided data.
+     * 
+     * @param x A 2D vector of input features.
+     * @param y A vector of target class labels.
+     */
+    inline void fit(const std::vector<std::vector<double>>& x, const std::vector<int>& y)
+    {
+        fit(Matrix(x), y);
+    }
+
+    /**
+     * @brief Fits the classifier to the provided data.
+     * 
+     * @param x The data matrix, one sample per row.
+     * @param y A vector of target class labels.
+     */
+    inline void fit(const Matrix& x, const std::vector<int>& y)
+    {
+        m_index.setObserver(m_observer);
+        m_index.fit(x);
+        m_labels = y;
+    }
+
+    /**
+     * @brief Predicts the class label for a given input sample.
+     * 
+     * @param sample A vector representing the input features.
+     * 
+     * @return The predicted class label.
+     * 
+     * @throws std::invalid_argument if the classifier has not been fitted to any samples.
+     */
+    inline int predict(const std::vector<double>& sample) const
+    {
+        return vote(m_index.query(sample.data(), m_k));
+    }
+
+    /**
+     * @brief Predicts the class labels of every row of a matrix in parallel.
+     * 
+     * @param x The data matrix, one sample per row.
+     * 
+     * @return The predicted class label for each row.
+     * 
+     * @throws std::invalid_argument if the classifier has not been fitted to any samples.
+     */
+    inline std::vector<int> predictBatch(const Matrix& x) const
+    {
+        std::vector<std::vector<Neighbor>> neighbors = m_index.queryBatch(x, m_k);
+        std::vector<int> labels(neighbors.size());
+        for (std::size_t i = 0; i < neighbors.size(); ++i)
+        {
+            labels[i] = vote(neighbors[i]);
+        }
+        return labels;
+    }
+
+private:
+    int m_k;                   // Number of neighbours that vote.
+    NearestNeighbors m_index;  // Index over the training samples.
+    std::vector<int> m_labels; // Class label of each training sample.
+
+    /**
+     * @brief Returns the majority label among the neighbours, ties going to the closer one.
+     */
+    inline int vote(const std::vector<Neighbor>& neighbors) const
+    {
+        if (neighbors.empty())
+        {
+            throw std::invalid_argument("KNNClassifier has no fitted samples to vote");
+        }
+
+        std::vector<std::pair<int, int>> counts;
+        for (const Neighbor& neighbor : neighbors)
+        {
+            int label = m_labels[neighbor.m_index];
+            auto it = std::ranges::find_if(counts, [label](const auto& c) { return c.first == label; });
+            if (it == counts.end())
+            {
+                counts.emplace_back(label, 1);
+            }
+            else
+            {
+                it->second++;
+            }
+        }
+
+        return std::ranges::max_element(counts, [](const auto& a, const auto& b)
+        {
+            return a.second < b.second;
+        })->first;
+    }
+}; // class KNNClassifier
+
+/**
+ * @brief A class for performing k-nearest-neighbour regression.
+ */
+class KNNRegressor : public Observable
+{
+public:
+    /**
+     * @brief Constructs a KNNRegressor object.
+     * 
+     * @param k The number of neighbours averaged.
+     * @param algorithm The search algorithm.
+     * @param threads The number of worker threads for batch prediction (0 selects the hardware concurrency).
+     * 
+     * @throws std::invalid_argument if k is not positive.
+     */
+    KNNRegressor(int k = 5, NeighborAlgorithm algorithm = NeighborAlgorithm::Auto, unsigned threads = 0)
+        : m_k(k), m_index(algorithm, 32, threads)
+    {
+        if (k <= 0)
+        {
+            throw std::invalid_argument("Number of neighbours must be positive");
+        }
+    }
+
+    /**
+     * @brief Fits the regressor to the provided data.
+     * 
+     * @param x A 2D vector of input features.
+     * @param y A vector of target values.
+     */
+    inline void fit(const std::vector<std::vector<double>>& x, const std::vector<double>& y)
+    {
+        fit(Matrix(x), y);
+    }
+
+    /**
+     * @brief Fits the regressor to the provided data.
+     * 
+     * @param x The data matrix, one sample per row.
+     * @param y A vector of target values.
+     */
+    inline void fit(const Matrix& x, const std::vector<double>& y)
+    {
+        m_index.setObserver(m_observer);
+        m_index.fit(x);
+        m_targets = y;
+    }
+
+    /**
+     * @brief Predicts the target value for a given input sample.
+     * 
+     * @param sample A vector representing the input features.
+     * 
+     * @return The mean target of the k nearest neighbours.
+     */
+    inline double predict(const std::vector<double>& sample) const
+    {
+        return average(m_index.query(sample.data(), m_k));
+    }
+
+    /**
+     * @brief Predicts the target values of every row of a matrix in parallel.
+     * 
+     * @param x The data matrix, one sample per row.
+     * 
+     * @return The predicted target value for each row.
+     */
+    inline std::vector<double> predictBatch(const Matrix& x) const
+    {
+        std::vector<std::vector<Neighbor>> neighbors = m_index.queryBatch(x, m_k);
+        std::vector<double> values(neighbors.size());
+        for (std::size_t i = 0; i < neighbors.size(); ++i)
+        {
+            values[i] = average(neighbors[i]);
+        }
+        return values;
+    }
+
+private:
+    int m_k;                       // Number of neighbours averaged.
+    NearestNeighbors m_index;      // Index over the training samples.
+    std::vector<double> m_targets; // Target value of each training sample.
+
+    inline double average(const std::vector<Neighbor>& neighbors) const noexcept
+    {
+        double sum = 0.0;
+        for (const Neighbor& neighbor : neighbors)
+        {
+            sum += m_targets[neighbor.m_index];
+        }
+        return neighbors.empty() ? 0.0 : sum / neighbors.size();
+    }
+}; // class KNNRegressor
+
+/**
+ * @brief Computes the dot product of two vectors.
+ * 
+ * @param a The first vector.
+ * @param b The second vector.
+ * @param n The number of elements.
+ * 
+ * @return The dot product.
+ */
+inline double dot(const double* a, const double* b, std::size_t n) noexcept
+{
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        s0 += a[i] * b[i];
+        s1 += a[i + 1] * b[i + 1];
+        s2 += a[i + 2] * b[i + 2];
+        s3 += a[i + 3] * b[i + 3];
+    }
+
+    for (; i < n; ++i)
+    {
+        s0 += a[i] * b[i];
+    }
+
+    return (s0 + s1) + (s2 + s3);
+}
+
+/**
+ * @brief Computes c = a * b.
+ * 
+ * Rows of a are split over threads; within a thread the shared dimension and the
+ * columns of b are walked in tiles so the touched part of b stays in cache.
+ * 
+ * @param a An n x m matrix.
+ * @param b An m x p matrix.
+ * @param c Receives the n x p product.
+ * @param threads The number of worker threads (0 selects the hardware concurrency).
+ */
+inline void multiply(const Matrix& a, const Matrix& b, Matrix& c, unsigned threads = 0)
+{
+    constexpr std::size_t inner_tile = 128;
+    constexpr std::size_t column_tile = 512;
+    c.resize(a.rows(), b.cols());
+
+    parallelFor(a.rows(), threads, [&](std::size_t begin, std::size_t end, unsigned)
+    {
+        for (std::size_t kk = 0; kk < a.cols(); kk += inner_tile)
+        {
+            std::size_t k_end = std::min(a.cols(), kk + inner_tile);
+            for (std::size_t jj = 0; jj < b.cols(); jj += column_tile)
+            {
+                std::size_t j_end = std::min(b.cols(), jj + column_tile);
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    double* out = c.row(i);
+                    for (std::size_t k = kk; k < k_end; ++k)
+                    {
+                        double value = a(i, k);
+                        const double* in = b.row(k);
+                        for (std::size_t j = jj; j < j_end; ++j)
+                        {
+                            out[j] += value * in[j];
+                        }
+                    }
+                }
+            }
+        }
+    });
+}
+
+/**
+ * @brief Computes c = transpose(a) * b without forming the transpose.
+ * 
+ * Rows of c are split over threads, so every thread streams a and b once and
+ * writes a disjoint block of c.
+ * 
+ * @param a An n x m matrix.
+ * @param b An n x p matrix.
+ * @param c Receives the m x p product.
+ * @param threads The number of worker threads (0 selects the hardware concurrency).
+ */
+inline void multiplyTransposedA(const Matrix& a, const Matrix& b, Matrix& c, unsigned threads = 0)
+{
+    c.resize(a.cols(), b.cols());
+    parallelFor(a.cols(), threads, [&](std::size_t begin, std::size_t end, unsigned)
+    {
+        for (std::size_t i = 0; i < a.rows(); ++i)
+        {
+            const double* in = b.row(i);
+            for (std::size_t r = begin; r < end; ++r)
+            {
+                double value = a(i, r);
+                double* out = c.row(r);
+                for (std::size_t j = 0; j < b.cols(); ++j)
+                {
+                    out[j] += value * in[j];
+                }
+            }
+        }
+    });
+}
+
+/**
+ * @brief Computes c = a * transpose(b) as row-by-row dot products.
+ * 
+ * Rows of b are walked in tiles sized to stay in cache while every row of a
+ * assigned to the thread is multiplied against them.
+ * 
+ * @param a An n x m matrix.
+ * @param b A p x m matrix.
+ * @param c Receives the n x p product.
+ * @param threads The number of worker threads (0 selects the hardware concurrency).
+ */
+inline void multiplyTransposedB(const Matrix& a, const Matrix& b, Matrix& c, unsigned threads = 0)
+{
+    const std::size_t tile = std::max<std::size_t>(1, (64 * 1024) / (sizeof(double) * std::max<std::size_t>(1, b.cols())));
+    if (c.rows() != a.rows() || c.cols() != b.rows())
+    {
+        c.resize(a.rows(), b.rows());
+    }
+
+    parallelFor(a.rows(), threads, [&](std::size_t begin, std::size_t end, unsigned)
+    {
+        for (std::size_t jj = 0; jj < b.rows(); jj += tile)
+        {
+            std::size_t j_end = std::min(b.rows(), jj + tile);
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                double* out = c.row(i);
+                for (std::size_t j = jj; j < j_end; ++j)
+                {
+                    out[j] = dot(a.row(i), b.row(j), a.cols());
+                }
+            }
+        }
+    });
+}
+
+/**
+ * @brief Replaces the columns of a matrix with an orthonormal basis of their span (the Q of a thin QR).
+ * 
+ * Runs modified Gram-Schmidt twice on the transposed matrix so every column is contiguous.
+ * Columns that are linearly dependent on earlier ones become zero.
+ * 
+ * @param y An n x l matrix with l <= n.
+ */
+inline void orthonormalize(Matrix& y)
+{
+    const std::size_t n = y.rows();
+    const std::size_t l = y.cols();
+    Matrix t(l, n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        for (std::size_t j = 0; j < l; ++j)
+        {
+            t(j, i) = y(i, j);
+        }
+    }
+
+    for (std::size_t j = 0; j < l; ++j)
+    {
+        double* column = t.row(j);
+        double original = std::sqrt(dot(column, column, n));
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            for (std::size_t p = 0; p < j; ++p)
+            {
+                const double* previous = t.row(p);
+                double r = dot(column, previous, n);
+                for (std::size_t i = 0; i < n; ++i)
+                {
+                    column[i] -= r * previous[i];
+                }
+            }
+        }
+
+        double norm = std::sqrt(dot(column, column, n));
+        double scale = norm > 1e-12 * std::max(1.0, original) ? 1.0 / norm : 0.0;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            column[i] *= scale;
+        }
+    }
+
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        for (std::size_t j = 0; j < l; ++j)
+        {
+            y(i, j) = t(j, i);
+        }
+    }
+}
+
+/**
+ * @brief Computes the eigen decomposition of a small symmetric matrix with cyclic Jacobi rotations.
+ * 
+ * @param a A symmetric l x l matrix; it is destroyed.
+ * @param values Receives the eigenvalues in descending order.
+ * @param vectors Receives the matching eigenvectors as columns.
+ */
+inline void symmetricEigen(Matrix& a, std::vector<double>& values, Matrix& vectors)
+{
+    const std::size_t l = a.rows();
+    Matrix v(l, l);
+    for (std::size_t i = 0; i < l; ++i)
+    {
+        v(i, i) = 1.0;
+    }
+
+    for (int sweep = 0; sweep < 100; ++sweep)
+    {
+        double off = 0.0, total = 0.0;
+        for (std::size_t i = 0; i < l; ++i)
+        {
+            for (std::size_t j = 0; j < l; ++j)
+            {
+                total += a(i, j) * a(i, j);
+                off += i != j ? a(i, j) * a(i, j) : 0.0;
+            }
+        }
+        if (off <= 1e-30 * std::max(total, 1e-300))
+        {
+            break;
+        }
+
+        for (std::size_t p = 0; p + 1 < l; ++p)
+        {
+            for (std::size_t q = p + 1; q < l; ++q)
+            {
+                if (a(p, q) == 0.0)
+                {
+                    continue;
+                }
+
+                double theta = (a(q, q) - a(p, p)) / (2.0 * a(p, q));
+                double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta * theta + 1.0));
+                double c = 1.0 / std::sqrt(t * t + 1.0);
+                double s = t * c;
+
+                for (std::size_t k = 0; k < l; ++k)
+                {
+                    double akp = a(k, p), akq = a(k, q);
+                    a(k, p) = c * akp - s * akq;
+                    a(k, q) = s * akp + c * akq;
+                }
+                for (std::size_t k = 0; k < l; ++k)
+                {
+                    double apk = a(p, k), aqk = a(q, k);
+                    a(p, k) = c * apk - s * aqk;
+                    a(q, k) = s * apk + c * aqk;
+                }
+                for (std::size_t k = 0; k < l; ++k)
+                {
+                    double vkp = v(k, p), vkq = v(k, q);
+                    v(k, p) = c * vkp - s * vkq;
+                    v(k, q) = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+
+    std::vector<std::size_t> order(l);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](std::size_t x, std::size_t y) { return a(x, x) > a(y, y); });
+
+    values.resize(l);
+    vectors.resize(l, l);
+    for (std::size_t j = 0; j < l; ++j)
+    {
+        values[j] = a(order[j], order[j]);
+        for (std::size_t i = 0; i < l; ++i)
+        {
+            vectors(i, j) = v(i, order[j]);
+        }
+    }
+}
+
+/**
+ * @brief A class for performing Principal Component Analysis with a randomized SVD.
+ * 
+ * Instead of a full SVD of the n x d data, the column space is captured with a random
+ * projection onto (components + oversampling) directions, refined with a few power
+ * iterations and an orthonormalization, and only that thin basis is decomposed exactly.
+ * Centering is applied implicitly, so the training matrix is never copied.
+ */
+class PCA : public Observable
+{
+public:
+    /**
+     * @brief Constructs a PCA object.
+     * 
+     * @param components The number of principal components to keep.
+     * @param power_iterations The number of power iterations refining the random projection.
+     * @param oversampling The number of extra random directions sampled beyond the components.
+     * @param threads The number of worker threads (0 selects the hardware concurrency).
+     * @param seed The seed for the random projection.
+     */
+    PCA(int components, int power_iterations = 4, int oversampling = 10, unsigned threads = 0, std::uint64_t seed = DEFAULT_SEED)
+        : m_components(components), m_powerIterations(power_iterations), m_oversampling(oversampling),
+          m_threads(threads), m_seed(seed) {}
+
+    /**
+     * @brief Fits the principal components to the provided data.
+     * 
+     * @param x The data matrix, one sample per row.
+     * 
+     * @throws std::invalid_argument if more components are requested than the data has.
+     */
+    inline void fit(const Matrix& x)
+    {
+        const auto start = startStep();
+        const std::size_t n = x.rows();
+        const std::size_t d = x.cols();
+        const std::size_t k = static_cast<std::size_t>(m_components);
+        if (m_components <= 0 || k > std::min(n, d))
+        {
+            throw std::invalid_argument("PCA needs 0 < components <= min(rows, features)");
+        }
+
+        const std::size_t l = std::min(k + static_cast<std::size_t>(std::max(0, m_oversampling)), std::min(n, d));
+
+        // Column means, from per-thread partial sums
+        std::vector<std::vector<double>> partial(threadCount(m_threads, n), std::vector<double>(d));
+        parallelFor(n, m_threads, [&](std::size_t begin, std::size_t end, unsigned t)
+        {
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                const double* sample = x.row(i);
+                for (std::size_t j = 0; j < d; ++j)
+                {
+                    partial[t][j] += sample[j];
+                }
+            }
+        });
+
+        m_mean.assign(d, 0.0);
+        for (const std::vector<double>& sums : partial)
+        {
+            for (std::size_t j = 0; j < d; ++j)
+            {
+                m_mean[j] += sums[j];
+            }
+        }
+        for (double& value : m_mean)
+        {
+            value /= n;
+        }
+
+        // Random projection of the centered data onto l directions
+        Engine gen = makeEngine(m_seed);
+        std::normal_distribution<double> normal(0.0, 1.0);
+        Matrix omega(d, l);
+        for (std::size_t i = 0; i < d * l; ++i)
+        {
+            omega.data()[i] = normal(gen);
+        }
+
+        Matrix y, z;
+        projectCentered(x, omega, y);
+        orthonormalize(y);
+        for (int iteration = 0; iteration < m_powerIterations; ++iteration)
+        {
+            projectCenteredTransposed(x, y, z);
+            orthonormalize(z);
+            projectCentered(x, z, y);
+            orthonormalize(y);
+        }
+
+        // z = transpose(Xc) * Q is the transpose of the small l x d matrix B = transpose(Q) * Xc
+        projectCenteredTransposed(x, y, z);
+
+        // The left singular vectors of B are the eigenvectors of B * transpose(B) = transpose(z) * z
+        Matrix gram, eigenvectors;
+        std::vector<double> eigenvalues;
+        multiplyTransposedA(z, z, gram, m_threads);
+        symmetricEigen(gram, eigenvalues, eigenvectors);
+
+        // Right singular vectors: V = transpose(B) * U / sigma = z * U / sigma
+        Matrix v;
+        multiply(z, eigenvectors, v, m_threads);
+
+        m_componentsMatrix.resize(k, d);
+        m_explainedVariance.resize(k);
+        m_offsets.resize(k);
+        for (std::size_t c = 0; c < k; ++c)
+        {
+            double sigma = std::sqrt(std::max(0.0, eigenvalues[c]));
+            double scale = sigma > 0.0 ? 1.0 / sigma : 0.0;
+            for (std::size_t j = 0; j < d; ++j)
+            {
+                m_componentsMatrix(c, j) = v(j, c) * scale;
+            }
+            m_explainedVariance[c] = n > 1 ? sigma * sigma / (n - 1) : 0.0;
+            m_offsets[c] = dot(m_componentsMatrix.row(c), m_mean.data(), d);
+        }
+
+        if (m_observer)
+        {
+            const std::size_t bytes = (y.rows() * y.cols() + z.rows() * z.cols() + v.rows() * v.cols() + k * d) * sizeof(double);
+            report("PCA", TrainingStage::Fit, 0, start, std::numeric_limits<double>::quiet_NaN(), 0, bytes);
+        }
+    }
+
+    /**
+     * @brief Fits the principal components to the provided data.
+     * 
+     * @param x A 2D vector of input features.
+     */
+    inline void fit(const std::vector<std::vector<double>>& x)
+    {
+        fit(Matrix(x));
+    }
+
+    /**
+     * @brief Projects a single sample onto the principal components.
+     * 
+     * @param sample A vector representing the input features.
+     * 
+     * @return The reduced sample.
+     */
+    inline std::vector<double> transform(const std::vector<double>& sample) const
+    {
+        std::vector<double> reduced(m_componentsMatrix.rows());
+        for (std::size_t c = 0; c < reduced.size(); ++c)
+        {
+            reduced[c] = dot(m_componentsMatrix.row(c), sample.data(), m_componentsMatrix.cols()) - m_offsets[c];
+        }
+        return reduced;
+    }
+
+    /**
+     * @brief Projects every row of a matrix onto the principal components.
+     * 
+     * @param x The data matrix, one sample per row.
+     * 
+     * @return The reduced matrix, one sample per row.
+     */
+    inline Matrix transformBatch(const Matrix& x) const
+    {
+        Matrix out;
+        transformInto(x, out);
+        return out;
+    }
+
+    /**
+     * @brief Projects every row of a matrix onto the principal components, reusing an output buffer.
+     * 
+     * @param x The data matrix, one sample per row.
+     * @param out Receives the reduced matrix; it is only reallocated if its shape is wrong.
+     */
+    inline void transformInto(const Matrix& x, Matrix& out) const
+    {
+        multiplyTransposedB(x, m_componentsMatrix, out, m_threads);
+        parallelFor(out.rows(), m_threads, [&](std::size_t begin, std::size_t end, unsigned)
+        {
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                double* row = out.row(i);
+                for (std::size_t c = 0; c < out.cols(); ++c)
+                {
+                    row[c] -= m_offsets[c];
+                }
+            }
+        });
+    }
+
+    inline const Matrix& components() const noexcept { return m_componentsMatrix; }
+    inline const std::vector<double>& explainedVariance() const noexcept { return m_explainedVariance; }
+    inline const std::vector<double>& mean() const noexcept { return m_mean; }
+
+private:
+    int m_components;                        // Number of principal components to keep.
+    int m_powerIterations;                   // Number of power iterations.
+    int m_oversampling;                      // Extra random directions beyond the components.
+    unsigned m_threads;                      // Number of worker threads (0 = hardware concurrency).
+    std::uint64_t m_seed;                    // Seed for the random projection.
+    Matrix m_componentsMatrix;               // Principal axes, one per row.
+    std::vector<double> m_explainedVariance; // Variance along each principal axis.
+    std::vector<double> m_mean;              // Column means of the training data.
+    std::vector<double> m_offsets;           // Projection of the mean onto each axis.
+
+    /**
+     * @brief Computes out = (x - mean) * w without centering x.
+     */
+    inline void projectCentered(const Matrix& x, const Matrix& w, Matrix& out) const
+    {
+        multiply(x, w, out, m_threads);
+        std::vector<double> shift(w.cols(), 0.0);
+        for (std::size_t j = 0; j < w.rows(); ++j)
+        {
+            for (std::size_t c = 0; c < w.cols(); ++c)
+            {
+                shift[c] += m_mean[j] * w(j, c);
+            }
+        }
+
+        for (std::size_t i = 0; i < out.rows(); ++i)
+        {
+            for (std::size_t c = 0; c < out.cols(); ++c)
+            {
+                out(i, c) -= shift[c];
+            }
+        }
+    }
+
+    /**
+     * @brief Computes out = transpose(x - mean) * q without centering x.
+     */
+    inline void projectCenteredTransposed(const Matrix& x, const Matrix& q, Matrix& out) const
+    {
+        multiplyTransposedA(x, q, out, m_threads);
+        std::vector<double> sums(q.cols(), 0.0);
+        for (std::size_t i = 0; i < q.rows(); ++i)
+        {
+            for (std::size_t c = 0; c < q.cols(); ++c)
+            {
+                sums[c] += q(i, c);
+            }
+        }
+
+        for (std::size_t j = 0; j < out.rows(); ++j)
+        {
+            for (std::size_t c = 0; c < out.cols(); ++c)
+            {
+                out(j, c) -= m_mean[j] * sums[c];
+            }
+        }
+    }
+}; // class PCA
+
+/**
+ * @brief A feature preprocessing pipeline: standardization, one-hot encoding and binning.
+ * 
+ * Steps are declared per input column and emit their output columns in declaration
+ * order. fit() makes a single streaming pass in which every step updates its statistics
+ * from the row, and transformInto() makes a single pass that writes every output column
+ * of a row straight into a contiguous Matrix that models can train on.
+ */
+class Pipeline
+{
+public:
+    /**
+     * @brief Passes a column through unchanged.
+     * 
+     * @param column The input column.
+     * 
+     * @return A reference to this pipeline.
+     */
+    inline Pipeline& passthrough(std::size_t column)
+    {
+        return add(StepKind::Passthrough, column, 0);
+    }
+
+    /**
+     * @brief Scales a column to zero mean and unit variance.
+     * 
+     * @param column The input column.
+     * 
+     * @return A reference to this pipeline.
+     */
+    inline Pipeline& standardize(std::size_t column)
+    {
+        return add(StepKind::Standardize, column, 0);
+    }
+
+    /**
+     * @brief Expands a categorical column into one indicator column per category seen in fit().
+     * 
+     * Categories not seen in fit() encode as all zeros.
+     * 
+     * @param column The input column.
+     * 
+     * @return A reference to this pipeline.
+     */
+    inline Pipeline& oneHot(std::size_t column)
+    {
+        return add(StepKind::OneHot, column, 0);
+    }
+
+    /**
+     * @brief Replaces a column with the index of its equal-width bin between the fitted minimum and maximum.
+     * 
+     * @param column The input column.
+     * @param bins The number of bins.
+     * 
+     * @return A reference to this pipeline.
+     * 
+     * @throws std::invalid_argument if bins is not positive.
+     */
+    inline Pipeline& bin(std::size_t column, int bins)
+    {
+        if (bins <= 0)
+        {
+            throw std::invalid_argument("Number of bins must be positive");
+        }
+        return add(StepKind::Bin, column, bins);
+    }
+
+    /**
+     * @brief Computes the statistics of every step in one pass over the data.
+     * 
+     * @param x A 2D vector of input features.
+     */
+    inline void fit(const std::vector<std::vector<double>>& x)
+    {
+        for (Step& step : m_steps)
+        {
+            step.m_count = 0;
+            step.m_mean = step.m_m2 = 0.0;
+            step.m_min = std::numeric_limits<double>::max();
+            step.m_max = std::numeric_limits<double>::lowest();
+            step.m_categories.clear();
+        }
+
+        std::vector<std::map<double, std::size_t>> seen(m_steps.size());
+        for (const std::vector<double>& row : x)
+        {
+            for (std::size_t s = 0; s < m_steps.size(); ++s)
+            {
+                Step& step = m_steps[s];
+                double value = row[step.m_column];
+                switch (step.m_kind)
+                {
+                case StepKind::Standardize:
+                {
+                    // Welford's running mean and variance
+                    double delta = value - step.m_mean;
+                    step.m_mean += delta / ++step.m_count;
+                    step.m_m2 += delta * (value - step.m_mean);
+                    break;
+                }
+                case StepKind::OneHot:
+                    seen[s].emplace(value, 0);
+                    break;
+                case StepKind::Bin:
+                    step.m_min = std::min(step.m_min, value);
+                    step.m_max = std::max(step.m_max, value);
+                    break;
+                case StepKind::Passthrough:
+                    break;
+                }
+            }
+        }
+
+        m_outputSize = 0;
+        for (std::size_t s = 0; s < m_steps.size(); ++s)
+        {
+            Step& step = m_steps[s];
+            step.m_offset = m_outputSize;
+            switch (step.m_kind)
+            {
+            case StepKind::Standardize:
+            {
+                double variance = step.m_count > 0 ? step.m_m2 / step.m_count : 0.0;
+                step.m_scale = variance > 0.0 ? 1.0 / std::sqrt(variance) : 1.0;
+                m_outputSize += 1;
+                break;
+            }
+            case StepKind::OneHot:
+                for (const auto& category : seen[s])
+                {
+                    step.m_categories.push_back(category.first);
+                }
+                m_outputSize += step.m_categories.size();
+                break;
+            case StepKind::Bin:
+                step.m_scale = step.m_max > step.m_min ? step.m_bins / (step.m_max - step.m_min) : 0.0;
+                m_outputSize += 1;
+                break;
+            case StepKind::Passthrough:
+                m_outputSize += 1;
+                break;
+            }
+        }
+    }
+
+    /**
+     * @brief Transforms every row in a single fused pass into a contiguous matrix.
+     * 
+     * @param x A 2D vector of input features.
+     * @param out Receives one transformed row per input row; it is only reallocated if its shape is wrong.
+     * @param threads The number of worker threads (0 selects the hardware concurrency).
+     */
+    inline void transformInto(const std::vector<std::vector<double>>& x, Matrix& out, unsigned threads = 1) const
+    {
+        if (out.rows() != x.size() || out.cols() != m_outputSize)
+        {
+            out.resize(x.size(), m_outputSize);
+        }
 
-#include <iostream>
+        parallelFor(x.size(), threads, [&](std::size_t begin, std::size_t end, unsigned)
+        {
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                transformRow(x[i].data(), out.row(i));
+            }
+        });
+    }
 
-#endif
+    /**
+     * @brief Transforms a single row.
+     * 
+     * @param row A vector representing the input features.
+     * 
+     * @return The transformed features.
+     */
+    inline std::vector<double> transform(const std::vector<double>& row) const
+    {
+        std::vector<double> out(m_outputSize);
+        transformRow(row.data(), out.data());
+        return out;
+    }
 
-#include <algorithm>
-#include <map>
-#include <random>
-#include <memory>
+    /**
+     * @brief Fits the pipeline and transforms the same data.
+     * 
+     * @param x A 2D vector of input features.
+     * @param out Receives one transformed row per input row.
+     * @param threads The number of worker threads for the transform (0 selects the hardware concurrency).
+     */
+    inline void fitTransformInto(const std::vector<std::vector<double>>& x, Matrix& out, unsigned threads = 1)
+    {
+        fit(x);
+        transformInto(x, out, threads);
+    }
 
-namespace nstd
-{
+    /**
+     * @brief Returns the number of output columns produced by the fitted pipeline.
+     */
+    inline std::size_t outputSize() const noexcept { return m_outputSize; }
+
+private:
+    enum class StepKind
+    {
+        Passthrough,
+        Standardize,
+        OneHot,
+        Bin
+    };
+
+    /**
+     * @brief One declared step together with its fitted statistics.
+     */
+    struct Step
+    {
+        StepKind m_kind;                  // What the step does.
+        std::size_t m_column;             // Input column.
+        int m_bins;                       // Number of bins (Bin only).
+        std::size_t m_offset = 0;         // First output column.
+        std::size_t m_count = 0;          // Rows seen by fit (Standardize only).
+        double m_mean = 0.0;              // Running mean (Standardize only).
+        double m_m2 = 0.0;                // Running sum of squared deviations (Standardize only).
+        double m_min = 0.0;               // Smallest value seen (Bin only).
+        double m_max = 0.0;               // Largest value seen (Bin only).
+        double m_scale = 1.0;             // 1 / stddev, or bins / range.
+        std::vector<double> m_categories; // Sorted categories (OneHot only).
+    };
+
+    std::vector<Step> m_steps;    // Steps in output order.
+    std::size_t m_outputSize = 0; // Number of output columns after fit.
+
+    inline Pipeline& add(StepKind kind, std::size_t column, int bins)
+    {
+        Step step;
+        step.m_kind = kind;
+        step.m_column = column;
+        step.m_bins = bins;
+        m_steps.push_back(step);
+        return *this;
+    }
+
+    /**
+     * @brief Writes every output column of one row.
+     * 
+     * @param in The input features.
+     * @param out The output columns, outputSize() of them.
+     */
+    inline void transformRow(const double* in, double* out) const noexcept
+    {
+        for (const Step& step : m_steps)
+        {
+            double value = in[step.m_column];
+            double* target = out + step.m_offset;
+            switch (step.m_kind)
+            {
+            case StepKind::Passthrough:
+                *target = value;
+                break;
+            case StepKind::Standardize:
+                *target = (value - step.m_mean) * step.m_scale;
+                break;
+            case StepKind::OneHot:
+            {
+                std::fill(target, target + step.m_categories.size(), 0.0);
+                auto it = std::ranges::lower_bound(step.m_categories, value);
+                if (it != step.m_categories.end() && *it == value)
+                {
+                    target[it - step.m_categories.begin()] = 1.0;
+                }
+                break;
+            }
+            case StepKind::Bin:
+            {
+                double index = std::floor((value - step.m_min) * step.m_scale);
+                *target = std::clamp(index, 0.0, static_cast<double>(step.m_bins - 1));
+                break;
+            }
+            }
+        }
+    }
+}; // class Pipeline
 
 /**
- * @brief Machine Learning.
+ * @brief Maps class labels to dense ids.
+ * 
+ * @param rows The number of rows.
+ * @param label_at Returns the class label of row i.
+ * @param classes Receives the sorted unique class labels.
+ * 
+ * @return The dense class id of every row.
  */
-namespace ML
+template <typename LabelAt>
+inline std::vector<int> denseClasses(std::size_t rows, LabelAt&& label_at, std::vector<int>& classes)
 {
+    std::vector<int> ids(rows);
+    for (std::size_t i = 0; i < rows; ++i)
+    {
+        ids[i] = label_at(i);
+    }
+
+    classes = ids;
+    std::ranges::sort(classes);
+    classes.erase(std::unique(classes.begin(), classes.end()), classes.end());
+    for (int& id : ids)
+    {
+        id = static_cast<int>(std::ranges::lower_bound(classes, id) - classes.begin());
+    }
+
+    return ids;
+}
 
 /**
- * @brief A class for performing Linear Regression with L2 Regularization.
+ * @brief Computes the squared Euclidean distance between two points with per-dimension weights.
+ * 
+ * @param a The first point.
+ * @param b The second point.
+ * @param w The weight of every dimension.
+ * @param n The number of dimensions.
+ * 
+ * @return The weighted squared distance.
  */
-class LinearRegression
+inline double weightedSquaredDistance(const double* a, const double* b, const double* w, std::size_t n) noexcept
 {
-public:
-    /**
-     * @brief Constructs a LinearRegression object.
-     * 
-     * @param lambda The L2 regularization parameter.
-     */
-    LinearRegression(double lambda = 0.0) : m_slope(0), m_intercept(0), m_lambda(lambda) {}
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        double d0 = a[i] - b[i];
+        double d1 = a[i + 1] - b[i + 1];
+        double d2 = a[i + 2] - b[i + 2];
+        double d3 = a[i + 3] - b[i + 3];
+        s0 += d0 * d0 * w[i];
+        s1 += d1 * d1 * w[i + 1];
+        s2 += d2 * d2 * w[i + 2];
+        s3 += d3 * d3 * w[i + 3];
+    }
 
-    /**
-     * @brief Fits the linear regression model to the provided data.
-     * 
-     * @param x A vector of input features.
-     * @param y A vector of target values.
-     */
-    inline void fit(const std::vector<double>& x, const std::vector<double>& y) noexcept
+    for (; i < n; ++i)
     {
-        int n = x.size();
-        if (n == 0) return;
+        double d = a[i] - b[i];
+        s0 += d * d * w[i];
+    }
 
-        double x_mean = std::accumulate(x.begin(), x.end(), 0.0) / n;
-        double y_mean = std::accumulate(y.begin(), y.end(), 0.0) / n;
+    return (s0 + s1) + (s2 + s3);
+}
 
-        double numerator = 0, denominator = 0;
-        for (int i = 0; i < n; ++i)
+/**
+ * @brief Picks the largest of a set of scores and turns the scores into probabilities.
+ * 
+ * @param scores The joint log-likelihood of every class; overwritten with probabilities if requested.
+ * @param classes The number of classes.
+ * @param normalize Whether to convert the scores into probabilities.
+ * 
+ * @return The index of the largest score.
+ */
+inline std::size_t argmaxLogProbabilities(double* scores, std::size_t classes, bool normalize) noexcept
+{
+    std::size_t best = 0;
+    for (std::size_t c = 1; c < classes; ++c)
+    {
+        if (scores[c] > scores[best])
         {
-            numerator += (x[i] - x_mean) * (y[i] - y_mean);
-            denominator += (x[i] - x_mean) * (x[i] - x_mean);
+            best = c;
         }
-
-        m_slope = numerator / (denominator + m_lambda);
-        m_intercept = y_mean - m_slope * x_mean;
     }
 
-    /**
-     * @brief Predicts the target value for a given input feature.
-     * 
-     * @param x The input feature.
-     * 
-     * @return The predicted target value.
-     */
-    inline double predict(double x) const
+    if (normalize)
     {
-        return m_slope * x + m_intercept;
+        const double max_score = scores[best];
+        double sum = 0.0;
+        for (std::size_t c = 0; c < classes; ++c)
+        {
+            scores[c] = std::exp(scores[c] - max_score);
+            sum += scores[c];
+        }
+        for (std::size_t c = 0; c < classes; ++c)
+        {
+            scores[c] /= sum;
+        }
     }
 
-private:
-    double m_slope;     // Slope of the regression line.
-    double m_intercept; // Intercept of the regression line.
-    double m_lambda;    // L2 regularization parameter.
-}; // class LinearRegression
+    return best;
+}
 
 /**
- * @brief A class for performing Logistic Regression with support for multi-class classification.
+ * @brief A Gaussian Naive Bayes classifier.
+ * 
+ * Fitting is a single pass: every thread keeps per-class Welford accumulators for
+ * its rows, which are merged with Chan's parallel update at the end. Prediction
+ * evaluates each class's log-likelihood as a weighted squared distance to the class
+ * means over contiguous arrays.
  */
-class LogisticRegression
+class GaussianNaiveBayes : public Observable
 {
 public:
     /**
-     * @brief Constructs a LogisticRegression object.
+     * @brief Constructs a GaussianNaiveBayes object.
      * 
-     * @param num_classes The number of classes for classification.
+     * @param var_smoothing The fraction of the largest feature variance added to every variance.
+     * @param threads The number of worker threads (0 selects the hardware concurrency).
      */
-    LogisticRegression(int num_classes, int input_size) : num_classes(num_classes), m_inputSize(input_size)
-    {
-        m_weights.resize(num_classes, std::vector<double>(input_size));
-        m_biases.resize(num_classes);
-        initializeWeights();
-    }
+    GaussianNaiveBayes(double var_smoothing = 1e-9, unsigned threads = 0) : m_varSmoothing(var_smoothing), m_threads(threads) {}
 
     /**
-     * @brief Fits the logistic regression model to the provided data.
+     * @brief Fits the model to the provided data.
      * 
      * @param x A 2D vector of input features.
      * @param y A vector of target class labels.
-     * @param learning_rate The learning rate for gradient descent.
-     * @param epochs The number of iterations for training.
      */
-    inline void fit(const std::vector<std::vector<double>>& x,
-                    const std::vector<int>& y,
-                    double learning_rate = 0.01,
-                    int epochs = 10000) noexcept
+    inline void fit(const std::vector<std::vector<double>>& x, const std::vector<int>& y)
     {
-        for (int epoch = 0; epoch < epochs; ++epoch)
-        {
-            for (std::size_t i = 0; i < x.size(); ++i)
-            {
-                std::vector<double> scores = computeScores(x[i]);
-                std::vector<double> probs = softmax(scores);
-
-                // Update weights and biases
-                for (int j = 0; j < num_classes; ++j)
-                {
-                    double error = (j == y[i]) ? 1.0 : 0.0;
-                    for (std::size_t k = 0; k < static_cast<std::size_t>(m_inputSize); ++k)
-                    {
-                        m_weights[j][k] += learning_rate * (error - probs[j]) * x[i][k];
-                    }
-
-                    m_biases[j] += learning_rate * (error - probs[j]);
-                }
-            }
-        }
+        fit(DataView(x, y));
     }
 
     /**
-     * @brief Predicts the class probabilities for a given input sample.
+     * @brief Fits the model to the rows selected by a view.
      * 
-     * @param sample A vector representing the input features.
+     * @param data A view of the input features and target class labels.
+     */
+    inline void fit(const DataView& data)
+    {
+        train(data.size(), data.size() ? data.row(0).size() : 0, [&](std::size_t i) { return data.row(i).data(); },
+              [&](std::size_t i) { return data.label(i); });
+    }
+
+    /**
+     * @brief Fits the model to a contiguous matrix.
      * 
-     * @return A vector of predicted probabilities for each class.
+     * @param x The data matrix, one sample per row.
+     * @param y A vector of target class labels.
      */
-    inline std::vector<double> predict(const std::vector<double>& sample) const
+    inline void fit(const Matrix& x, const std::vector<int>& y)
     {
-        return softmax(computeScores(sample));
+        train(x.rows(), x.cols(), [&](std::size_t i) { return x.row(i); }, [&](std::size_t i) { return y[i]; });
     }
 
     /**
@@ -148,402 +5043,725 @@ public:
      * 
      * @return The predicted class label.
      */
-    inline int predictClass(const std::vector<double>& sample) const
+    inline int predict(const std::vector<double>& sample) const
     {
-        std::vector<double> probs = predict(sample);
-        return std::ranges::distance(probs.begin(), std::ranges::max_element(probs));
+        std::vector<double> scores(m_classes.size());
+        jointLogLikelihood(sample.data(), scores.data());
+        return m_classes[argmaxLogProbabilities(scores.data(), scores.size(), false)];
     }
 
-private:
-    int num_classes;                            // Number of classes for classification.
-    int m_inputSize;                            // Number of input features.
-    std::vector<std::vector<double>> m_weights; // Weights for each class.
-    std::vector<double> m_biases;               // Biases for each class.
-
     /**
-     * @brief Computes the raw scores for each class given an input sample.
+     * @brief Predicts the class probabilities for a given input sample.
      * 
      * @param sample A vector representing the input features.
      * 
-     * @return A vector of raw scores for each class.
+     * @return The probability of every class, in the order of classes().
      */
-    inline std::vector<double> computeScores(const std::vector<double>& sample) const
+    inline std::vector<double> predictProba(const std::vector<double>& sample) const
     {
-        std::vector<double> scores(num_classes, 0.0);
-        for (int i = 0; i < num_classes; ++i)
+        std::vector<double> scores(m_classes.size());
+        jointLogLikelihood(sample.data(), scores.data());
+        argmaxLogProbabilities(scores.data(), scores.size(), true);
+        return scores;
+    }
+
+    /**
+     * @brief Predicts the class label of every row of a matrix.
+     * 
+     * @param x The data matrix, one sample per row.
+     * 
+     * @return The predicted class label of every row.
+     */
+    inline std::vector<int> predictBatch(const Matrix& x) const
+    {
+        std::vector<int> labels(x.rows());
+        parallelFor(x.rows(), m_threads, [&](std::size_t begin, std::size_t end, unsigned)
         {
-            for (std::size_t j = 0; j < static_cast<std::size_t>(m_inputSize); ++j)
+            std::vector<double> scores(m_classes.size());
+            for (std::size_t i = begin; i < end; ++i)
             {
-                scores[i] += m_weights[i][j] * sample[j];
+                jointLogLikelihood(x.row(i), scores.data());
+                labels[i] = m_classes[argmaxLogProbabilities(scores.data(), scores.size(), false)];
             }
-            scores[i] += m_biases[i];
-        }
-
-        return scores;
+        });
+        return labels;
     }
 
+    inline const std::vector<int>& classes() const noexcept { return m_classes; }
+    inline const Matrix& means() const noexcept { return m_means; }
+    inline const Matrix& variances() const noexcept { return m_variances; }
+
+private:
+    double m_varSmoothing;              // Fraction of the largest variance added to every variance.
+    unsigned m_threads;                 // Number of worker threads.
+    std::vector<int> m_classes;         // Sorted unique class labels.
+    Matrix m_means;                     // Per-class feature means, one class per row.
+    Matrix m_variances;                 // Per-class feature variances, one class per row.
+    Matrix m_precisions;                // Per-class 1 / (2 * variance), one class per row.
+    std::vector<double> m_logConstants; // Per-class log prior minus the log normalizers.
+
     /**
-     * @brief Computes the softmax activation for multi-class classification.
-     * 
-     * @param scores A vector of raw scores for each class.
+     * @brief Running per-class moments of the rows seen by one thread.
+     */
+    struct Moments
+    {
+        std::vector<double> m_count; // Rows per class.
+        Matrix m_mean;               // Running means, one class per row.
+        Matrix m_m2;                 // Running sums of squared deviations, one class per row.
+    };
+
+    /**
+     * @brief Accumulates the per-class moments in one parallel pass and derives the model.
      * 
-     * @return A vector of softmax probabilities.
+     * @param rows The number of rows.
+     * @param features The number of features.
+     * @param row_at Returns a pointer to the features of row i.
+     * @param label_at Returns the class label of row i.
      */
-    inline std::vector<double> softmax(const std::vector<double>& scores) const
+    template <typename RowAt, typename LabelAt>
+    inline void train(std::size_t rows, std::size_t features, RowAt&& row_at, LabelAt&& label_at)
     {
-        std::vector<double> exp_scores(scores.size());
-        double max_score = *std::ranges::max_element(scores);
-        double sum_exp = 0.0;
+        const auto start = startStep();
+        const std::vector<int> ids = denseClasses(rows, label_at, m_classes);
+        const std::size_t classes = m_classes.size();
 
-        for (std::size_t i = 0; i < scores.size(); ++i)
+        std::vector<Moments> partial(threadCount(m_threads, rows),
+                                     Moments{ std::vector<double>(classes), Matrix(classes, features), Matrix(classes, features) });
+        parallelFor(rows, m_threads, [&](std::size_t begin, std::size_t end, unsigned t)
         {
-            exp_scores[i] = std::exp(scores[i] - max_score);
-            sum_exp += exp_scores[i];
-        }
+            Moments& moments = partial[t];
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                const double* sample = row_at(i);
+                const int c = ids[i];
+                const double n = ++moments.m_count[c];
+                double* mean = moments.m_mean.row(c);
+                double* m2 = moments.m_m2.row(c);
+                for (std::size_t j = 0; j < features; ++j)
+                {
+                    double delta = sample[j] - mean[j];
+                    mean[j] += delta / n;
+                    m2[j] += delta * (sample[j] - mean[j]);
+                }
+            }
+        });
 
-        for (std::size_t i = 0; i < exp_scores.size(); ++i)
+        Moments& total = partial[0];
+        for (std::size_t t = 1; t < partial.size(); ++t)
         {
-            exp_scores[i] /= sum_exp;
+            for (std::size_t c = 0; c < classes; ++c)
+            {
+                const double na = total.m_count[c], nb = partial[t].m_count[c];
+                if (nb == 0.0)
+                {
+                    continue;
+                }
+
+                const double n = na + nb;
+                for (std::size_t j = 0; j < features; ++j)
+                {
+                    double delta = partial[t].m_mean(c, j) - total.m_mean(c, j);
+                    total.m_mean(c, j) += delta * nb / n;
+                    total.m_m2(c, j) += partial[t].m_m2(c, j) + delta * delta * na * nb / n;
+                }
+                total.m_count[c] = n;
+            }
         }
 
-        return exp_scores;
-    }
+        m_means = std::move(total.m_mean);
+        m_variances = std::move(total.m_m2);
+        double max_variance = 0.0;
+        for (std::size_t c = 0; c < classes; ++c)
+        {
+            for (std::size_t j = 0; j < features; ++j)
+            {
+                m_variances(c, j) /= total.m_count[c];
+                max_variance = std::max(max_variance, m_variances(c, j));
+            }
+        }
 
-    /**
-     * @brief Initializes weights and biases randomly.
-     */
-    void initializeWeights()
-    {
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_real_distribution<> dis(-0.01, 0.01);
-        for (std::vector<double>& w : m_weights)
+        const double epsilon = std::max(m_varSmoothing * max_variance, std::numeric_limits<double>::min());
+        m_precisions.resize(classes, features);
+        m_logConstants.assign(classes, 0.0);
+        for (std::size_t c = 0; c < classes; ++c)
         {
-            for (double& weight : w)
+            double log_constant = std::log(total.m_count[c] / static_cast<double>(rows));
+            for (std::size_t j = 0; j < features; ++j)
             {
-                weight = dis(gen);
+                m_variances(c, j) += epsilon;
+                m_precisions(c, j) = 0.5 / m_variances(c, j);
+                log_constant -= 0.5 * std::log(2.0 * std::numbers::pi * m_variances(c, j));
             }
+            m_logConstants[c] = log_constant;
         }
 
-        for (double& bias : m_biases)
+        if (m_observer)
         {
-            bias = dis(gen);
+            const std::size_t bytes = (3 * classes * features + partial.size() * 2 * classes * features) * sizeof(double) + rows * sizeof(int);
+            report("GaussianNaiveBayes", TrainingStage::Fit, 0, start, std::numeric_limits<double>::quiet_NaN(), 0, bytes);
         }
     }
-}; // class LogisticRegression
-
-/**
- * @brief A struct representing a node in the decision tree.
- */
-struct TreeNode
-{
-    double m_value;                    // Value of the node (used for leaf nodes).
-    int m_featureIndex;                // Index of the feature used for splitting.
-    double m_threshold;                // Threshold value for the split.
-    std::shared_ptr<TreeNode> m_left;  // Pointer to the left child node.
-    std::shared_ptr<TreeNode> m_right; // Pointer to the right child node.
-    bool m_isLeaf;                     // Indicates if the node is a leaf.
 
-    TreeNode() : m_value(0), m_featureIndex(-1), m_threshold(0), m_left(nullptr), m_right(nullptr), m_isLeaf(true) {}
-};
+    /**
+     * @brief Computes the joint log-likelihood of a sample under every class.
+     * 
+     * @param sample A pointer to the input features.
+     * @param scores Receives one score per class.
+     */
+    inline void jointLogLikelihood(const double* sample, double* scores) const noexcept
+    {
+        for (std::size_t c = 0; c < m_classes.size(); ++c)
+        {
+            scores[c] = m_logConstants[c] - weightedSquaredDistance(sample, m_means.row(c), m_precisions.row(c), m_means.cols());
+        }
+    }
+}; // class GaussianNaiveBayes
 
 /**
- * @brief A class for performing Decision Tree classification.
+ * @brief A Multinomial Naive Bayes classifier for count or frequency features.
+ * 
+ * Fitting is a single pass summing feature counts per class into per-thread
+ * accumulators that are added up at the end; prediction is one dot product per class.
  */
-class DecisionTree
+class MultinomialNaiveBayes : public Observable
 {
 public:
     /**
-     * @brief Constructs a DecisionTree object.
+     * @brief Constructs a MultinomialNaiveBayes object.
      * 
-     * @param max_depth The maximum depth of the tree.
+     * @param alpha The additive (Laplace/Lidstone) smoothing parameter.
+     * @param threads The number of worker threads (0 selects the hardware concurrency).
      */
-    DecisionTree(int max_depth = 5) : m_root(nullptr), m_maxDepth(max_depth) {}
+    MultinomialNaiveBayes(double alpha = 1.0, unsigned threads = 0) : m_alpha(alpha), m_threads(threads) {}
 
     /**
-     * @brief Fits the decision tree model to the provided data.
+     * @brief Fits the model to the provided data.
      * 
-     * @param x A 2D vector of input features.
-     * @param y A vector of target values.
+     * @param x A 2D vector of non-negative feature counts.
+     * @param y A vector of target class labels.
      */
     inline void fit(const std::vector<std::vector<double>>& x, const std::vector<int>& y)
     {
-        m_root = buildTree(x, y, 0);
+        fit(DataView(x, y));
+    }
+
+    /**
+     * @brief Fits the model to the rows selected by a view.
+     * 
+     * @param data A view of the feature counts and target class labels.
+     */
+    inline void fit(const DataView& data)
+    {
+        train(data.size(), data.size() ? data.row(0).size() : 0, [&](std::size_t i) { return data.row(i).data(); },
+              [&](std::size_t i) { return data.label(i); });
+    }
+
+    /**
+     * @brief Fits the model to a contiguous matrix.
+     * 
+     * @param x The matrix of feature counts, one sample per row.
+     * @param y A vector of target class labels.
+     */
+    inline void fit(const Matrix& x, const std::vector<int>& y)
+    {
+        train(x.rows(), x.cols(), [&](std::size_t i) { return x.row(i); }, [&](std::size_t i) { return y[i]; });
     }
 
     /**
      * @brief Predicts the class label for a given input sample.
      * 
-     * @param sample A vector representing the input features.
+     * @param sample A vector of feature counts.
      * 
      * @return The predicted class label.
      */
     inline int predict(const std::vector<double>& sample) const
     {
-        return predict(sample, m_root);
+        std::vector<double> scores(m_classes.size());
+        jointLogLikelihood(sample.data(), scores.data());
+        return m_classes[argmaxLogProbabilities(scores.data(), scores.size(), false)];
     }
 
-private:
-    std::shared_ptr<TreeNode> m_root; // Pointer to the root node of the tree.
-    int m_maxDepth;                   // Maximum depth of the tree.
-
     /**
-     * @brief Builds the decision tree recursively.
+     * @brief Predicts the class probabilities for a given input sample.
      * 
-     * @param x A 2D vector of input features.
-     * @param y A vector of target values.
-     * @param depth The current depth of the tree.
+     * @param sample A vector of feature counts.
      * 
-     * @return A shared pointer to the root node of the constructed subtree.
+     * @return The probability of every class, in the order of classes().
      */
-    inline std::shared_ptr<TreeNode> buildTree(const std::vector<std::vector<double>>& x, const std::vector<int>& y, int depth)
+    inline std::vector<double> predictProba(const std::vector<double>& sample) const
     {
-        if (x.empty() || depth >= m_maxDepth)
-        {
-            return createLeafNode(y);
-        }
-
-        int best_feature = -1;
-        double best_threshold = 0.0;
-        double best_gain = 0.0;
-        std::vector<std::vector<double>> best_left_x, best_right_x;
-        std::vector<int> best_left_y, best_right_y;
+        std::vector<double> scores(m_classes.size());
+        jointLogLikelihood(sample.data(), scores.data());
+        argmaxLogProbabilities(scores.data(), scores.size(), true);
+        return scores;
+    }
 
-        for (std::size_t feature_index = 0; feature_index < x[0].size(); ++feature_index)
+    /**
+     * @brief Predicts the class label of every row of a matrix.
+     * 
+     * @param x The matrix of feature counts, one sample per row.
+     * 
+     * @return The predicted class label of every row.
+     */
+    inline std::vector<int> predictBatch(const Matrix& x) const
+    {
+        std::vector<int> labels(x.rows());
+        parallelFor(x.rows(), m_threads, [&](std::size_t begin, std::size_t end, unsigned)
         {
-            std::vector<double> thresholds;
-            for (const std::vector<double>& sample : x)
+            std::vector<double> scores(m_classes.size());
+            for (std::size_t i = begin; i < end; ++i)
             {
-                thresholds.push_back(sample[feature_index]);
+                jointLogLikelihood(x.row(i), scores.data());
+                labels[i] = m_classes[argmaxLogProbabilities(scores.data(), scores.size(), false)];
             }
+        });
+        return labels;
+    }
 
-            std::sort(thresholds.begin(), thresholds.end());
-            thresholds.erase(std::unique(thresholds.begin(), thresholds.end()), thresholds.end());
+    inline const std::vector<int>& classes() const noexcept { return m_classes; }
 
-            for (const double threshold : thresholds)
-            {
-                std::vector<std::vector<double>> left_x, right_x;
-                std::vector<int> left_y, right_y;
+    /**
+     * @brief Returns the smoothed log probability of every feature, one class per row.
+     */
+    inline const Matrix& featureLogProbabilities() const noexcept { return m_featureLogProbabilities; }
 
-                for (std::size_t i = 0; i < x.size(); ++i)
-                {
-                    if (x[i][feature_index] <= threshold)
-                    {
-                        left_x.push_back(x[i]);
-                        left_y.push_back(y[i]);
-                    }
-                    else
-                    {
-                        right_x.push_back(x[i]);
-                        right_y.push_back(y[i]);
-                    }
-                }
+private:
+    double m_alpha;                      // Additive smoothing parameter.
+    unsigned m_threads;                  // Number of worker threads.
+    std::vector<int> m_classes;          // Sorted unique class labels.
+    Matrix m_featureLogProbabilities;    // Per-class log feature probabilities, one class per row.
+    std::vector<double> m_logPriors;     // Per-class log priors.
 
-                double gain = informationGain(y, left_y, right_y);
-                if (gain > best_gain)
+    /**
+     * @brief Sums the feature counts per class in one parallel pass and derives the model.
+     * 
+     * @param rows The number of rows.
+     * @param features The number of features.
+     * @param row_at Returns a pointer to the features of row i.
+     * @param label_at Returns the class label of row i.
+     */
+    template <typename RowAt, typename LabelAt>
+    inline void train(std::size_t rows, std::size_t features, RowAt&& row_at, LabelAt&& label_at)
+    {
+        const auto start = startStep();
+        const std::vector<int> ids = denseClasses(rows, label_at, m_classes);
+        const std::size_t classes = m_classes.size();
+
+        std::vector<Matrix> sums(threadCount(m_threads, rows), Matrix(classes, features + 1)); // Last column counts rows
+        parallelFor(rows, m_threads, [&](std::size_t begin, std::size_t end, unsigned t)
+        {
+            Matrix& sum = sums[t];
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                const double* sample = row_at(i);
+                double* counts = sum.row(ids[i]);
+                for (std::size_t j = 0; j < features; ++j)
                 {
-                    best_gain = gain;
-                    best_feature = feature_index;
-                    best_threshold = threshold;
-                    best_left_x = left_x;
-                    best_right_x = right_x;
-                    best_left_y = left_y;
-                    best_right_y = right_y;
+                    counts[j] += sample[j];
                 }
+                counts[features] += 1.0;
             }
-        }
+        });
 
-        if (best_gain == 0.0)
+        for (std::size_t t = 1; t < sums.size(); ++t)
         {
-            return createLeafNode(y);
+            std::transform(sums[0].data(), sums[0].data() + classes * (features + 1), sums[t].data(), sums[0].data(), std::plus<>());
         }
 
-        std::shared_ptr<TreeNode> node = std::make_shared<TreeNode>();
-        node->m_featureIndex = best_feature;
-        node->m_threshold = best_threshold;
-        node->m_left = buildTree(best_left_x, best_left_y, depth + 1);
-        node->m_right = buildTree(best_right_x, best_right_y, depth + 1);
-        node->m_isLeaf = false;
+        m_featureLogProbabilities.resize(classes, features);
+        m_logPriors.assign(classes, 0.0);
+        for (std::size_t c = 0; c < classes; ++c)
+        {
+            const double* counts = sums[0].row(c);
+            const double total = std::accumulate(counts, counts + features, 0.0) + m_alpha * features;
+            for (std::size_t j = 0; j < features; ++j)
+            {
+                m_featureLogProbabilities(c, j) = std::log((counts[j] + m_alpha) / total);
+            }
+            m_logPriors[c] = std::log(counts[features] / static_cast<double>(rows));
+        }
 
-        return node;
+        if (m_observer)
+        {
+            const std::size_t bytes = (classes * features + sums.size() * classes * (features + 1)) * sizeof(double) + rows * sizeof(int);
+            report("MultinomialNaiveBayes", TrainingStage::Fit, 0, start, std::numeric_limits<double>::quiet_NaN(), 0, bytes);
+        }
     }
 
     /**
-     * @brief Creates a leaf node with the most common class label.
-     * 
-     * @param y A vector of target values.
+     * @brief Computes the joint log-likelihood of a sample under every class.
      * 
-     * @return A shared pointer to the created leaf node.
+     * @param sample A pointer to the feature counts.
+     * @param scores Receives one score per class.
      */
-    inline std::shared_ptr<TreeNode> createLeafNode(const std::vector<int>& y)
+    inline void jointLogLikelihood(const double* sample, double* scores) const noexcept
     {
-        std::shared_ptr<nstd::ML::TreeNode> node = std::make_shared<TreeNode>();
-        std::map<int, int> counts;
-        for (const int label : y)
+        for (std::size_t c = 0; c < m_classes.size(); ++c)
         {
-             counts[label]++;
+            scores[c] = m_logPriors[c] + dot(sample, m_featureLogProbabilities.row(c), m_featureLogProbabilities.cols());
         }
-
-        node->m_value = std::max_element(counts.begin(), counts.end(), [](const auto& a, const auto& b)
-        {
-            return a.second < b.second;
-        })->first;
-
-        node->m_isLeaf = true;
-
-        return node;
     }
+}; // class MultinomialNaiveBayes
 
+/**
+ * @brief A work-stealing thread pool.
+ * 
+ * Every worker owns a task deque. Tasks submitted from outside the pool are spread
+ * round-robin over the deques; tasks submitted from a worker go to its own deque.
+ * Workers take their newest task first and, when idle, steal the oldest task of
+ * another worker, so uneven jobs (a deep forest next to a shallow one) keep every
+ * core busy.
+ */
+class ThreadPool
+{
+public:
     /**
-     * @brief Computes the information gain from a split.
-     * 
-     * @param parent_y A vector of target values before the split.
-     * @param left_y A vector of target values for the left child.
-     * @param right_y A vector of target values for the right child.
+     * @brief Starts the worker threads.
      * 
-     * @return The information gain from the split.
+     * @param threads The number of workers (0 selects the hardware concurrency).
      */
-    inline double informationGain(const std::vector<int>& parent_y, const std::vector<int>& left_y, const std::vector<int>& right_y)
+    explicit ThreadPool(unsigned threads = 0)
     {
-        double parent_entropy = entropy(parent_y);
-        double left_entropy = entropy(left_y);
-        double right_entropy = entropy(right_y);
-        double weighted_entropy = (left_y.size() * left_entropy + right_y.size() * right_entropy) / parent_y.size();
-        return parent_entropy - weighted_entropy;
+        threads = threadCount(threads, std::numeric_limits<std::size_t>::max());
+        for (unsigned i = 0; i < threads; ++i)
+        {
+            m_queues.push_back(std::make_unique<Queue>());
+        }
+        for (unsigned i = 0; i < threads; ++i)
+        {
+            m_workers.emplace_back([this, i]() { run(i); });
+        }
     }
 
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
     /**
-     * @brief Computes the entropy of a set of labels.
-     * 
-     * @param y A vector of target values.
-     * 
-     * @return The entropy of the labels.
+     * @brief Finishes the queued tasks and joins the workers.
      */
-    inline double entropy(const std::vector<int>& y)
+    ~ThreadPool()
     {
-        std::map<int, int> counts;
-        for (const int label : y)
         {
-            counts[label]++;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
         }
-
-        double entropy = 0.0;
-        for (const auto& count : counts)
+        m_wake.notify_all();
+        for (std::thread& worker : m_workers)
         {
-            double probability = static_cast<double>(count.second) / y.size();
-            entropy -= probability * std::log2(probability);
+            worker.join();
         }
-
-        return entropy;
     }
 
     /**
-     * @brief Predicts the class label for a given input sample using the decision tree.
+     * @brief Queues a task.
      * 
-     * @param sample A vector representing the input features.
-     * @param node A pointer to the current node in the tree.
-     * 
-     * @return The predicted class label.
+     * @param task The task to run.
      */
-    inline int predict(const std::vector<double>& sample, const std::shared_ptr<TreeNode>& node) const
+    inline void submit(std::function<void()> task)
     {
-        if (node->m_isLeaf)
         {
-            return static_cast<int>(node->m_value);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_queued;
+            ++m_pending;
         }
-        if (sample[node->m_featureIndex] <= node->m_threshold)
+
+        std::size_t target = s_owner == this ? s_index : m_next++ % m_queues.size();
         {
-            return predict(sample, node->m_left);
+            std::lock_guard<std::mutex> lock(m_queues[target]->m_mutex);
+            m_queues[target]->m_tasks.push_back(std::move(task));
         }
-        else
+        m_wake.notify_one();
+    }
+
+    /**
+     * @brief Blocks until every submitted task has finished. Must not be called from a worker.
+     * 
+     * @throws The first exception thrown by a task, if any.
+     */
+    inline void wait()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this]() { return m_pending == 0; });
+        if (m_error)
         {
-            return predict(sample, node->m_right);
+            std::exception_ptr error = std::exchange(m_error, nullptr);
+            std::rethrow_exception(error);
         }
     }
-}; // class DecisionTree
 
-/**
- * @brief A class for performing Random Forest classification.
- */
-class RandomForest
-{
-public:
+    inline unsigned size() const noexcept { return static_cast<unsigned>(m_workers.size()); }
+
+private:
     /**
-     * @brief Constructs a RandomForest object.
-     * 
-     * @param m_trees The number of trees in the forest.
-     * @param max_depth The maximum depth of each tree.
+     * @brief The task deque of one worker.
      */
-    RandomForest(int m_trees, int max_depth = 5) : m_trees(m_trees), m_maxDepth(max_depth) {}
+    struct Queue
+    {
+        std::mutex m_mutex;                         // Guards the deque.
+        std::deque<std::function<void()>> m_tasks; // Tasks, newest at the back.
+    };
+
+    std::vector<std::unique_ptr<Queue>> m_queues; // One deque per worker.
+    std::vector<std::thread> m_workers;           // Worker threads.
+    std::mutex m_mutex;                           // Guards the counters below.
+    std::condition_variable m_wake;               // Signals idle workers that tasks are queued.
+    std::condition_variable m_done;               // Signals wait() that every task finished.
+    std::size_t m_queued = 0;                     // Tasks submitted but not taken by a worker.
+    std::size_t m_pending = 0;                    // Tasks submitted but not finished.
+    std::atomic<std::size_t> m_next{0};           // Round-robin cursor for external submissions.
+    std::exception_ptr m_error;                   // First exception thrown by a task.
+    bool m_stop = false;                          // Set when the pool shuts down.
+
+    static inline thread_local ThreadPool* s_owner = nullptr; // Pool the current thread works for.
+    static inline thread_local std::size_t s_index = 0;       // Index of the current worker in s_owner.
 
     /**
-     * @brief Fits the random forest model to the provided data.
-     * 
-     * @param x A 2D vector of input features.
-     * @param y A vector of target values.
+     * @brief Takes the newest task of a worker's own deque, or steals the oldest task of another one.
      */
-    inline void fit(const std::vector<std::vector<double>>& x, const std::vector<int>& y)
+    inline bool take(std::size_t index, std::function<void()>& task)
     {
-        for (int i = 0; i < m_trees; ++i)
         {
-            DecisionTree tree(m_maxDepth);
-            std::vector<std::vector<double>> sample_x;
-            std::vector<int> sample_y;
-            bootstrapSample(x, y, sample_x, sample_y);
-            tree.fit(sample_x, sample_y);
-            trees.push_back(tree);
+            Queue& own = *m_queues[index];
+            std::lock_guard<std::mutex> lock(own.m_mutex);
+            if (!own.m_tasks.empty())
+            {
+                task = std::move(own.m_tasks.back());
+                own.m_tasks.pop_back();
+                return true;
+            }
+        }
+
+        for (std::size_t offset = 1; offset < m_queues.size(); ++offset)
+        {
+            Queue& victim = *m_queues[(index + offset) % m_queues.size()];
+            std::lock_guard<std::mutex> lock(victim.m_mutex);
+            if (!victim.m_tasks.empty())
+            {
+                task = std::move(victim.m_tasks.front());
+                victim.m_tasks.pop_front();
+                return true;
+            }
         }
+
+        return false;
     }
 
     /**
-     * @brief Predicts the class label for a given input sample.
-     * 
-     * @param sample A vector representing the input features.
-     * 
-     * @return The predicted class label.
+     * @brief The loop of one worker thread.
      */
-    inline int predict(const std::vector<double>& sample) const
+    inline void run(std::size_t index)
     {
-        std::map<int, int> votes;
-        for (const DecisionTree& tree : trees)
+        s_owner = this;
+        s_index = index;
+        for (;;)
         {
-            int prediction = tree.predict(sample);
-            votes[prediction]++;
+            std::function<void()> task;
+            if (take(index, task))
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    --m_queued;
+                }
+
+                try
+                {
+                    task();
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    if (!m_error)
+                    {
+                        m_error = std::current_exception();
+                    }
+                }
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (--m_pending == 0)
+                {
+                    m_done.notify_all();
+                }
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this]() { return m_stop || m_queued > 0; });
+            if (m_stop && m_queued == 0)
+            {
+                return;
+            }
         }
+    }
+}; // class ThreadPool
 
-        return std::ranges::max_element(votes, [](const auto& a, const auto& b)
+/**
+ * @brief A struct representing one train/test split of a data set.
+ */
+struct Fold
+{
+    std::vector<std::size_t> m_train; // Rows used for fitting.
+    std::vector<std::size_t> m_test;  // Rows used for scoring.
+};
+
+/**
+ * @brief Splits the rows of a data set into k shuffled folds.
+ * 
+ * @param rows The number of rows.
+ * @param folds The number of folds.
+ * @param seed The seed for the shuffle.
+ * 
+ * @return One split per fold, each holding out a different part of the rows.
+ * 
+ * @throws std::invalid_argument if there are fewer rows than folds or fewer than two folds.
+ */
+inline std::vector<Fold> kFold(std::size_t rows, int folds, std::uint64_t seed = DEFAULT_SEED)
+{
+    if (folds < 2 || rows < static_cast<std::size_t>(folds))
+    {
+        throw std::invalid_argument("k-fold needs at least two folds and one row per fold");
+    }
+
+    std::vector<std::size_t> order(rows);
+    std::iota(order.begin(), order.end(), 0);
+    Engine gen = makeEngine(seed);
+    std::shuffle(order.begin(), order.end(), gen);
+
+    std::vector<Fold> result(folds);
+    for (int f = 0; f < folds; ++f)
+    {
+        std::size_t begin = rows * f / folds;
+        std::size_t end = rows * (f + 1) / folds;
+        result[f].m_test.assign(order.begin() + begin, order.begin() + end);
+        result[f].m_train.reserve(rows - (end - begin));
+        result[f].m_train.insert(result[f].m_train.end(), order.begin(), order.begin() + begin);
+        result[f].m_train.insert(result[f].m_train.end(), order.begin() + end, order.end());
+    }
+    return result;
+}
+
+/**
+ * @brief Computes the fraction of rows of a view a classifier labels correctly.
+ * 
+ * @param model A fitted model with predict() or predictClass() returning a label.
+ * @param data A view of the rows to score.
+ * 
+ * @return The accuracy in [0, 1].
+ */
+template <typename Model>
+inline double accuracy(const Model& model, const DataView& data)
+{
+    std::size_t correct = 0;
+    for (std::size_t i = 0; i < data.size(); ++i)
+    {
+        int predicted;
+        if constexpr (requires { model.predictClass(data.row(i)); })
         {
-            return a.second < b.second;
-        })->first;
+            predicted = model.predictClass(data.row(i));
+        }
+        else
+        {
+            predicted = model.predict(data.row(i));
+        }
+        correct += predicted == data.label(i);
     }
+    return data.size() ? static_cast<double>(correct) / data.size() : 0.0;
+}
 
-private:
-    int m_trees;                          // Number of trees in the forest.
-    int m_maxDepth;                       // Maximum depth of each tree.
-    std::vector<DecisionTree> trees;      // Vector of decision trees.
+/**
+ * @brief The cross-validated outcome of one parameter setting.
+ */
+template <typename Params>
+struct GridSearchResult
+{
+    Params m_params;                 // The parameter setting.
+    std::vector<double> m_scores;    // Score of every fold.
+    double m_meanScore = 0.0;        // Mean of the fold scores.
+    double m_stdScore = 0.0;         // Standard deviation of the fold scores.
+    double m_seconds = 0.0;          // Wall time of all folds of this setting, summed.
+};
 
-    /**
-     * @brief Creates a bootstrap sample from the provided data.
-     * 
-     * @param x A 2D vector of input features.
-     * @param y A vector of target values.
-     * @param sample_x A reference to a vector to store the sampled input features.
-     * @param sample_y A reference to a vector to store the sampled target values.
-     */
-    inline void bootstrapSample(const std::vector<std::vector<double>>& x, const std::vector<int>& y,
-                                std::vector<std::vector<double>>& sample_x, std::vector<int>& sample_y) noexcept
+/**
+ * @brief Cross-validates every parameter setting of a grid in parallel.
+ * 
+ * Every (setting, fold) pair is one job on a work-stealing ThreadPool. All jobs read
+ * the same data set through DataView index views, so it is never copied.
+ * 
+ * @param x A 2D vector of input features.
+ * @param y A vector of target class labels.
+ * @param grid The parameter settings to try.
+ * @param evaluate Called as evaluate(params, train, test) and returns a score, higher is better.
+ * @param folds The number of folds.
+ * @param threads The number of worker threads (0 selects the hardware concurrency).
+ * @param seed The seed for the fold shuffle.
+ * 
+ * @return One result per setting, in the order of the grid.
+ */
+template <typename Params, typename Evaluate>
+inline std::vector<GridSearchResult<Params>> gridSearch(const std::vector<std::vector<double>>& x, const std::vector<int>& y,
+                                                        const std::vector<Params>& grid, Evaluate&& evaluate, int folds = 5,
+                                                        unsigned threads = 0, std::uint64_t seed = DEFAULT_SEED)
+{
+    std::vector<Fold> splits = kFold(x.size(), folds, seed);
+    std::vector<GridSearchResult<Params>> results(grid.size());
+    std::vector<double> seconds(grid.size() * folds);
+
+    ThreadPool pool(threads);
+    for (std::size_t p = 0; p < grid.size(); ++p)
     {
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_int_distribution<> dis(0, x.size() - 1);
-        for (std::size_t i = 0; i < x.size(); ++i)
+        results[p].m_params = grid[p];
+        results[p].m_scores.resize(folds);
+        for (int f = 0; f < folds; ++f)
         {
-            int index = dis(gen);
-            sample_x.push_back(x[index]);
-            sample_y.push_back(y[index]);
+            pool.submit([&, p, f]()
+            {
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                DataView train(x, y, splits[f].m_train);
+                DataView test(x, y, splits[f].m_test);
+                results[p].m_scores[f] = evaluate(grid[p], train, test);
+                seconds[p * folds + f] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            });
         }
     }
-}; // class RandomForest
+    pool.wait();
+
+    for (std::size_t p = 0; p < grid.size(); ++p)
+    {
+        GridSearchResult<Params>& result = results[p];
+        result.m_meanScore = std::accumulate(result.m_scores.begin(), result.m_scores.end(), 0.0) / folds;
+        double variance = 0.0;
+        for (const double score : result.m_scores)
+        {
+            variance += (score - result.m_meanScore) * (score - result.m_meanScore);
+        }
+        result.m_stdScore = std::sqrt(variance / folds);
+        result.m_seconds = std::accumulate(seconds.begin() + p * folds, seconds.begin() + (p + 1) * folds, 0.0);
+    }
+
+    return results;
+}
+
+/**
+ * @brief Cross-validates a single model configuration in parallel.
+ * 
+ * @param x A 2D vector of input features.
+ * @param y A vector of target class labels.
+ * @param evaluate Called as evaluate(train, test) and returns a score, higher is better.
+ * @param folds The number of folds.
+ * @param threads The number of worker threads (0 selects the hardware concurrency).
+ * @param seed The seed for the fold shuffle.
+ * 
+ * @return The score of every fold.
+ */
+template <typename Evaluate>
+inline std::vector<double> crossValidate(const std::vector<std::vector<double>>& x, const std::vector<int>& y,
+                                         Evaluate&& evaluate, int folds = 5, unsigned threads = 0, std::uint64_t seed = DEFAULT_SEED)
+{
+    std::vector<int> grid = {0};
+    return gridSearch(x, y, grid, [&](int, const DataView& train, const DataView& test)
+    {
+        return evaluate(train, test);
+    }, folds, threads, seed)[0].m_scores;
+}
 
 #ifdef NEURALNETWORK
 
@@ -552,7 +5770,7 @@ private:
  * 
  * @brief A class for performing Neural Network classification.
  */
-class NeuralNetwork
+class NeuralNetwork : public Observable
 {
 public:
     /**
@@ -561,15 +5779,16 @@ public:
      * @param input_size The number of input features.
      * @param hidden_size The number of hidden neurons.
      * @param output_size The number of output neurons.
+     * @param seed The seed for weight initialization.
      */
-    NeuralNetwork(int input_size, int hidden_size, int output_size) 
+    NeuralNetwork(int input_size, int hidden_size, int output_size, std::uint64_t seed = DEFAULT_SEED) 
         : m_inputSize(input_size), m_hiddenSize(hidden_size), m_outputSize(output_size)
     {
         m_weightsInputHidden.resize(hidden_size, std::vector<double>(input_size));
         m_weightsHiddenOutput.resize(output_size, std::vector<double>(hidden_size));
         m_biasesHidden.resize(hidden_size);
         m_biasesOutput.resize(output_size);
-        initializeWeights();
+        initializeWeights(seed);
     }
 
     /**
@@ -581,10 +5800,11 @@ public:
      * @param epochs The number of iterations for training.
     */
     inline void fit(const std::vector<std::vector<double>>& x, const std::vector<std::vector<double>>& y, 
-                    double learning_rate = 0.01, int epochs = 10000) noexcept
+                    double learning_rate = 0.01, int epochs = 10000)
     {
         for (int epoch = 0; epoch < epochs; ++epoch)
         {
+            const auto start = startStep();
             for (std::size_t i = 0; i < x.size(); ++i)
             {
                 // Forward pass
@@ -603,7 +5823,11 @@ public:
                 updateBiases(m_biasesHidden, hidden_error, learning_rate);
             }
 
-            std::cout << "Epoch " << epoch << ", Loss: " << computeLoss(x, y) << std::endl;
+            if (m_observer)
+            {
+                const std::size_t parameters = m_hiddenSize * (m_inputSize + 1) + m_outputSize * (m_hiddenSize + 1);
+                report("NeuralNetwork", TrainingStage::Epoch, epoch, start, computeLoss(x, y), 0, parameters * sizeof(double));
+            }
         }
     }
 
@@ -631,11 +5855,12 @@ private:
 
     /**
      * @brief Initializes weights and biases randomly.
+     * 
+     * @param seed The seed for the initialization.
      */
-    inline void initializeWeights() noexcept
+    inline void initializeWeights(std::uint64_t seed) noexcept
     {
-        std::random_device rd;
-        std::mt19937 gen(rd());
+        Engine gen = makeEngine(seed);
         std::uniform_real_distribution<> dis(-1.0, 1.0);
         for (std::vector<double>& row : m_weightsInputHidden)
         {
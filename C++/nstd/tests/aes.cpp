@@ -1,8 +1,22 @@
 #include <iostream>
+#include <algorithm>
 #include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
 #include <iomanip>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
 #include <aes.hpp>
 
+#ifndef _WIN32
+#include <sys/wait.h>
+#endif
+
 using namespace nstd::aes;
 
 void printArray(const std::uint8_t* array, std::size_t size) 
@@ -17,10 +31,11 @@ void printArray(const std::uint8_t* array, std::size_t size)
 
 void test()
 {
-    std::array<std::uint8_t, 16> input = { 0x32, 0x88, 0x31, 0xe0, 0x43, 0x5a, 0x31, 0x37,
-                                           0xf6, 0x30, 0x98, 0x07, 0xa8, 0x8d, 0xa2, 0x34 };
+    // FIPS-197 Appendix B
+    std::array<std::uint8_t, 16> input = { 0x32, 0x43, 0xf6, 0xa8, 0x88, 0x5a, 0x30, 0x8d,
+                                           0x31, 0x31, 0x98, 0xa2, 0xe0, 0x37, 0x07, 0x34 };
     std::array<std::uint8_t, 16> key = { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
-                                         0xab, 0xf7, 0x97, 0x67, 0x45, 0x61, 0x4c, 0x2b };
+                                         0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c };
     std::array<std::uint8_t, 16> encryptedOutput;
     std::array<std::uint8_t, 16> decryptedOutput;
 
@@ -32,17 +47,652 @@ void test()
     std::cout << "Input:            ";
     printArray(input.data(), input.size());
     std::cout << "Encrypted Output: ";
-    printArray(encryptedOutput.data(), encryptedOutput.size());
+    printArray(encryptedOutput.data(), encryptedOutput.size()); // Expected: 39 25 84 1d 02 dc 09 fb dc 11 85 97 19 6a 0b 32
     std::cout << "Decrypted Output: ";
-    printArray(decryptedOutput.data(), decryptedOutput.size());
+    printArray(decryptedOutput.data(), decryptedOutput.size()); // Expected: same as Input
+}
+
+
+void testKeySchedule()
+{
+    // FIPS-197 Appendix C.1
+    std::array<std::uint8_t, 16> key;
+    std::array<std::uint8_t, 16> plain;
+    for (int i = 0; i < 16; ++i)
+    {
+        key[i] = static_cast<std::uint8_t>(i);
+        plain[i] = static_cast<std::uint8_t>(i * 0x11);
+    }
+
+    key_schedule schedule(key.data());
+    std::array<std::uint8_t, 16> block;
+    schedule.encryptBlock(plain.data(), block.data());
+    std::cout << "C.1 Encrypted:    ";
+    printArray(block.data(), block.size()); // Expected: 69 c4 e0 d8 6a 7b 04 30 d8 cd b7 80 70 b4 c5 5a
+    std::cout << "Last Round Key:   ";
+    printArray(schedule.encryptionKeys() + 160, 16); // Expected: 13 11 1d 7f e3 94 4a 17 f3 07 a7 8b 4d 2b 30 c5
+
+    // Multi-block round trip, in place
+    std::vector<std::uint8_t> data(1024);
+    for (std::size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = static_cast<std::uint8_t>(i * 7 + 3);
+    }
+    std::vector<std::uint8_t> original = data;
+
+    schedule.encryptBlocks(data.data(), data.data(), data.size() / 16);
+    bool matches = true;
+    for (std::size_t i = 0; i < data.size(); i += 16)
+    {
+        std::array<std::uint8_t, 16> single;
+        schedule.encryptBlock(original.data() + i, single.data());
+        matches = matches && std::equal(single.begin(), single.end(), data.begin() + i);
+    }
+    schedule.decryptBlocks(data.data(), data.data(), data.size() / 16);
+    std::cout << "Blocks Match:     " << std::boolalpha << matches << std::endl; // Expected: true
+    std::cout << "Round Trip:       " << (data == original) << std::endl;       // Expected: true
+}
+
+
+void testBackends()
+{
+    std::array<std::uint8_t, 16> key = { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+                                         0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c };
+    key_schedule reference(key.data(), Backend::Reference);
+
+    std::vector<std::uint8_t> data(4096 + 80); // not a multiple of 8 blocks
+    for (std::size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = static_cast<std::uint8_t>(i * 131 + (i >> 8));
+    }
+    std::vector<std::uint8_t> expected(data.size());
+    reference.encryptBlocks(data.data(), expected.data(), data.size() / 16);
+
+    for (Backend backend : { Backend::Table, Backend::Hardware, Backend::Bitsliced, Backend::Automatic })
+    {
+        key_schedule schedule(key.data(), backend);
+        std::vector<std::uint8_t> a(data.size());
+        schedule.encryptBlocks(data.data(), a.data(), data.size() / 16);
+        bool encrypted = a == expected;
+        schedule.decryptBlocks(a.data(), a.data(), data.size() / 16);
+        std::cout << "Backend " << static_cast<int>(backend) << " -> " << static_cast<int>(schedule.backend())
+                  << ":     " << std::boolalpha << (encrypted && a == data) << std::endl; // Expected: true (2 and 4 resolve to 3 without AES-NI)
+    }
+
+    // An encrypt-only schedule skips the inverse cipher and refuses to decrypt
+    for (Backend backend : { Backend::Table, Backend::Bitsliced, Backend::Automatic })
+    {
+        key_schedule schedule(key.data(), backend, KeyUsage::EncryptOnly);
+        std::vector<std::uint8_t> a(data.size());
+        schedule.encryptBlocks(data.data(), a.data(), data.size() / 16);
+        bool refused = false;
+        try
+        {
+            schedule.decryptBlocks(a.data(), a.data(), data.size() / 16);
+        }
+        catch (const std::runtime_error&)
+        {
+            refused = true;
+        }
+        std::cout << "Encrypt Only " << static_cast<int>(backend) << ":   " << (a == expected && refused && !schedule.decryptionKeys()) << std::endl; // Expected: true
+    }
+}
+
+
+std::vector<std::uint8_t> fromHex(const char* hex)
+{
+    std::vector<std::uint8_t> bytes;
+    for (; hex[0] && hex[1]; hex += 2)
+    {
+        bytes.push_back(static_cast<std::uint8_t>(std::stoi(std::string(hex, 2), nullptr, 16)));
+    }
+    return bytes;
+}
+
+
+void testCtr()
+{
+    // NIST SP 800-38A F.5.1
+    std::vector<std::uint8_t> key = fromHex("2b7e151628aed2a6abf7158809cf4f3c");
+    std::vector<std::uint8_t> iv = fromHex("f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff");
+    std::vector<std::uint8_t> plain = fromHex("6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51"
+                                              "30c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710");
+    key_schedule schedule(key.data());
+
+    std::vector<std::uint8_t> cipher(plain.size());
+    ctr(schedule, iv.data(), plain.data(), cipher.data(), plain.size());
+    std::cout << "CTR Block 4:      ";
+    printArray(cipher.data() + 48, 16); // Expected: 1e 03 1d da 2f be 03 d1 79 21 70 a0 f3 00 9c ee
+
+    // Random access: an unaligned slice decrypts on its own
+    std::vector<std::uint8_t> slice(21);
+    ctr(schedule, iv.data(), cipher.data() + 37, slice.data(), slice.size(), 37);
+    std::cout << "CTR Slice:        " << std::boolalpha << std::equal(slice.begin(), slice.end(), plain.begin() + 37) << std::endl; // Expected: true
+
+    // Counter carry across all 128 bits, and a multithreaded buffer against a single thread
+    std::vector<std::uint8_t> ones(16, 0xff);
+    std::vector<std::uint8_t> big((std::size_t(3) << 20) + 5);
+    for (std::size_t i = 0; i < big.size(); ++i)
+    {
+        big[i] = static_cast<std::uint8_t>(i ^ (i >> 9));
+    }
+    std::vector<std::uint8_t> serial(big.size()), threaded(big.size());
+    ctr(schedule, ones.data(), big.data(), serial.data(), big.size(), 11, 1);
+    ctr(schedule, ones.data(), big.data(), threaded.data(), big.size(), 11, 4);
+    std::cout << "CTR Threads:      " << (serial == threaded) << std::endl; // Expected: true
+
+    std::array<std::uint8_t, 16> zero{}, second;
+    schedule.encryptBlock(zero.data(), second.data()); // counter ff..ff + 1 wraps to 00..00
+    bool wraps = true;
+    for (std::size_t i = 0; i < 16; ++i)
+    {
+        wraps = wraps && (serial[5 + i] ^ big[5 + i]) == second[i]; // stream byte 16 + i sits at index 5 + i
+    }
+    std::cout << "CTR Wrap:         " << wraps << std::endl; // Expected: true
+
+    ctr(schedule, ones.data(), threaded.data(), threaded.data(), threaded.size(), 11);
+    std::cout << "CTR Round Trip:   " << (threaded == big) << std::endl; // Expected: true
+}
+
+
+void testGcm()
+{
+    // GCM specification test cases 2, 4 and 6
+    std::vector<std::uint8_t> zero(16, 0);
+    std::array<std::uint8_t, 16> tag;
+    std::vector<std::uint8_t> out(16);
+    gcm zeroKey(zero.data());
+    zeroKey.encrypt(zero.data(), 12, nullptr, 0, zero.data(), out.data(), 16, tag.data());
+    std::cout << "GCM 2 Cipher:     ";
+    printArray(out.data(), out.size()); // Expected: 03 88 da ce 60 b6 a3 92 f3 28 c2 b9 71 b2 fe 78
+    std::cout << "GCM 2 Tag:        ";
+    printArray(tag.data(), tag.size()); // Expected: ab 6e 47 d4 2c ec 13 bd f5 3a 67 b2 12 57 bd df
+
+    std::vector<std::uint8_t> key = fromHex("feffe9928665731c6d6a8f9467308308");
+    std::vector<std::uint8_t> iv = fromHex("cafebabefacedbaddecaf888");
+    std::vector<std::uint8_t> aad = fromHex("feedfacedeadbeeffeedfacedeadbeefabaddad2");
+    std::vector<std::uint8_t> plain = fromHex("d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+                                              "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39");
+    std::vector<std::uint8_t> longIv = fromHex("9313225df88406e555909c5aff5269aa6a7a9538534f7da1e4c303d2a318a728"
+                                               "c3c0c95156809539fcf0e2429a6b525416aedbf5a0de6a57a637b39b");
+
+    for (Backend backend : { Backend::Table, Backend::Bitsliced, Backend::Automatic })
+    {
+        gcm cipher(key.data(), backend);
+        std::vector<std::uint8_t> c(plain.size());
+        cipher.encrypt(iv.data(), iv.size(), aad.data(), aad.size(), plain.data(), c.data(), c.size(), tag.data());
+        std::cout << "GCM 4 Tag:        ";
+        printArray(tag.data(), tag.size()); // Expected: 5b c9 4f bc 32 21 a5 db 94 fa e9 5a e7 12 1a 47
+
+        cipher.encrypt(longIv.data(), longIv.size(), aad.data(), aad.size(), plain.data(), c.data(), c.size(), tag.data());
+        std::cout << "GCM 6 Tag:        ";
+        printArray(tag.data(), tag.size()); // Expected: 61 9c c5 ae ff fe 0b fa 46 2a f4 3c 16 99 d0 50
+    }
+
+    // Streaming in odd pieces matches one shot, and decryption rejects a flipped bit
+    std::vector<std::uint8_t> message(10000);
+    for (std::size_t i = 0; i < message.size(); ++i)
+    {
+        message[i] = static_cast<std::uint8_t>(i * 29 + 1);
+    }
+    gcm cipher(key.data());
+    std::vector<std::uint8_t> oneShot(message.size()), streamed(message.size());
+    std::array<std::uint8_t, 16> streamedTag;
+    cipher.encrypt(iv.data(), iv.size(), aad.data(), aad.size(), message.data(), oneShot.data(), message.size(), tag.data());
+
+    cipher.init(iv.data(), iv.size());
+    cipher.updateAad(aad.data(), 7);
+    cipher.updateAad(aad.data() + 7, aad.size() - 7);
+    for (std::size_t i = 0, step = 1; i < message.size(); i += step, step = step * 3 % 1021 + 1)
+    {
+        std::size_t n = std::min(step, message.size() - i);
+        cipher.encryptUpdate(message.data() + i, streamed.data() + i, n);
+    }
+    cipher.final(streamedTag.data());
+    std::cout << "GCM Streaming:    " << std::boolalpha << (oneShot == streamed && tag == streamedTag) << std::endl; // Expected: true
+
+    gcm table(key.data(), Backend::Table);
+    table.encrypt(iv.data(), iv.size(), aad.data(), aad.size(), message.data(), streamed.data(), message.size(), streamedTag.data());
+    std::cout << "GCM Table GHASH:  " << (oneShot == streamed && tag == streamedTag) << std::endl; // Expected: true
+
+    gcm sliced(key.data(), Backend::Bitsliced);
+    sliced.encrypt(iv.data(), iv.size(), aad.data(), aad.size(), message.data(), streamed.data(), message.size(), streamedTag.data());
+    std::cout << "GCM Const GHASH:  " << (sliced.hash().constantTime() && oneShot == streamed && tag == streamedTag) << std::endl; // Expected: true
+
+    // Authenticate first, then decrypt only what verify() accepted
+    streamed = oneShot;
+    cipher.init(iv.data(), iv.size());
+    cipher.updateAad(aad.data(), aad.size());
+    cipher.authenticateUpdate(streamed.data(), 4000);
+    cipher.authenticateUpdate(streamed.data() + 4000, streamed.size() - 4000);
+    bool verified = cipher.verify(tag.data());
+    cipher.decryptVerified(streamed.data() + 4000, streamed.data() + 4000, streamed.size() - 4000, 4000);
+    cipher.decryptVerified(streamed.data(), streamed.data(), 4000, 0);
+    std::cout << "GCM Verify First: " << (verified && streamed == message) << std::endl; // Expected: true
+    bool refused = false;
+    try
+    {
+        cipher.decryptVerified(streamed.data(), streamed.data(), 16, streamed.size());
+    }
+    catch (const std::runtime_error&)
+    {
+        refused = true;
+    }
+    std::cout << "GCM Unverified:   " << refused << std::endl; // Expected: true
+
+    std::vector<std::uint8_t> opened(message.size());
+    bool accepted = cipher.decrypt(iv.data(), iv.size(), aad.data(), aad.size(), oneShot.data(), opened.data(), opened.size(), tag.data());
+    std::cout << "GCM Open:         " << (accepted && opened == message) << std::endl; // Expected: true
+    oneShot[1234] ^= 0x10;
+    accepted = cipher.decrypt(iv.data(), iv.size(), aad.data(), aad.size(), oneShot.data(), opened.data(), opened.size(), tag.data());
+    std::cout << "GCM Tampered:     " << accepted << std::endl; // Expected: false
+
+    // Truncated tags: 12 bytes verify, 8 bytes are refused
+    oneShot[1234] ^= 0x10;
+    cipher.init(iv.data(), iv.size());
+    cipher.updateAad(aad.data(), aad.size());
+    cipher.decryptUpdate(oneShot.data(), opened.data(), opened.size());
+    std::cout << "GCM Tag 12 Bytes: " << cipher.verify(tag.data(), 12) << std::endl; // Expected: true
+    try
+    {
+        cipher.init(iv.data(), iv.size());
+        cipher.verify(tag.data(), 8);
+        std::cout << "GCM Tag 8 Bytes:  accepted" << std::endl;
+    }
+    catch (const std::runtime_error&)
+    {
+        std::cout << "GCM Tag 8 Bytes:  rejected" << std::endl; // Expected: rejected
+    }
+
+    // A message past 2^32 - 2 blocks would wrap the 32-bit counter; the size is checked before any data is read
+    cipher.init(iv.data(), iv.size());
+    cipher.encryptUpdate(message.data(), streamed.data(), 16);
+    try
+    {
+        cipher.encryptUpdate(message.data(), streamed.data(), static_cast<std::size_t>(gcm::MAX_DATA_SIZE - 15));
+        std::cout << "GCM Too Long:     accepted" << std::endl;
+    }
+    catch (const std::runtime_error&)
+    {
+        std::cout << "GCM Too Long:     rejected" << std::endl; // Expected: rejected
+    }
 }
 
 
+void testCbc()
+{
+    // NIST SP 800-38A F.2.1, followed by one block of PKCS#7 padding
+    std::vector<std::uint8_t> key = fromHex("2b7e151628aed2a6abf7158809cf4f3c");
+    std::vector<std::uint8_t> iv = fromHex("000102030405060708090a0b0c0d0e0f");
+    std::vector<std::uint8_t> plain = fromHex("6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51"
+                                              "30c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710");
+    key_schedule schedule(key.data());
+
+    std::vector<std::uint8_t> cipher(cbcPaddedSize(plain.size()));
+    std::size_t written = cbcEncrypt(schedule, iv.data(), plain.data(), cipher.data(), plain.size());
+    std::cout << "CBC Size:         " << written << std::endl; // Expected: 80
+    std::cout << "CBC Block 4:      ";
+    printArray(cipher.data() + 48, 16); // Expected: 3f f1 ca a1 68 1f ac 09 12 0e ca 30 75 86 e1 a7
+
+    std::vector<std::uint8_t> opened(cipher.size());
+    std::size_t length = cbcDecrypt(schedule, iv.data(), cipher.data(), opened.data(), cipher.size());
+    std::cout << "CBC Open:         " << std::boolalpha << (length == plain.size() && std::equal(plain.begin(), plain.end(), opened.begin())) << std::endl; // Expected: true
+
+    // In-place, multithreaded against a single thread on an odd length
+    std::vector<std::uint8_t> big((std::size_t(3) << 20) + 7);
+    for (std::size_t i = 0; i < big.size(); ++i)
+    {
+        big[i] = static_cast<std::uint8_t>(i * 13 + (i >> 11));
+    }
+    std::vector<std::uint8_t> buffer(cbcPaddedSize(big.size()));
+    std::copy(big.begin(), big.end(), buffer.begin());
+    written = cbcEncrypt(schedule, iv.data(), buffer.data(), buffer.data(), big.size());
+    std::vector<std::uint8_t> serial(written);
+    std::size_t serialLength = cbcDecrypt(schedule, iv.data(), buffer.data(), serial.data(), written, 1);
+    std::size_t threadedLength = cbcDecrypt(schedule, iv.data(), buffer.data(), buffer.data(), written, 4);
+    buffer.resize(threadedLength);
+    serial.resize(serialLength);
+    std::cout << "CBC Threads:      " << (buffer == big && serial == big) << std::endl; // Expected: true
+
+    cipher[79] ^= 0x01; // corrupts the padding block
+    try
+    {
+        cbcDecrypt(schedule, iv.data(), cipher.data(), opened.data(), cipher.size());
+        std::cout << "CBC Bad Padding:  accepted" << std::endl;
+    }
+    catch (const std::runtime_error& e)
+    {
+        std::cout << "CBC Bad Padding:  " << e.what() << std::endl; // Expected: Invalid CBC padding.
+    }
+}
+
+
+void testKeySizes()
+{
+    // FIPS-197 Appendix C.2 and C.3
+    std::vector<std::uint8_t> key(32);
+    std::array<std::uint8_t, 16> plain;
+    for (int i = 0; i < 32; ++i)
+    {
+        key[i] = static_cast<std::uint8_t>(i);
+    }
+    for (int i = 0; i < 16; ++i)
+    {
+        plain[i] = static_cast<std::uint8_t>(i * 0x11);
+    }
+
+    for (Backend backend : { Backend::Reference, Backend::Table, Backend::Bitsliced, Backend::Automatic })
+    {
+        key_schedule192 aes192(key.data(), backend);
+        key_schedule256 aes256(key.data(), backend);
+        std::array<std::uint8_t, 16> block, back;
+        aes192.encryptBlock(plain.data(), block.data());
+        aes192.decryptBlock(block.data(), back.data());
+        std::cout << "AES-192:          ";
+        printArray(block.data(), block.size()); // Expected: dd a9 7c a4 86 4c df e0 6e af 70 a0 ec 0d 71 91
+        bool roundTrip = back == plain;
+
+        aes256.encryptBlock(plain.data(), block.data());
+        aes256.decryptBlock(block.data(), back.data());
+        std::cout << "AES-256:          ";
+        printArray(block.data(), block.size()); // Expected: 8e a2 b7 ca 51 67 45 bf ea fc 49 90 4b 49 60 89
+        std::cout << "Key Size Trip:    " << std::boolalpha << (roundTrip && back == plain) << std::endl; // Expected: true
+    }
+
+    // GCM specification test case 14
+    std::vector<std::uint8_t> zero(32, 0), out(16);
+    std::array<std::uint8_t, 16> tag;
+    gcm256 cipher(zero.data());
+    cipher.encrypt(zero.data(), 12, nullptr, 0, zero.data(), out.data(), 16, tag.data());
+    std::cout << "GCM-256 Cipher:   ";
+    printArray(out.data(), out.size()); // Expected: ce a7 40 3d 4d 60 6b 6e 07 4e c5 d3 ba f3 9d 18
+    std::cout << "GCM-256 Tag:      ";
+    printArray(tag.data(), tag.size()); // Expected: d0 d1 c8 a7 99 99 6b f0 26 5b 98 b5 d4 8a b9 19
+}
+
+
+void testXts()
+{
+    // IEEE 1619 vectors 1 and 2, then a 17-byte sector (ciphertext stealing) checked against OpenSSL
+    std::vector<std::uint8_t> zero(32, 0), out(32);
+    xts(zero.data()).encryptSector(0, zero.data(), out.data(), 32);
+    std::cout << "XTS 1:            ";
+    printArray(out.data(), out.size()); // Expected: 91 7c f6 9e bd 68 b2 ec 9b 9f e9 a3 ea dd a6 92 cd 43 d2 f5 95 98 ed 85 8c 02 c2 65 2f bf 92 2e
+
+    std::vector<std::uint8_t> key = fromHex("1111111111111111111111111111111122222222222222222222222222222222");
+    std::vector<std::uint8_t> plain(32, 0x44);
+    xts(key.data()).encryptSector(0x3333333333, plain.data(), out.data(), 32);
+    std::cout << "XTS 2:            ";
+    printArray(out.data(), out.size()); // Expected: c4 54 18 5e 6a 16 93 6e 39 33 40 38 ac ef 83 8b fb 18 6f ff 74 80 ad c4 28 93 82 ec d6 d3 94 f0
+
+    key = fromHex("fffefdfcfbfaf9f8f7f6f5f4f3f2f1f0bfbebdbcbbbab9b8b7b6b5b4b3b2b1b0");
+    plain = fromHex("000102030405060708090a0b0c0d0e0f10");
+    xts stealing(key.data());
+    stealing.encryptSector(0x9a78563412, plain.data(), out.data(), plain.size());
+    std::cout << "XTS Stealing:     ";
+    printArray(out.data(), plain.size()); // Expected: 64 16 10 67 9d cb f9 2e 50 5c 41 33 3f b0 6c 2a 95
+    stealing.decryptSector(0x9a78563412, out.data(), out.data(), plain.size());
+    std::cout << "XTS Steal Back:   " << std::boolalpha << std::equal(plain.begin(), plain.end(), out.begin()) << std::endl; // Expected: true
+
+    // A batch of 4 KB sectors, threaded and in place, against sector-by-sector encryption
+    std::vector<std::uint8_t> disk(4096 * 300);
+    for (std::size_t i = 0; i < disk.size(); ++i)
+    {
+        disk[i] = static_cast<std::uint8_t>(i * 7 ^ (i >> 12));
+    }
+    std::vector<std::uint8_t> single(disk.size()), batched = disk;
+    for (std::size_t s = 0; s < 300; ++s)
+    {
+        stealing.encryptSector(1000 + s, disk.data() + s * 4096, single.data() + s * 4096, 4096);
+    }
+    stealing.encryptSectors(1000, batched.data(), batched.data(), 4096, 300, 4);
+    std::cout << "XTS Batch:        " << (batched == single) << std::endl; // Expected: true
+    stealing.decryptSectors(1000, batched.data(), batched.data(), 4096, 300);
+    std::cout << "XTS Batch Back:   " << (batched == disk) << std::endl; // Expected: true
+
+    // Odd sector sizes round-trip through stealing
+    bool odd = true;
+    for (std::size_t size : { 17, 31, 47, 100, 4095 })
+    {
+        std::vector<std::uint8_t> data(disk.begin(), disk.begin() + size), copy = data;
+        stealing.encryptSector(5, data.data(), data.data(), size);
+        stealing.decryptSector(5, data.data(), data.data(), size);
+        odd = odd && data == copy;
+    }
+    std::cout << "XTS Odd Sizes:    " << odd << std::endl; // Expected: true
+}
+
+
+void testFiles()
+{
+    std::vector<std::uint8_t> key = fromHex("2b7e151628aed2a6abf7158809cf4f3c");
+    std::vector<std::uint8_t> iv = fromHex("f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff");
+    key_schedule schedule(key.data());
+
+    std::vector<std::uint8_t> data((std::size_t(9) << 20) + 333); // a few file chunks and a partial block
+    for (std::size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = static_cast<std::uint8_t>(i * 5 + (i >> 13));
+    }
+    std::vector<std::uint8_t> expected(data.size());
+    ctr(schedule, iv.data(), data.data(), expected.data(), data.size());
+
+    auto path = std::filesystem::temp_directory_path() / "nstd_aes_test.bin";
+    auto writeFile = [&](const std::vector<std::uint8_t>& bytes)
+    {
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    };
+    auto readFile = [&]()
+    {
+        std::ifstream in(path, std::ios::binary);
+        return std::vector<std::uint8_t>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    };
+
+    // In place through a memory mapping
+    writeFile(data);
+    ctrFile(schedule, iv.data(), path.string());
+    std::cout << "CTR File:         " << std::boolalpha << (readFile() == expected) << std::endl; // Expected: true
+
+    gcm cipher(key.data());
+    std::array<std::uint8_t, 16> tag, fileTag;
+    std::vector<std::uint8_t> sealed(data.size());
+    cipher.encrypt(iv.data(), 12, nullptr, 0, data.data(), sealed.data(), data.size(), tag.data());
+    writeFile(data);
+    gcmEncryptFile(cipher, iv.data(), 12, nullptr, 0, path.string(), fileTag.data());
+    std::cout << "GCM File:         " << (readFile() == sealed && tag == fileTag) << std::endl; // Expected: true
+
+    fileTag[0] ^= 1;
+    bool opened = gcmDecryptFile(cipher, iv.data(), 12, nullptr, 0, path.string(), fileTag.data());
+    std::cout << "GCM File Forged:  " << opened << " " << (readFile() == sealed) << std::endl; // Expected: false true
+    opened = gcmDecryptFile(cipher, iv.data(), 12, nullptr, 0, path.string(), tag.data());
+    std::cout << "GCM File Open:    " << opened << " " << (readFile() == data) << std::endl; // Expected: true true
+    std::filesystem::remove(path);
+
+    // Through stream buffers, with small buffers so the double buffering cycles many times
+    std::stringbuf sink;
+    {
+        cipher_ostreambuf encrypting(sink, ctrTransform(schedule, iv.data()), 4096 + 5);
+        std::ostream out(&encrypting);
+        out.write(reinterpret_cast<const char*>(data.data()), 100000);
+        out << std::flush;
+        out.write(reinterpret_cast<const char*>(data.data()) + 100000, 23456);
+    }
+    std::string written = sink.str();
+    std::cout << "Stream Encrypt:   " << (written.size() == 123456 && std::equal(written.begin(), written.end(), expected.begin(),
+                  [](char a, std::uint8_t b) { return static_cast<std::uint8_t>(a) == b; })) << std::endl; // Expected: true
+
+    std::stringbuf source(written);
+    cipher_istreambuf decrypting(source, ctrTransform(schedule, iv.data()), 1000);
+    std::istream in(&decrypting);
+    std::vector<std::uint8_t> back((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::cout << "Stream Decrypt:   " << (back.size() == 123456 && std::equal(back.begin(), back.end(), data.begin())) << std::endl; // Expected: true
+
+    std::stringbuf gcmSink;
+    cipher.init(iv.data(), 12);
+    {
+        cipher_ostreambuf encrypting(gcmSink, [&cipher](std::uint8_t* p, std::size_t n) { cipher.encryptUpdate(p, p, n); }, 4096);
+        std::ostream(&encrypting).write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    }
+    cipher.final(fileTag.data());
+    std::cout << "Stream GCM:       " << (fileTag == tag && gcmSink.str().size() == data.size()) << std::endl; // Expected: true
+}
+
+
+void testDrbg()
+{
+    std::array<std::uint8_t, 48> seed;
+    for (std::size_t i = 0; i < seed.size(); ++i)
+    {
+        seed[i] = static_cast<std::uint8_t>(i);
+    }
+
+    // Deterministic output, batch by batch
+    ctr_drbg drbg(seed.data(), seed.size());
+    std::vector<std::uint8_t> bytes(2 * ctr_drbg::BUFFER_SIZE);
+    drbg.generate(bytes.data(), bytes.size());
+    std::cout << "DRBG Batch 1:     ";
+    printArray(bytes.data(), 16); // Expected: 06 15 50 23 4d 15 8c 5e c9 55 95 fe 04 ef 7a 25
+    std::cout << "DRBG Batch 2:     ";
+    printArray(bytes.data() + ctr_drbg::BUFFER_SIZE, 16); // Expected: 20 ac d3 2e 12 57 59 fa f7 63 6d b7 21 1a a9 4a
+
+    // Values, odd-sized reads and whole batches all come from the same stream
+    ctr_drbg mixed(seed.data(), seed.size());
+    std::vector<std::uint8_t> pieces(bytes.size());
+    std::uint64_t first = mixed();
+    std::memcpy(pieces.data(), &first, 8);
+    mixed.generate(pieces.data() + 8, 13);
+    mixed.generate(pieces.data() + 21, pieces.size() - 21);
+    std::cout << "DRBG Value:       " << std::hex << first << std::dec << std::endl; // Expected: 5e8c154d23501506
+    std::cout << "DRBG Pieces:      " << std::boolalpha << (pieces == bytes) << std::endl; // Expected: true
+
+    std::array<std::uint8_t, 32> entropy;
+    entropy.fill(0xff);
+    drbg.reseed(entropy.data(), entropy.size());
+    drbg.generate(bytes.data(), 16);
+    std::cout << "DRBG Reseeded:    ";
+    printArray(bytes.data(), 16); // Expected: 0d ae 3a 56 89 dd b7 84 ba 04 36 d2 91 2b 19 2a
+
+    // With <random> distributions
+    std::uniform_int_distribution<int> die(1, 6);
+    bool inRange = true;
+    for (int i = 0; i < 10000; ++i)
+    {
+        int roll = die(ctr_drbg::local());
+        inRange = inRange && roll >= 1 && roll <= 6;
+    }
+    std::cout << "DRBG Uniform:     " << inRange << std::endl; // Expected: true
+
+    // One seeded instance per thread
+    std::uint64_t here = ctr_drbg::local()();
+    std::uint64_t there = 0;
+    ctr_drbg* other = nullptr;
+    std::thread worker([&]() { other = &ctr_drbg::local(); there = (*other)(); });
+    worker.join();
+    std::cout << "DRBG Per Thread:  " << (other != &ctr_drbg::local() && here != there) << std::endl; // Expected: true
+
+#ifndef _WIN32
+    // A forked child reseeds instead of continuing the parent's buffered stream
+    int channel[2];
+    if (pipe(channel) == 0)
+    {
+        std::fflush(nullptr);
+        pid_t child = fork();
+        if (child == 0)
+        {
+            std::uint64_t value = ctr_drbg::local()();
+            ssize_t written = write(channel[1], &value, sizeof(value));
+            _exit(written == sizeof(value) ? 0 : 1);
+        }
+        std::uint64_t parent = ctr_drbg::local()();
+        std::uint64_t forked = parent;
+        ssize_t received = read(channel[0], &forked, sizeof(forked));
+        waitpid(child, nullptr, 0);
+        close(channel[0]);
+        close(channel[1]);
+        std::cout << "DRBG After Fork:  " << (received == sizeof(forked) && forked != parent) << std::endl; // Expected: true
+    }
+#endif
+}
+
+void testMultiKey()
+{
+    // 11 blocks: a full group of 8 and a partial one, lane 0 under the FIPS-197 C.1 key
+    std::vector<std::uint8_t> keys(11 * 16), blocks(11 * 16);
+    for (std::size_t i = 0; i < keys.size(); ++i)
+    {
+        keys[i] = static_cast<std::uint8_t>(i * 7 + 3);
+        blocks[i] = static_cast<std::uint8_t>(i * 13 + 1);
+    }
+    std::vector<std::uint8_t> fips = fromHex("000102030405060708090a0b0c0d0e0f");
+    std::copy(fips.begin(), fips.end(), keys.begin());
+    std::vector<std::uint8_t> plain = fromHex("00112233445566778899aabbccddeeff");
+    std::copy(plain.begin(), plain.end(), blocks.begin());
+
+    std::vector<std::uint8_t> expected(blocks.size());
+    for (std::size_t i = 0; i < 11; ++i)
+    {
+        key_schedule(keys.data() + i * 16, Backend::Table).encryptBlock(blocks.data() + i * 16, expected.data() + i * 16);
+    }
+
+    auto check = [&](const char* label, Backend first, Backend rest)
+    {
+        std::vector<key_schedule> schedules;
+        std::vector<const key_schedule*> lanes;
+        for (std::size_t i = 0; i < 11; ++i)
+        {
+            schedules.emplace_back(keys.data() + i * 16, i == 0 ? first : rest);
+        }
+        for (const key_schedule& schedule : schedules)
+        {
+            lanes.push_back(&schedule);
+        }
+
+        std::vector<std::uint8_t> data = blocks;
+        multiKeyEncrypt(lanes.data(), data.data(), data.data(), 11);
+        bool encrypted = data == expected;
+        multiKeyDecrypt(lanes.data(), data.data(), data.data(), 11);
+        std::cout << label << std::boolalpha << (encrypted && data == blocks) << std::endl;
+    };
+    check("Multi-Key Auto:   ", Backend::Automatic, Backend::Automatic);     // Expected: true
+    check("Multi-Key Slices: ", Backend::Bitsliced, Backend::Bitsliced);     // Expected: true
+    check("Multi-Key Table:  ", Backend::Table, Backend::Table);             // Expected: true
+    check("Multi-Key Mixed:  ", Backend::Reference, Backend::Automatic);     // Expected: true
+    std::cout << "Multi-Key Lane 0: ";
+    printArray(expected.data(), 16); // Expected: 69 c4 e0 d8 6a 7b 04 30 d8 cd b7 80 70 b4 c5 5a
+
+    // Least recently used eviction with room for two schedules
+    schedule_cache cache(2);
+    const std::uint8_t* a = keys.data();
+    const std::uint8_t* b = keys.data() + 16;
+    const std::uint8_t* c = keys.data() + 32;
+    for (const std::uint8_t* key : {a, b, a, c, a, b})
+    {
+        cache.get(key);
+    }
+    std::cout << "Cache Counts:     " << cache.hits() << " " << cache.misses() << " " << cache.size() << std::endl; // Expected: 2 4 2
+
+    std::array<std::uint8_t, 16> out;
+    cache.get(a).encryptBlock(plain.data(), out.data());
+    std::cout << "Cache Schedule:   ";
+    printArray(out.data(), 16); // Expected: 69 c4 e0 d8 6a 7b 04 30 d8 cd b7 80 70 b4 c5 5a
+}
+
 int main()
 {
     try
     {
         test();
+        testKeySchedule();
+        testBackends();
+        testCtr();
+        testGcm();
+        testCbc();
+        testKeySizes();
+        testXts();
+        testFiles();
+        testDrbg();
+        testMultiKey();
     }
     catch (const std::exception& e)
     {
@@ -1,4 +1,8 @@
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <limits>
 #include <ml.hpp>
 
 int main()
@@ -31,6 +35,305 @@ int main()
     std::cout << "Random Forest Prediction for {3, 2}: " << rf.predict({3, 2}) << std::endl; // Actual output: 1
     std::cout << "Random Forest Prediction for {5, 5}: " << rf.predict({5, 5}) << std::endl; // Expected: 1
 
+    std::cout << "\n=== Reproducibility Test ===" << std::endl;
+    nstd::ML::RandomForest rf_serial(10, 3, 1234, 1);   // seed 1234, 1 thread
+    nstd::ML::RandomForest rf_parallel(10, 3, 1234, 4); // seed 1234, 4 threads
+    rf_serial.fit(x_dt, y_dt);
+    rf_parallel.fit(x_dt, y_dt);
+    bool same_forest = true;
+    for (double a = 0; a <= 6; a += 0.5)
+    {
+        for (double b = 0; b <= 6; b += 0.5)
+        {
+            same_forest &= rf_serial.predict({a, b}) == rf_parallel.predict({a, b});
+        }
+    }
+    std::cout << "Same forest for 1 and 4 threads: " << same_forest << std::endl; // Expected: 1
+
+    nstd::ML::LogisticRegression log_reg_a(2, 1, 99), log_reg_b(2, 1, 99); // seed 99
+    log_reg_a.fit({{0.1}, {0.4}, {0.6}, {0.8}}, y_log, 0.01, 100);
+    log_reg_b.fit({{0.1}, {0.4}, {0.6}, {0.8}}, y_log, 0.01, 100);
+    std::cout << "Same logistic regression for the same seed: " << (log_reg_a.predict({0.5}) == log_reg_b.predict({0.5})) << std::endl; // Expected: 1
+
+    std::cout << "\n=== K-Means Test ===" << std::endl;
+    std::vector<std::vector<double>> x_km = {{1, 1}, {1.5, 2}, {1, 1.5}, {8, 8}, {8.5, 9}, {9, 8}};
+    nstd::ML::KMeans km(2, 100, 1e-4, 0, 42); // 2 clusters, seed 42
+    km.fit(x_km);
+    std::cout << "K-Means same cluster for {1, 1} and {1.2, 1.4}: " << (km.predict({1, 1}) == km.predict({1.2, 1.4})) << std::endl; // Expected: 1
+    std::cout << "K-Means same cluster for {1, 1} and {8, 9}: " << (km.predict({1, 1}) == km.predict({8, 9})) << std::endl;     // Expected: 0
+    std::cout << "K-Means inertia: " << km.inertia() << std::endl;
+
+    nstd::ML::MiniBatchKMeans mbkm(2, 4, 50, 0, 42); // 2 clusters, batches of 4, seed 42
+    mbkm.fit(nstd::ML::Matrix(x_km));
+    std::cout << "Mini-Batch K-Means same cluster for {1, 1} and {8, 9}: " << (mbkm.predict({1, 1}) == mbkm.predict({8, 9})) << std::endl; // Expected: 0
+
+    std::cout << "\n=== K-Nearest Neighbors Test ===" << std::endl;
+    nstd::ML::KNNClassifier knn(3); // 3 neighbours
+    knn.fit(x_dt, y_dt);
+    std::cout << "KNN Prediction for {1.5, 2.5}: " << knn.predict({1.5, 2.5}) << std::endl; // Expected: 0
+    std::cout << "KNN Prediction for {5, 5}: " << knn.predict({5, 5}) << std::endl;         // Expected: 1
+
+    nstd::ML::KNNClassifier knn_bf(3, nstd::ML::NeighborAlgorithm::BruteForce);
+    knn_bf.fit(x_dt, y_dt);
+    std::vector<int> knn_batch = knn_bf.predictBatch(nstd::ML::Matrix({{1.5, 2.5}, {5, 5}}));
+    std::cout << "KNN Brute-Force Batch Prediction: " << knn_batch[0] << " " << knn_batch[1] << std::endl; // Expected: 0 1
+
+    nstd::ML::KNNRegressor knn_reg(2); // 2 neighbours
+    knn_reg.fit({{1}, {2}, {3}, {4}, {5}}, y_lr);
+    std::cout << "KNN Regression Prediction for 4.4: " << knn_reg.predict({4.4}) << std::endl; // Expected: 9
+
+    nstd::ML::KNNClassifier knn_empty(3);
+    try
+    {
+        knn_empty.predict({1, 2});
+        std::cout << "KNN unfitted prediction: no error" << std::endl;
+    }
+    catch (const std::invalid_argument&)
+    {
+        std::cout << "KNN unfitted prediction: invalid_argument" << std::endl; // Expected: invalid_argument
+    }
+
+    std::cout << "\n=== PCA Test ===" << std::endl;
+    std::vector<std::vector<double>> x_pca = {{1, 2, 3}, {2, 4, 6.1}, {3, 6, 8.9}, {4, 8, 12.2}, {5, 10, 14.8}};
+    nstd::ML::PCA pca(1); // 1 component
+    pca.fit(x_pca);
+    std::vector<double> reduced = pca.transform({3, 6, 9});
+    std::cout << "PCA explained variance: " << pca.explainedVariance()[0] << std::endl; // Expected: around 34.5
+    std::cout << "PCA projection of the mean point: " << std::abs(reduced[0]) << std::endl; // Expected: close to 0
+    nstd::ML::Matrix pca_batch;
+    pca.transformInto(nstd::ML::Matrix(x_pca), pca_batch);
+    std::cout << "PCA batch shape: " << pca_batch.rows() << "x" << pca_batch.cols() << std::endl; // Expected: 5x1
+
+    std::cout << "\n=== Grid Search Test ===" << std::endl;
+    std::vector<std::vector<double>> x_cv;
+    std::vector<int> y_cv;
+    for (int i = 0; i < 60; ++i)
+    {
+        x_cv.push_back({static_cast<double>(i % 10), static_cast<double>(i % 7)});
+        y_cv.push_back(i % 10 >= 5);
+    }
+
+    std::vector<int> depths = {1, 2, 4};
+    auto grid = nstd::ML::gridSearch(x_cv, y_cv, depths, [](int depth, const nstd::ML::DataView& train, const nstd::ML::DataView& test)
+    {
+        nstd::ML::RandomForest forest(5, depth, 7);
+        forest.fit(train);
+        return nstd::ML::accuracy(forest, test);
+    }, 3, 4); // 3 folds, 4 threads
+    for (const auto& result : grid)
+    {
+        std::cout << "Random Forest depth " << result.m_params << ": accuracy " << result.m_meanScore
+                  << " +/- " << result.m_stdScore << std::endl; // Expected: 1 +/- 0
+    }
+
+    std::vector<double> cv_scores = nstd::ML::crossValidate(x_cv, y_cv, [](const nstd::ML::DataView& train, const nstd::ML::DataView& test)
+    {
+        nstd::ML::DecisionTree tree(3);
+        tree.fit(train);
+        return nstd::ML::accuracy(tree, test);
+    }, 5);
+    std::cout << "Decision Tree 5-fold scores: ";
+    for (const double score : cv_scores)
+    {
+        std::cout << score << " "; // Expected: 1 1 1 1 1
+    }
+    std::cout << std::endl;
+
+    std::cout << "\n=== Pipeline Test ===" << std::endl;
+    // Columns: income, city id, age
+    std::vector<std::vector<double>> x_raw = {{52000, 1, 23}, {61000, 2, 45}, {38000, 1, 31}, {99000, 3, 52}, {45000, 2, 19}, {87000, 3, 60}};
+    std::vector<int> y_raw = {0, 1, 0, 1, 0, 1};
+    nstd::ML::Pipeline pipeline;
+    pipeline.standardize(0).oneHot(1).bin(2, 4);
+    nstd::ML::Matrix x_ready;
+    pipeline.fitTransformInto(x_raw, x_ready);
+    std::cout << "Pipeline output columns: " << pipeline.outputSize() << std::endl; // Expected: 5
+    std::vector<double> row = pipeline.transform({61000, 2, 45});
+    std::cout << "Pipeline row: ";
+    for (const double value : row)
+    {
+        std::cout << value << " "; // Expected: ~-0.12 0 1 0 2
+    }
+    std::cout << std::endl;
+
+    nstd::ML::LogisticRegression log_reg_pipeline(2, static_cast<int>(pipeline.outputSize()));
+    log_reg_pipeline.fit(x_ready, y_raw, 0.1, 500);
+    std::cout << "Pipeline + Logistic Regression Prediction for {95000, 3, 55}: " << log_reg_pipeline.predictClass(pipeline.transform({95000, 3, 55})) << std::endl; // Expected: 1
+
+    std::cout << "\n=== Naive Bayes Test ===" << std::endl;
+    std::vector<std::vector<double>> x_gnb = {{1.0, 2.1}, {1.2, 1.9}, {0.8, 2.0}, {5.0, 6.2}, {5.3, 5.8}, {4.9, 6.1}};
+    std::vector<int> y_gnb = {0, 0, 0, 1, 1, 1};
+    nstd::ML::GaussianNaiveBayes gnb(1e-9, 2);
+    gnb.fit(x_gnb, y_gnb);
+    std::cout << "Gaussian Naive Bayes Prediction for {1.1, 2.0}: " << gnb.predict({1.1, 2.0}) << std::endl; // Expected: 0
+    std::cout << "Gaussian Naive Bayes P(1 | {5, 6}): " << gnb.predictProba({5, 6})[1] << std::endl; // Expected: ~1
+    std::vector<int> gnb_batch = gnb.predictBatch(nstd::ML::Matrix(x_gnb));
+    std::cout << "Gaussian Naive Bayes batch: ";
+    for (const int label : gnb_batch)
+    {
+        std::cout << label << " "; // Expected: 0 0 0 1 1 1
+    }
+    std::cout << std::endl;
+
+    // Word counts for {"ball", "goal", "vote", "law"}
+    std::vector<std::vector<double>> x_mnb = {{3, 2, 0, 0}, {2, 3, 1, 0}, {0, 0, 3, 2}, {0, 1, 2, 3}};
+    std::vector<int> y_mnb = {0, 0, 1, 1}; // 0: sports, 1: politics
+    nstd::ML::MultinomialNaiveBayes mnb;
+    mnb.fit(x_mnb, y_mnb);
+    std::cout << "Multinomial Naive Bayes Prediction for {1, 2, 0, 0}: " << mnb.predict({1, 2, 0, 0}) << std::endl; // Expected: 0
+    std::cout << "Multinomial Naive Bayes Prediction for {0, 0, 1, 4}: " << mnb.predict({0, 0, 1, 4}) << std::endl; // Expected: 1
+
+    std::cout << "\n=== Fast Math Test ===" << std::endl;
+    double exp_high = 0.0, exp_fast = 0.0, log_high = 0.0, log_fast = 0.0;
+    for (double x = -708.0; x <= 709.0; x += 0.0137)
+    {
+        double exact = std::exp(x);
+        exp_high = std::max(exp_high, std::abs(nstd::ML::approxExp<nstd::ML::MathPrecision::High>(x) - exact) / exact);
+        exp_fast = std::max(exp_fast, std::abs(nstd::ML::approxExp<nstd::ML::MathPrecision::Fast>(x) - exact) / exact);
+    }
+    double exp_underflow = 0.0;
+    for (double x = -1000.0; x < -708.0; x += 0.0137)
+    {
+        // Below e^-708 the results are subnormal or zero, so measure the absolute error
+        exp_underflow = std::max(exp_underflow, std::abs(nstd::ML::approxExp<nstd::ML::MathPrecision::High>(x) - std::exp(x)));
+        exp_underflow = std::max(exp_underflow, std::abs(nstd::ML::approxExp<nstd::ML::MathPrecision::Fast>(x) - std::exp(x)));
+    }
+    for (double x = 1e-300; x < 1e300; x *= 1.0137)
+    {
+        double exact = std::log2(x), scale = std::max(1.0, std::abs(exact));
+        log_high = std::max(log_high, std::abs(nstd::ML::approxLog2<nstd::ML::MathPrecision::High>(x) - exact) / scale);
+        log_fast = std::max(log_fast, std::abs(nstd::ML::approxLog2<nstd::ML::MathPrecision::Fast>(x) - exact) / scale);
+    }
+    std::cout << "High exp relative error < 1e-14: " << (exp_high < 1e-14) << std::endl; // Expected: 1
+    std::cout << "Fast exp relative error < 2e-7: " << (exp_fast < 2e-7) << std::endl; // Expected: 1
+    std::cout << "Exp below -708 error <= e^-708: " << (exp_underflow <= std::exp(-708.0)) << std::endl; // Expected: 1
+    std::cout << "Exp of -1000: " << nstd::ML::approxExp<nstd::ML::MathPrecision::High>(-1000.0) << std::endl; // Expected: 0
+    std::cout << "High log2 error < 1e-15: " << (log_high < 1e-15) << std::endl; // Expected: 1
+    std::cout << "Fast log2 error < 1e-7: " << (log_fast < 1e-7) << std::endl; // Expected: 1
+
+    std::size_t class_counts[3] = {5, 0, 15};
+    std::cout << "Entropy of {5, 0, 15}: " << nstd::ML::classEntropy(class_counts, 3, 20, nstd::ML::MathPrecision::Fast) << std::endl; // Expected: ~0.811278
+    std::size_t pure_counts[2] = {13, 0};
+    std::cout << "Entropy of {13, 0}: " << nstd::ML::classEntropy(pure_counts, 2, 13) << std::endl; // Expected: 0
+
+    std::vector<std::vector<double>> separable_x;
+    std::vector<int> separable_y;
+    for (int i = 0; i < 26; ++i)
+    {
+        separable_x.push_back({static_cast<double>(i), static_cast<double>((i * 7) % 26)});
+        separable_y.push_back(i < 13 ? 0 : 1);
+    }
+    nstd::ML::DecisionTree separable(5);
+    separable.fit(separable_x, separable_y);
+    std::cout << "Separable tree nodes: " << separable.nodeCount() << std::endl; // Expected: 3
+
+    std::cout << "\n=== Hoeffding Tree Test ===" << std::endl;
+    nstd::ML::HoeffdingTree stream_tree(2, 2, 1e-5, 100);
+    nstd::ML::Engine stream(42);
+    std::uniform_real_distribution<> coordinate(0.0, 10.0);
+    for (int i = 0; i < 20000; ++i)
+    {
+        std::vector<double> event = {coordinate(stream), coordinate(stream)};
+        stream_tree.partialFit(event, event[0] > 6.0 ? 1 : 0);
+    }
+    std::cout << "Hoeffding Tree Prediction for {8, 1}: " << stream_tree.predict({8, 1}) << std::endl; // Expected: 1
+    std::cout << "Hoeffding Tree Prediction for {2, 9}: " << stream_tree.predict({2, 9}) << std::endl; // Expected: 0
+    std::cout << "Hoeffding Tree grew: " << (stream_tree.nodeCount() > 1) << std::endl; // Expected: 1
+
+    std::cout << "\n=== Code Generation Test ===" << std::endl;
+    nstd::ML::DecisionTree stump(1);
+    stump.fit({{1, 0}, {2, 0}, {3, 0}, {7, 0}, {8, 0}, {9, 0}}, {0, 0, 0, 1, 1, 1});
+    std::cout << nstd::ML::generateCode(stump, "predictStump");
+    // Expected:
+    // inline int predictStump(const double* x) noexcept
+    // {
+    //     if (x[0] <= 3)
+    //     ...
+    std::string forest_code = nstd::ML::generateCode(rf, "predictForest", nstd::ML::CodeStyle::Bitmask);
+    std::cout << "Generated forest uses leaf bitmasks: " << (forest_code.find("leaves &=") != std::string::npos) << std::endl; // Expected: 1
+    nstd::ML::DecisionTree infinite_stump(1);
+    infinite_stump.fit({{-std::numeric_limits<double>::infinity()}, {5}, {6}}, {0, 1, 1});
+    std::string infinite_code = nstd::ML::generateCode(infinite_stump, "predictInfinite");
+    std::cout << "Generated infinite threshold: " << (infinite_code.find("x[0] <= -std::numeric_limits<double>::infinity()") != std::string::npos) << std::endl; // Expected: 1
+    bool nan_rejected = false;
+    try
+    {
+        nstd::ML::formatDouble(std::numeric_limits<double>::quiet_NaN());
+    }
+    catch (const std::invalid_argument&)
+    {
+        nan_rejected = true;
+    }
+    std::cout << "NaN threshold rejected: " << nan_rejected << std::endl; // Expected: 1
+
+    std::cout << "\n=== Training Observer Test ===" << std::endl;
+    std::size_t epochs_seen = 0, trees_seen = 0;
+    double first_loss = 0.0, last_loss = 0.0;
+    nstd::ML::CallbackObserver observer([&](const nstd::ML::TrainingEvent& event)
+    {
+        if (event.m_stage == nstd::ML::TrainingStage::Epoch)
+        {
+            (epochs_seen++ == 0 ? first_loss : last_loss) = event.m_loss;
+        }
+        else if (event.m_stage == nstd::ML::TrainingStage::Tree)
+        {
+            trees_seen += event.m_nodes > 0;
+        }
+    });
+    nstd::ML::LogisticRegression log_reg_observed(2, 1);
+    log_reg_observed.setObserver(&observer);
+    log_reg_observed.fit({{0.1}, {0.4}, {0.6}, {0.8}}, y_log, 0.1, 50);
+    std::cout << "Observed epochs: " << epochs_seen << std::endl; // Expected: 50
+    std::cout << "Loss decreased: " << (last_loss < first_loss) << std::endl; // Expected: 1
+    nstd::ML::RandomForest rf_observed(8, 3, 1234, 4);
+    rf_observed.setObserver(&observer);
+    rf_observed.fit(x_dt, y_dt);
+    std::cout << "Observed trees: " << trees_seen << std::endl; // Expected: 8
+
+    std::cout << "\n=== Out-of-Core Test ===" << std::endl;
+    std::string csv_path = (std::filesystem::temp_directory_path() / "nstd_ml_test.csv").string();
+    std::string column_path = (std::filesystem::temp_directory_path() / "nstd_ml_test.col").string();
+    {
+        std::ofstream csv(csv_path);
+        csv << "x0,x1,label\n";
+        for (int i = 0; i < 1000; ++i)
+        {
+            double a = (i % 100) / 10.0, b = (i * 37 % 100) / 10.0;
+            csv << a << "," << b << "," << (a + b > 10.0 ? 1 : 0) << "\n";
+        }
+    }
+    std::cout << "Converted rows: " << nstd::ML::convertCsv(csv_path, column_path) << std::endl; // Expected: 1000
+    {
+        nstd::ML::MappedDataset dataset(column_path);
+        nstd::ML::HistogramTree hist_tree(6, 32, 128); // 128-row chunks
+        hist_tree.fit(dataset);
+        std::cout << "Histogram Tree Prediction for {9, 8}: " << hist_tree.predict({9, 8}) << std::endl; // Expected: 1
+        std::cout << "Histogram Tree Prediction for {1, 2}: " << hist_tree.predict({1, 2}) << std::endl; // Expected: 0
+
+        nstd::ML::LogisticRegression log_reg_mapped(2, 2);
+        log_reg_mapped.fit(dataset, 0.5, 50, 32, 128);
+        std::cout << "Mapped Logistic Regression Prediction for {9, 8}: " << log_reg_mapped.predictClass({9, 8}) << std::endl; // Expected: 1
+    }
+
+    {
+        // A header whose rows * row size wraps around to zero
+        std::ofstream bad(column_path, std::ios::binary);
+        std::uint64_t header[8] = { 0, std::uint64_t(1) << 62, 1 };
+        std::memcpy(header, nstd::ML::COLUMN_FILE_MAGIC, 8);
+        bad.write(reinterpret_cast<const char*>(header), sizeof(header));
+    }
+    try
+    {
+        nstd::ML::MappedDataset bad_dataset(column_path);
+        std::cout << "Malformed column file: accepted" << std::endl;
+    }
+    catch (const std::runtime_error&)
+    {
+        std::cout << "Malformed column file: rejected" << std::endl; // Expected: rejected
+    }
+    std::filesystem::remove(csv_path);
+    std::filesystem::remove(column_path);
+
     // NeuralNetwork don't print out anything (???)
 
     // std::cout << "\n=== Neural Network Test ===" << std::endl;
@@ -0,0 +1,417 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <ml.hpp>
+
+#ifdef _WIN32
+#define PSAPI_VERSION 2
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete" // The replacements below pair malloc with free
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+static std::atomic<std::size_t> g_allocations{0};     // Number of operator new calls since the last reset.
+static std::atomic<std::size_t> g_allocatedBytes{0};  // Bytes requested since the last reset.
+
+void* operator new(std::size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+/**
+ * @brief Returns the peak resident set size of the process in megabytes.
+ */
+double peakRssMB()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+    return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+#else
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+    return usage.ru_maxrss / 1024.0;
+#endif
+#endif
+}
+
+/**
+ * @brief Generates gaussian blobs around random centers.
+ */
+nstd::ML::Matrix makeBlobs(std::size_t rows, std::size_t cols, int centers, std::uint64_t seed)
+{
+    std::mt19937_64 gen(seed);
+    std::uniform_real_distribution<double> center_dist(-10.0, 10.0);
+    std::normal_distribution<double> noise(0.0, 1.0);
+
+    nstd::ML::Matrix means(centers, cols);
+    for (std::size_t i = 0; i < means.rows() * cols; ++i)
+    {
+        means.data()[i] = center_dist(gen);
+    }
+
+    nstd::ML::Matrix x(rows, cols);
+    for (std::size_t i = 0; i < rows; ++i)
+    {
+        const double* mean = means.row(i % centers);
+        for (std::size_t j = 0; j < cols; ++j)
+        {
+            x(i, j) = mean[j] + noise(gen);
+        }
+    }
+    return x;
+}
+
+/**
+ * @brief Plain single-threaded Lloyd iterations, the baseline KMeans is measured against.
+ */
+double naiveLloyd(const nstd::ML::Matrix& x, int k, int iterations, std::uint64_t seed)
+{
+    nstd::ML::Engine gen = nstd::ML::makeEngine(seed);
+    nstd::ML::Matrix centers = nstd::ML::kmeansPlusPlus(x, k, gen, 1);
+    std::vector<int> assign(x.rows());
+
+    for (int iteration = 0; iteration < iterations; ++iteration)
+    {
+        for (std::size_t i = 0; i < x.rows(); ++i)
+        {
+            double best = std::numeric_limits<double>::max();
+            for (int c = 0; c < k; ++c)
+            {
+                double dist = nstd::ML::squaredDistance(x.row(i), centers.row(c), x.cols());
+                if (dist < best)
+                {
+                    best = dist;
+                    assign[i] = c;
+                }
+            }
+        }
+
+        nstd::ML::Matrix sums(k, x.cols());
+        std::vector<std::size_t> counts(k);
+        for (std::size_t i = 0; i < x.rows(); ++i)
+        {
+            for (std::size_t j = 0; j < x.cols(); ++j)
+            {
+                sums(assign[i], j) += x(i, j);
+            }
+            counts[assign[i]]++;
+        }
+
+        for (int c = 0; c < k; ++c)
+        {
+            for (std::size_t j = 0; counts[c] && j < x.cols(); ++j)
+            {
+                centers(c, j) = sums(c, j) / counts[c];
+            }
+        }
+    }
+
+    double inertia = 0.0;
+    for (std::size_t i = 0; i < x.rows(); ++i)
+    {
+        inertia += nstd::ML::squaredDistance(x.row(i), centers.row(assign[i]), x.cols());
+    }
+    return inertia;
+}
+
+double seconds(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void benchmarkKMeans(std::size_t rows, std::size_t cols, int k)
+{
+    std::cout << "=== K-Means: " << rows << " rows, " << cols << " features, k = " << k << " ===" << std::endl;
+    nstd::ML::Matrix x = makeBlobs(rows, cols, k, 1);
+
+    nstd::ML::KMeans km(k, 100, 1e-4, 0, 7);
+    Clock::time_point start = Clock::now();
+    km.fit(x);
+    double km_time = seconds(start);
+
+    start = Clock::now();
+    double lloyd_inertia = naiveLloyd(x, k, km.iterations(), 7);
+    double lloyd_time = seconds(start);
+
+    nstd::ML::MiniBatchKMeans mbkm(k, 1024, 100, 0, 7);
+    start = Clock::now();
+    mbkm.fit(x);
+    double mbkm_time = seconds(start);
+
+    std::cout << "Naive Lloyd:       " << lloyd_time << " s, inertia " << lloyd_inertia << std::endl;
+    std::cout << "KMeans (Hamerly):  " << km_time << " s, inertia " << km.inertia()
+              << ", " << km.iterations() << " iterations" << std::endl;
+    std::cout << "MiniBatchKMeans:   " << mbkm_time << " s" << std::endl;
+    std::cout << "Speedup:           " << lloyd_time / km_time << "x" << std::endl;
+}
+
+void benchmarkKNN(std::size_t rows, std::size_t cols, std::size_t queries, int k)
+{
+    std::cout << "=== KNN: " << rows << " rows, " << cols << " features, " << queries << " queries, k = " << k << " ===" << std::endl;
+    nstd::ML::Matrix x = makeBlobs(rows, cols, 8, 2);
+    nstd::ML::Matrix q = makeBlobs(queries, cols, 8, 3);
+    std::vector<int> y(rows);
+    for (std::size_t i = 0; i < rows; ++i)
+    {
+        y[i] = static_cast<int>(i % 8);
+    }
+
+    for (nstd::ML::NeighborAlgorithm algorithm : {nstd::ML::NeighborAlgorithm::BruteForce, nstd::ML::NeighborAlgorithm::KDTree})
+    {
+        nstd::ML::KNNClassifier knn(k, algorithm);
+        Clock::time_point start = Clock::now();
+        knn.fit(x, y);
+        double fit_time = seconds(start);
+
+        start = Clock::now();
+        std::vector<int> labels = knn.predictBatch(q);
+        double query_time = seconds(start);
+
+        std::cout << (algorithm == nstd::ML::NeighborAlgorithm::KDTree ? "KD-tree:     " : "Brute force: ")
+                  << "fit " << fit_time << " s, " << queries / query_time << " queries/s" << std::endl;
+    }
+}
+
+/**
+ * @brief Benchmark configuration, set from --name=value arguments.
+ */
+struct Options
+{
+    std::size_t rows = 1000;
+    std::size_t features = 8;
+    int classes = 3;
+    int trees = 10;
+    int depth = 6;
+    int epochs = 20;
+    std::uint64_t seed = 1;
+    bool clustering = true;
+};
+
+/**
+ * @brief Time and allocations spent in one benchmarked stage.
+ */
+struct Measurement
+{
+    double seconds;
+    std::size_t allocations;
+    std::size_t bytes;
+};
+
+template <typename Func>
+Measurement measure(Func&& func)
+{
+    g_allocations = 0;
+    g_allocatedBytes = 0;
+    Clock::time_point start = Clock::now();
+    func();
+    return { seconds(start), g_allocations.load(), g_allocatedBytes.load() };
+}
+
+/**
+ * @brief Generates a classification data set with one gaussian blob per class.
+ */
+void makeClassification(const Options& options, std::vector<std::vector<double>>& x, std::vector<int>& y)
+{
+    nstd::ML::Matrix blobs = makeBlobs(options.rows, options.features, options.classes, options.seed);
+    x.assign(options.rows, std::vector<double>(options.features));
+    y.resize(options.rows);
+    for (std::size_t i = 0; i < options.rows; ++i)
+    {
+        std::copy(blobs.row(i), blobs.row(i) + options.features, x[i].begin());
+        y[i] = static_cast<int>(i % options.classes); // makeBlobs cycles through the centers
+    }
+}
+
+void printHeader()
+{
+    std::cout << std::left << std::setw(20) << "Model"
+              << std::right << std::setw(12) << "Fit (s)"
+              << std::setw(14) << "Fit allocs"
+              << std::setw(12) << "Fit MB"
+              << std::setw(16) << "Predict rows/s"
+              << std::setw(14) << "Allocs/row"
+              << std::setw(10) << "Accuracy"
+              << std::setw(16) << "Peak RSS (MB)" << std::endl;
+}
+
+void printRow(const std::string& name, const Measurement& fit, const Measurement& predict, std::size_t rows, double accuracy)
+{
+    std::cout << std::left << std::setw(20) << name << std::right << std::fixed
+              << std::setw(12) << std::setprecision(4) << fit.seconds
+              << std::setw(14) << fit.allocations
+              << std::setw(12) << std::setprecision(2) << fit.bytes / (1024.0 * 1024.0)
+              << std::setw(16) << std::setprecision(0) << rows / predict.seconds
+              << std::setw(14) << std::setprecision(2) << static_cast<double>(predict.allocations) / rows;
+    if (accuracy >= 0.0)
+    {
+        std::cout << std::setw(10) << std::setprecision(3) << accuracy;
+    }
+    else
+    {
+        std::cout << std::setw(10) << "-";
+    }
+    std::cout << std::setw(16) << std::setprecision(1) << peakRssMB() << std::defaultfloat << std::endl;
+}
+
+/**
+ * @brief Benchmarks a classifier taking rows of features and integer labels.
+ */
+template <typename Model, typename Fit, typename Predict>
+void benchmarkClassifier(const std::string& name, Model& model, const std::vector<std::vector<double>>& x,
+                         const std::vector<int>& y, Fit&& fit, Predict&& predict)
+{
+    Measurement fit_time = measure([&]() { fit(model); });
+
+    std::size_t correct = 0;
+    Measurement predict_time = measure([&]()
+    {
+        for (std::size_t i = 0; i < x.size(); ++i)
+        {
+            correct += predict(model, x[i]) == y[i];
+        }
+    });
+
+    printRow(name, fit_time, predict_time, x.size(), static_cast<double>(correct) / x.size());
+}
+
+void benchmarkModels(const Options& options)
+{
+    std::cout << "=== Models: " << options.rows << " rows, " << options.features << " features, "
+              << options.classes << " classes ===" << std::endl;
+
+    std::vector<std::vector<double>> x;
+    std::vector<int> y;
+    makeClassification(options, x, y);
+    printHeader();
+
+    {
+        std::vector<double> feature(x.size()), target(x.size());
+        for (std::size_t i = 0; i < x.size(); ++i)
+        {
+            feature[i] = x[i][0];
+            target[i] = 3.0 * x[i][0] + y[i];
+        }
+
+        nstd::ML::LinearRegression model(0.01);
+        Measurement fit_time = measure([&]() { model.fit(feature, target); });
+        volatile double sink = 0.0; // Keeps the predictions from being optimized away
+        Measurement predict_time = measure([&]()
+        {
+            for (double value : feature)
+            {
+                sink = model.predict(value);
+            }
+        });
+        printRow("LinearRegression", fit_time, predict_time, feature.size(), -1.0);
+    }
+
+    nstd::ML::LogisticRegression logistic(options.classes, static_cast<int>(options.features), options.seed);
+    benchmarkClassifier("LogisticRegression", logistic, x, y,
+                        [&](auto& model) { model.fit(x, y, 0.01, options.epochs); },
+                        [](const auto& model, const std::vector<double>& row) { return model.predictClass(row); });
+
+    nstd::ML::DecisionTree tree(options.depth);
+    benchmarkClassifier("DecisionTree", tree, x, y,
+                        [&](auto& model) { model.fit(x, y); },
+                        [](const auto& model, const std::vector<double>& row) { return model.predict(row); });
+
+    nstd::ML::HistogramTree histogram_tree(options.depth);
+    benchmarkClassifier("HistogramTree", histogram_tree, x, y,
+                        [&](auto& model) { model.fit(x, y); },
+                        [](const auto& model, const std::vector<double>& row) { return model.predict(row); });
+
+    nstd::ML::GaussianNaiveBayes naive_bayes;
+    benchmarkClassifier("GaussianNaiveBayes", naive_bayes, x, y,
+                        [&](auto& model) { model.fit(x, y); },
+                        [](const auto& model, const std::vector<double>& row) { return model.predict(row); });
+
+    nstd::ML::HoeffdingTree hoeffding_tree(options.classes, static_cast<int>(options.features));
+    benchmarkClassifier("HoeffdingTree", hoeffding_tree, x, y,
+                        [&](auto& model) { model.fit(x, y); },
+                        [](const auto& model, const std::vector<double>& row) { return model.predict(row); });
+
+    nstd::ML::RandomForest forest(options.trees, options.depth, options.seed, 0);
+    benchmarkClassifier("RandomForest", forest, x, y,
+                        [&](auto& model) { model.fit(x, y); },
+                        [](const auto& model, const std::vector<double>& row) { return model.predict(row); });
+}
+
+/**
+ * @brief Parses --name=value arguments into the options.
+ * 
+ * @return false if an argument is not recognized.
+ */
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        std::size_t eq = arg.find('=');
+        std::string name = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+
+        if (name == "--rows") options.rows = std::stoull(value);
+        else if (name == "--features") options.features = std::stoull(value);
+        else if (name == "--classes") options.classes = std::stoi(value);
+        else if (name == "--trees") options.trees = std::stoi(value);
+        else if (name == "--depth") options.depth = std::stoi(value);
+        else if (name == "--epochs") options.epochs = std::stoi(value);
+        else if (name == "--seed") options.seed = std::stoull(value);
+        else if (name == "--no-clustering") options.clustering = false;
+        else return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        std::cerr << "Usage: " << argv[0] << " [--rows=N] [--features=N] [--classes=N] [--trees=N] [--depth=N]"
+                  << " [--epochs=N] [--seed=N] [--no-clustering]" << std::endl;
+        return 1;
+    }
+
+    benchmarkModels(options);
+
+    if (options.clustering)
+    {
+        benchmarkKMeans(200000, 16, 32);
+        benchmarkKNN(100000, 8, 10000, 10);
+        benchmarkKNN(100000, 64, 2000, 10);
+    }
+
+    return 0;
+}